@@ -0,0 +1,223 @@
+"""Benchmark the pure Python and C implementations.
+
+Run from the repository root, for example
+
+  python3 benchmarks/benchmark.py --json benchmark.json
+
+Each benchmark reports the time per operation, the peak number of
+bytes allocated by one operation and the number of memory blocks still
+allocated after an operation, which should be zero.
+
+"""
+
+import argparse
+import json
+import platform
+import sys
+import time
+import timeit
+import tracemalloc
+
+import bitstruct
+
+try:
+    import bitstruct.c
+except ImportError:
+    bitstruct.c = None
+
+
+FORMATS = [
+    (
+        'aligned',
+        'u8u16u32s16s64f32f64',
+        (1, 0x1234, 0x56789abc, -2, -3, 1.5, -2.5),
+        '1242848'
+    ),
+    (
+        'unaligned',
+        'u3s13u7u21s11u9f32u2',
+        (5, -100, 100, 123456, -500, 300, 1.5, 2),
+        '222222'
+    ),
+    (
+        'wide',
+        'p3u64s63u57f64',
+        (0x123456789abcdef0, -0x123456789abcdef, 0x123456789abcd, 0.5),
+        '8888'
+    ),
+    (
+        'text-raw',
+        'u8t64r128u8',
+        (1, 'bitstrct', 16 * b'\xa5', 2),
+        '18881'
+    ),
+    (
+        'many-fields',
+        ''.join('u{}'.format(1 + i % 12) for i in range(40)),
+        tuple(i % 2 for i in range(40)),
+        15 * '2' + '1'
+    )
+]
+
+
+def create_operations(module, fmt, values, byteswap_fmt):
+    names = ['f{}'.format(i) for i in range(len(values))]
+    data = dict(zip(names, values))
+    packed = bitstruct.pack(fmt, *values)
+    buf = bytearray(len(packed) + 1)
+    compiled = module.compile(fmt)
+    compiled_dict = module.compile(fmt, names)
+
+    return [
+        ('pack', lambda: module.pack(fmt, *values)),
+        ('unpack', lambda: module.unpack(fmt, packed)),
+        ('pack_into', lambda: module.pack_into(fmt, buf, 5, *values)),
+        ('unpack_from', lambda: module.unpack_from(fmt, buf, 5)),
+        ('pack_dict', lambda: module.pack_dict(fmt, names, data)),
+        ('unpack_dict', lambda: module.unpack_dict(fmt, names, packed)),
+        ('compiled_pack', lambda: compiled.pack(*values)),
+        ('compiled_unpack', lambda: compiled.unpack(packed)),
+        ('compiled_pack_dict', lambda: compiled_dict.pack(data)),
+        ('compiled_unpack_dict', lambda: compiled_dict.unpack(packed)),
+        ('byteswap', lambda: module.byteswap(byteswap_fmt, packed))
+    ]
+
+
+def measure_time(function, repeat):
+    timer = timeit.Timer(function)
+    number, _ = timer.autorange()
+
+    return min(timer.repeat(repeat, number)) / number
+
+
+def count_new_blocks(function):
+    iterations = range(100)
+    number_of_blocks = sys.getallocatedblocks()
+
+    for _ in iterations:
+        function()
+
+    return sys.getallocatedblocks() - number_of_blocks
+
+
+def measure_memory(function):
+    # Warm up caches before measuring.
+    function()
+    function()
+    tracemalloc.start()
+
+    try:
+        tracemalloc.reset_peak()
+        before, _ = tracemalloc.get_traced_memory()
+        function()
+        _, peak = tracemalloc.get_traced_memory()
+    finally:
+        tracemalloc.stop()
+
+    # Subtract blocks allocated by the measurement itself.
+    leaked_blocks = (count_new_blocks(function)
+                     - count_new_blocks(lambda: None)) / 100
+
+    return peak - before, leaked_blocks
+
+
+def run(implementations, pattern, repeat):
+    results = []
+
+    for format_name, fmt, values, byteswap_fmt in FORMATS:
+        for implementation, module in implementations:
+            for name, function in create_operations(module,
+                                                    fmt,
+                                                    values,
+                                                    byteswap_fmt):
+                benchmark_name = '{}/{}'.format(format_name, name)
+
+                if pattern not in benchmark_name:
+                    continue
+
+                try:
+                    function()
+                except NotImplementedError:
+                    continue
+
+                time_per_operation = measure_time(function, repeat)
+                peak_bytes, leaked_blocks = measure_memory(function)
+                result = {
+                    'benchmark': benchmark_name,
+                    'implementation': implementation,
+                    'format': fmt,
+                    'ns_per_op': round(1e9 * time_per_operation, 1),
+                    'peak_bytes': peak_bytes,
+                    'leaked_blocks': leaked_blocks
+                }
+                results.append(result)
+                print('{:36} {:6} {:10.1f} {:10} {:8.2f}'.format(
+                    result['benchmark'],
+                    result['implementation'],
+                    result['ns_per_op'],
+                    result['peak_bytes'],
+                    result['leaked_blocks']))
+                sys.stdout.flush()
+
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('-f', '--filter',
+                        default='',
+                        help='Only run benchmarks with given substring.')
+    parser.add_argument('-r', '--repeat',
+                        type=int,
+                        default=5,
+                        help='Number of timing repetitions (default: 5).')
+    parser.add_argument('-i', '--implementation',
+                        choices=('all', 'python', 'c'),
+                        default='all',
+                        help='Implementation to benchmark (default: all).')
+    parser.add_argument('--isa',
+                        help=('Instruction set of the C extension kernels '
+                              '(default: best supported).'))
+    parser.add_argument('--json',
+                        help='Also write the results as JSON to given file.')
+    args = parser.parse_args()
+
+    implementations = []
+
+    if args.implementation in ['all', 'python']:
+        implementations.append(('python', bitstruct))
+
+    if args.implementation in ['all', 'c']:
+        if bitstruct.c is None:
+            print('The C extension is not available.')
+        else:
+            if args.isa is not None:
+                bitstruct.c.set_isa(args.isa)
+
+            implementations.append(('c', bitstruct.c))
+
+    print('{:36} {:6} {:>10} {:>10} {:>8}'.format('Benchmark',
+                                                  'Impl',
+                                                  'ns/op',
+                                                  'Peak B',
+                                                  'Leaked'))
+    results = run(implementations, args.filter, args.repeat)
+
+    if args.json:
+        report = {
+            'bitstruct_version': bitstruct.__version__,
+            'python_version': platform.python_version(),
+            'python_implementation': platform.python_implementation(),
+            'machine': platform.machine(),
+            'isa': None if bitstruct.c is None else bitstruct.c.get_isa(),
+            'time': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+            'results': results
+        }
+
+        with open(args.json, 'w') as fout:
+            json.dump(report, fout, indent=2)
+            fout.write('\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,147 @@
+/**
+ * Measures bitstream_reader_read_bytes() and
+ * bitstream_writer_write_bytes() throughput in GB/s at bit offsets 0
+ * (aligned) and 3 (unaligned) for each instruction set supported by
+ * the CPU, compared to the previous byte by byte shift loop used for
+ * unaligned copies.
+ *
+ * Build and run with
+ *
+ *   gcc -O2 -I src/bitstruct benchmarks/bitstream_bytes.c \
+ *       src/bitstruct/bitstream.c -o bitstream_bytes
+ *   ./bitstream_bytes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bitstream.h"
+
+#define MAXIMUM_SIZE 65536
+#define TOTAL_SIZE (1 << 28)
+
+static uint8_t src[MAXIMUM_SIZE + 1];
+static uint8_t dst[MAXIMUM_SIZE + 1];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void read_bytes_loop(struct bitstream_reader_t *self_p,
+                            uint8_t *buf_p,
+                            int length)
+{
+    int i;
+    const uint8_t *src_p;
+
+    src_p = &self_p->buf_p[self_p->byte_offset];
+
+    for (i = 0; i < length; i++) {
+        buf_p[i] = (src_p[i] << self_p->bit_offset);
+        buf_p[i] |= (src_p[i + 1] >> (8 - self_p->bit_offset));
+    }
+
+    self_p->byte_offset += length;
+}
+
+static void write_bytes_loop(struct bitstream_writer_t *self_p,
+                             const uint8_t *buf_p,
+                             int length)
+{
+    int i;
+    uint8_t *dst_p;
+
+    dst_p = &self_p->buf_p[self_p->byte_offset];
+
+    for (i = 0; i < length; i++) {
+        dst_p[i] |= (buf_p[i] >> self_p->bit_offset);
+        dst_p[i + 1] = (uint8_t)(buf_p[i] << (8 - self_p->bit_offset));
+    }
+
+    self_p->byte_offset += length;
+}
+
+static double read_gbps(int size, int offset, int loop)
+{
+    struct bitstream_reader_t reader;
+    double start;
+    int i;
+
+    start = now();
+
+    for (i = 0; i < TOTAL_SIZE / size; i++) {
+        bitstream_reader_init(&reader, src);
+        bitstream_reader_seek(&reader, offset);
+
+        if (loop) {
+            read_bytes_loop(&reader, dst, size);
+        } else {
+            bitstream_reader_read_bytes(&reader, dst, size);
+        }
+    }
+
+    return (TOTAL_SIZE / (now() - start) / 1e9);
+}
+
+static double write_gbps(int size, int offset, int loop)
+{
+    struct bitstream_writer_t writer;
+    double start;
+    int i;
+
+    start = now();
+
+    for (i = 0; i < TOTAL_SIZE / size; i++) {
+        bitstream_writer_init(&writer, dst);
+        bitstream_writer_seek(&writer, offset);
+
+        if (loop) {
+            write_bytes_loop(&writer, src, size);
+        } else {
+            bitstream_writer_write_bytes(&writer, src, size);
+        }
+    }
+
+    return (TOTAL_SIZE / (now() - start) / 1e9);
+}
+
+int main()
+{
+    static const int sizes[] = { 16, 128, 1024, 8192, MAXIMUM_SIZE };
+    static const char *const isas[] = { "scalar", "sse2", "avx2", "avx512" };
+    int i;
+    int offset;
+    int isa;
+
+    for (i = 0; i < MAXIMUM_SIZE + 1; i++) {
+        src[i] = (uint8_t)rand();
+    }
+
+    printf("GB/s per copy, loop is the previous byte by byte loop.\n");
+
+    for (isa = 0; isa <= bitstream_isa_detect(); isa++) {
+        bitstream_isa_set(isa);
+        printf("\nISA %s\n\n", isas[isa]);
+        printf("  size  offset  read loop  read  write loop  write\n");
+
+        for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+            for (offset = 0; offset < 4; offset += 3) {
+                printf("%6d %7d %10.2f %5.2f %11.2f %6.2f\n",
+                       sizes[i],
+                       offset,
+                       read_gbps(sizes[i], offset, offset != 0),
+                       read_gbps(sizes[i], offset, 0),
+                       write_gbps(sizes[i], offset, offset != 0),
+                       write_gbps(sizes[i], offset, 0));
+            }
+        }
+    }
+
+    return (dst[0] == 0xff);
+}
@@ -0,0 +1,126 @@
+/**
+ * Compares bitstream_reader_read_u64_bits() and
+ * bitstream_writer_write_u64_bits() with their inline variants when
+ * reading and writing records with a fixed layout, where the inline
+ * variants see the field widths as constants.
+ *
+ * Build and run with
+ *
+ *   make benchmark-c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "bitstream.h"
+
+/* 98 bits records. */
+#define NUMBER_OF_RECORDS 32
+#define FIELDS_PER_RECORD 8
+#define BUFFER_SIZE (NUMBER_OF_RECORDS * 13 + 8)
+#define ROUNDS 100000
+
+#define READ_RECORD(read)                       \
+    sum += read(&reader, 3);                    \
+    sum += read(&reader, 13);                   \
+    sum += read(&reader, 7);                    \
+    sum += read(&reader, 21);                   \
+    sum += read(&reader, 11);                   \
+    sum += read(&reader, 9);                    \
+    sum += read(&reader, 32);                   \
+    sum += read(&reader, 2);
+
+#define WRITE_RECORD(write, value)              \
+    write(&writer, value & 0x7, 3);             \
+    write(&writer, value & 0x1fff, 13);         \
+    write(&writer, value & 0x7f, 7);            \
+    write(&writer, value & 0x1fffff, 21);       \
+    write(&writer, value & 0x7ff, 11);          \
+    write(&writer, value & 0x1ff, 9);           \
+    write(&writer, value & 0xffffffff, 32);     \
+    write(&writer, value & 0x3, 2);
+
+static uint8_t buf[BUFFER_SIZE];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static double read_ns(int is_inline, uint64_t *sum_p)
+{
+    struct bitstream_reader_t reader;
+    uint64_t sum;
+    double start;
+    int round;
+    int i;
+
+    sum = 0;
+    start = now();
+
+    for (round = 0; round < ROUNDS; round++) {
+        bitstream_reader_init_window(&reader, buf, BUFFER_SIZE);
+
+        if (is_inline) {
+            for (i = 0; i < NUMBER_OF_RECORDS; i++) {
+                READ_RECORD(bitstream_reader_read_u64_bits_inline);
+            }
+        } else {
+            for (i = 0; i < NUMBER_OF_RECORDS; i++) {
+                READ_RECORD(bitstream_reader_read_u64_bits);
+            }
+        }
+    }
+
+    *sum_p += sum;
+
+    return (1e9 * (now() - start)
+            / ((double)ROUNDS * NUMBER_OF_RECORDS * FIELDS_PER_RECORD));
+}
+
+static double write_ns(int is_inline)
+{
+    struct bitstream_writer_t writer;
+    uint64_t value;
+    double start;
+    int round;
+    int i;
+
+    value = 0x123456789abcdef0ull;
+    start = now();
+
+    for (round = 0; round < ROUNDS; round++) {
+        bitstream_writer_init_window(&writer, buf, BUFFER_SIZE);
+
+        if (is_inline) {
+            for (i = 0; i < NUMBER_OF_RECORDS; i++) {
+                WRITE_RECORD(bitstream_writer_write_u64_bits_inline, value);
+            }
+        } else {
+            for (i = 0; i < NUMBER_OF_RECORDS; i++) {
+                WRITE_RECORD(bitstream_writer_write_u64_bits, value);
+            }
+        }
+    }
+
+    return (1e9 * (now() - start)
+            / ((double)ROUNDS * NUMBER_OF_RECORDS * FIELDS_PER_RECORD));
+}
+
+int main()
+{
+    uint64_t sum;
+
+    sum = 0;
+
+    printf("Nanoseconds per field, records of 8 fields of 2 to 32 bits.\n\n");
+    printf("        function   inline\n");
+    printf("write %10.2f %8.2f\n", write_ns(0), write_ns(1));
+    printf("read  %10.2f %8.2f\n", read_ns(0, &sum), read_ns(1, &sum));
+
+    return (sum == 0);
+}
@@ -0,0 +1,139 @@
+/**
+ * Compares the byte by byte and the 64 bits window mode of
+ * bitstream_reader_read_u64_bits() and
+ * bitstream_writer_write_u64_bits() for all widths and bit offsets.
+ *
+ * Build and run with
+ *
+ *   gcc -O2 -I src/bitstruct benchmarks/bitstream_window.c \
+ *       src/bitstruct/bitstream.c -o bitstream_window
+ *   ./bitstream_window
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bitstream.h"
+
+/* Fields are 9 bytes apart so any width fits at any bit offset. */
+#define NUMBER_OF_FIELDS 1024
+#define FIELD_STRIDE 9
+#define BUFFER_SIZE (NUMBER_OF_FIELDS * FIELD_STRIDE)
+#define ROUNDS 200
+
+static uint8_t buf[BUFFER_SIZE];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static double read_ns(int window, int width, int offset, uint64_t *sum_p)
+{
+    struct bitstream_reader_t reader;
+    double start;
+    int round;
+    int i;
+
+    if (window) {
+        bitstream_reader_init_window(&reader, buf, BUFFER_SIZE);
+    } else {
+        bitstream_reader_init(&reader, buf);
+    }
+
+    start = now();
+
+    for (round = 0; round < ROUNDS; round++) {
+        for (i = 0; i < NUMBER_OF_FIELDS; i++) {
+            reader.byte_offset = (i * FIELD_STRIDE);
+            reader.bit_offset = offset;
+            *sum_p += bitstream_reader_read_u64_bits(&reader, width);
+        }
+    }
+
+    return (1e9 * (now() - start) / (ROUNDS * NUMBER_OF_FIELDS));
+}
+
+static double write_ns(int window, int width, int offset)
+{
+    struct bitstream_writer_t writer;
+    uint64_t value;
+    double start;
+    int round;
+    int i;
+
+    if (window) {
+        bitstream_writer_init_window(&writer, buf, BUFFER_SIZE);
+    } else {
+        bitstream_writer_init(&writer, buf);
+    }
+
+    value = (0x9abcdef012345678ull >> (64 - width));
+    start = now();
+
+    for (round = 0; round < ROUNDS; round++) {
+        for (i = 0; i < NUMBER_OF_FIELDS; i++) {
+            writer.byte_offset = (i * FIELD_STRIDE);
+            writer.bit_offset = offset;
+            bitstream_writer_write_u64_bits(&writer, value, width);
+        }
+    }
+
+    return (1e9 * (now() - start) / (ROUNDS * NUMBER_OF_FIELDS));
+}
+
+int main()
+{
+    int width;
+    int offset;
+    int window;
+    double ns[2][2];
+    double total[2][2];
+    uint64_t sum;
+
+    memset(&total[0][0], 0, sizeof(total));
+    sum = 0;
+
+    for (width = 0; width < BUFFER_SIZE; width++) {
+        buf[width] = (uint8_t)rand();
+    }
+
+    printf("Nanoseconds per field, mean over bit offsets 0-7.\n\n");
+    printf("width   read bytes  read window  write bytes  write window\n");
+
+    for (width = 1; width <= 64; width++) {
+        memset(&ns[0][0], 0, sizeof(ns));
+
+        for (offset = 0; offset < 8; offset++) {
+            for (window = 0; window < 2; window++) {
+                ns[0][window] += read_ns(window, width, offset, &sum) / 8;
+                ns[1][window] += write_ns(window, width, offset) / 8;
+            }
+        }
+
+        printf("%5d %12.2f %12.2f %12.2f %13.2f\n",
+               width,
+               ns[0][0],
+               ns[0][1],
+               ns[1][0],
+               ns[1][1]);
+
+        for (window = 0; window < 2; window++) {
+            total[0][window] += ns[0][window] / 64;
+            total[1][window] += ns[1][window] / 64;
+        }
+    }
+
+    printf("\n mean %12.2f %12.2f %12.2f %13.2f\n",
+           total[0][0],
+           total[0][1],
+           total[1][0],
+           total[1][1]);
+
+    return (sum == 0);
+}
@@ -1,5 +1,6 @@
 __version__ = '8.23.0'
 
+import array
 import binascii
 import re
 import struct
@@ -275,15 +276,26 @@ class _CompiledFormat:
 
         return bits
 
-    def pack_any(self, values):
-        bits = ''
+    def pack_bits(self, values, bits, buf_bits=None):
+        """Append given values to `bits`. Padding is taken from
+        `buf_bits` if given.
+
+        """
 
         for info in self._infos:
             if isinstance(info, _Padding):
-                bits += info.pack()
+                if buf_bits is None:
+                    bits += info.pack()
+                else:
+                    bits += buf_bits[len(bits):len(bits) + info.size]
             else:
                 bits = self.pack_value(info, values[info.name], bits)
 
+        return bits
+
+    def pack_any(self, values):
+        bits = self.pack_bits(values, '')
+
         # Padding of last byte.
         tail = len(bits) % 8
 
@@ -302,6 +314,8 @@ class _CompiledFormat:
                     self._number_of_bits_to_unpack,
                     len(bits)))
 
+        # Byte order is relative to the start of the data.
+        start_offset = offset
         offset = 0
 
         for info in self._infos:
@@ -321,7 +335,8 @@ class _CompiledFormat:
                     value_bits = bits[offset:offset + info.size]
                 else:
                     value_bits_tmp = bits[offset:offset + info.size]
-                    aligned_offset = (info.size - ((offset + info.size) % 8))
+                    aligned_offset = (
+                        info.size - ((start_offset + offset + info.size) % 8))
                     value_bits = ''
 
                     while aligned_offset > 0:
@@ -343,24 +358,141 @@ class _CompiledFormat:
         fill_padding = kwargs.get('fill_padding', True)
         buf_bits = _pack_bytearray(8 * len(buf), buf)
         bits = buf_bits[0:offset]
+        bits = self.pack_bits(data, bits, None if fill_padding else buf_bits)
+        bits += buf_bits[len(bits):]
+
+        if len(bits) > len(buf_bits):
+            raise Error(
+                f'pack_into requires a buffer of at least {len(bits)} bits')
+
+        buf[:] = _unpack_bytearray(len(bits), bits)
+
+    def record_size(self, stride):
+        number_of_bits = self._number_of_bits_to_unpack
+
+        if stride is None:
+            return number_of_bits
+
+        if 8 * stride < number_of_bits:
+            raise Error(
+                "stride of {} bytes is too small for records of {} bits".format(
+                    stride,
+                    number_of_bits))
+
+        return 8 * stride
+
+    def pack_many_any(self, records, stride):
+        record_size = self.record_size(stride)
+        bits = ''
+
+        for i, values in enumerate(records):
+            bits += (i * record_size - len(bits)) * '0'
+            bits = self.pack_bits(values, bits)
+
+        # Padding of last byte.
+        tail = len(bits) % 8
+
+        if tail != 0:
+            bits += (8 - tail) * '0'
+
+        return bytes(_unpack_bytearray(len(bits), bits))
+
+    def pack_columns_any(self, columns, stride):
+        lengths = set()
 
         for info in self._infos:
             if isinstance(info, _Padding):
-                if fill_padding:
-                    bits += info.pack()
-                else:
-                    bits += buf_bits[len(bits):len(bits) + info.size]
-            else:
-                bits = self.pack_value(info, data[info.name], bits)
+                continue
+            elif isinstance(info, (_Raw, _Text)):
+                raise Error('text and raw cannot be packed from columns')
+
+            lengths.add(len(columns[info.name]))
+
+        if len(lengths) > 1:
+            raise Error(
+                f'columns must have the same length (got {sorted(lengths)})')
+
+        count = lengths.pop() if lengths else 0
+        records = [
+            {
+                info.name: columns[info.name][i]
+                for info in self._infos
+                if not isinstance(info, _Padding)
+            }
+            for i in range(count)
+        ]
+
+        return self.pack_many_any(records, stride)
+
+    def pack_many_into_any(self, buf, offset, records, stride, **kwargs):
+        fill_padding = kwargs.get('fill_padding', True)
+        record_size = self.record_size(stride)
+        buf_bits = _pack_bytearray(8 * len(buf), buf)
+        bits = buf_bits[0:offset]
+
+        for i, values in enumerate(records):
+            bits += buf_bits[len(bits):offset + i * record_size]
+            bits = self.pack_bits(values,
+                                  bits,
+                                  None if fill_padding else buf_bits)
 
         bits += buf_bits[len(bits):]
 
         if len(bits) > len(buf_bits):
             raise Error(
-                f'pack_into requires a buffer of at least {len(bits)} bits')
+                f'pack_many_into requires a buffer of at least {len(bits)} bits')
 
         buf[:] = _unpack_bytearray(len(bits), bits)
 
+    def unpack_many_any(self, data, count, stride, offset):
+        number_of_bits = self._number_of_bits_to_unpack
+        record_size = self.record_size(stride)
+        available = 8 * len(data) - offset
+
+        if count is None:
+            if record_size == 0:
+                raise Error('count is required for empty records')
+
+            count = max((available - number_of_bits) // record_size + 1, 0)
+        elif count < 0:
+            raise Error(f'count must be non-negative (got {count})')
+        elif count > 0 and (count - 1) * record_size + number_of_bits > available:
+            raise Error(
+                "unpack_many requires at least {} bits to unpack (got {})".format(
+                    (count - 1) * record_size + number_of_bits,
+                    available))
+
+        for i in range(count):
+            record_offset = offset + i * record_size
+            record = data[record_offset // 8:(record_offset + number_of_bits + 7) // 8]
+
+            yield self.unpack_from_any(record, record_offset % 8, False)
+
+    def unpack_columns_any(self, data, count, stride, offset):
+        columns = []
+
+        for info in self._infos:
+            if isinstance(info, _Padding):
+                continue
+            elif isinstance(info, _Boolean):
+                type_code = 'B'
+            elif isinstance(info, _SignedInteger):
+                type_code = 'q'
+            elif isinstance(info, _UnsignedInteger):
+                type_code = 'Q'
+            elif isinstance(info, _Float):
+                type_code = 'd'
+            else:
+                raise Error('text and raw cannot be unpacked into columns')
+
+            columns.append((info, array.array(type_code)))
+
+        for record in self.unpack_many_any(data, count, stride, offset):
+            for (_, column), (_, value) in zip(columns, record):
+                column.append(value)
+
+        return columns
+
     def calcsize(self):
         """Return the number of bits in the compiled format string.
 
@@ -421,6 +553,66 @@ class CompiledFormat(_CompiledFormat):
 
         self.pack_into_any(buf, offset, args, **kwargs)
 
+    def pack_many(self, records, stride=None):
+        """Pack given records, each a sequence of values, and return
+        the result as a single bytes object.
+
+        Records are packed back to back if `stride` is ``None``, and
+        otherwise placed `stride` bytes apart.
+
+        """
+
+        return self.pack_many_any(self._check_records(records), stride)
+
+    def pack_many_into(self, buf, offset, records, stride=None, **kwargs):
+        """Same as :meth:`~bitstruct.CompiledFormat.pack_many()`, but
+        packs into given bytearray `buf`, starting at given bit offset
+        `offset`. See :func:`~bitstruct.pack_into()` for details on
+        `kwargs`.
+
+        """
+
+        self.pack_many_into_any(buf,
+                                offset,
+                                self._check_records(records),
+                                stride,
+                                **kwargs)
+
+    def pack_columns(self, *columns, stride=None):
+        """Pack given columns, one per non-padding field, and return the
+        result as a single bytes object. A column is any object
+        supporting indexing and :func:`len()`, typically an
+        :class:`array.array`. All columns must have the same length,
+        and record ``i`` is made of item ``i`` of each column. See
+        :meth:`~bitstruct.CompiledFormat.pack_many()` for details on
+        `stride`.
+
+        Text and raw are not supported.
+
+        """
+
+        # Sanity check of the number of columns.
+        if len(columns) < self._number_of_arguments:
+            raise Error(
+                "pack_columns expected {} column(s) (got {})".format(
+                    self._number_of_arguments,
+                    len(columns)))
+
+        return self.pack_columns_any(columns, stride)
+
+    def _check_records(self, records):
+        records = list(records)
+
+        for values in records:
+            # Sanity check of the number of arguments.
+            if len(values) < self._number_of_arguments:
+                raise Error(
+                    "pack expected {} item(s) for packing (got {})".format(
+                        self._number_of_arguments,
+                        len(values)))
+
+        return records
+
     def unpack_from(self, data, offset=0, allow_truncated=False):
         """See :func:`~bitstruct.unpack_from()`.
 
@@ -429,6 +621,36 @@ class CompiledFormat(_CompiledFormat):
         return tuple([v[1] for v in self.unpack_from_any(
             data, offset, allow_truncated=allow_truncated)])
 
+    def unpack_many(self, data, count=None, stride=None, offset=0):
+        """Unpack `count` records from `data`, starting at given bit
+        offset `offset`, and return them as a list of tuples.
+
+        Records are packed back to back if `stride` is ``None``, and
+        otherwise placed `stride` bytes apart. All complete records in
+        `data` are unpacked if `count` is ``None``.
+
+        """
+
+        return [
+            tuple([v[1] for v in record])
+            for record in self.unpack_many_any(data, count, stride, offset)
+        ]
+
+    def unpack_columns(self, data, count=None, stride=None, offset=0):
+        """Same as :meth:`~bitstruct.CompiledFormat.unpack_many()`, but
+        returns a tuple with one :class:`array.array` per field instead
+        of one tuple per record.
+
+        Signed integers are unpacked into ``'q'`` arrays, unsigned
+        integers into ``'Q'`` arrays, booleans into ``'B'`` arrays and
+        floats into ``'d'`` arrays. Text and raw are not supported.
+
+        """
+
+        return tuple([column for _, column in self.unpack_columns_any(
+            data, count, stride, offset)])
+
+
 class CompiledFormatDict(_CompiledFormat):
     """See :class:`~bitstruct.CompiledFormat`.
 
@@ -444,6 +666,39 @@ class CompiledFormatDict(_CompiledFormat):
         except KeyError as e:
             raise Error(f'{str(e)} not found in data dictionary')
 
+    def pack_many(self, records, stride=None):
+        """See :meth:`~bitstruct.CompiledFormat.pack_many()`, but each
+        record is a dictionary.
+
+        """
+
+        try:
+            return self.pack_many_any(records, stride)
+        except KeyError as e:
+            raise Error(f'{str(e)} not found in data dictionary')
+
+    def pack_many_into(self, buf, offset, records, stride=None, **kwargs):
+        """See :meth:`~bitstruct.CompiledFormat.pack_many_into()`, but
+        each record is a dictionary.
+
+        """
+
+        try:
+            self.pack_many_into_any(buf, offset, records, stride, **kwargs)
+        except KeyError as e:
+            raise Error(f'{str(e)} not found in data dictionary')
+
+    def pack_columns(self, columns, stride=None):
+        """See :meth:`~bitstruct.CompiledFormat.pack_columns()`, but
+        `columns` is a dictionary of columns.
+
+        """
+
+        try:
+            return self.pack_columns_any(columns, stride)
+        except KeyError as e:
+            raise Error(f'{str(e)} not found in data dictionary')
+
     def unpack(self, data, allow_truncated=False):
         """See :func:`~bitstruct.unpack_dict()`.
 
@@ -470,6 +725,27 @@ class CompiledFormatDict(_CompiledFormat):
             info.name: v for info, v in self.unpack_from_any(
                 data, offset, allow_truncated=allow_truncated)}
 
+    def unpack_many(self, data, count=None, stride=None, offset=0):
+        """See :meth:`~bitstruct.CompiledFormat.unpack_many()`, but
+        returns a list of dictionaries.
+
+        """
+
+        return [
+            {info.name: v for info, v in record}
+            for record in self.unpack_many_any(data, count, stride, offset)
+        ]
+
+    def unpack_columns(self, data, count=None, stride=None, offset=0):
+        """See :meth:`~bitstruct.CompiledFormat.unpack_columns()`, but
+        returns a dictionary of arrays.
+
+        """
+
+        return {
+            info.name: column for info, column in self.unpack_columns_any(
+                data, count, stride, offset)}
+
 
 def pack(fmt, *args):
     """Return a bytes object containing the values v1, v2, ... packed
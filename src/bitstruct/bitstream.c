@@ -24,23 +24,248 @@
  * SOFTWARE.
  */
 
+#include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 #include "bitstream.h"
 
+/* With GCC and Clang on x86 all kernels are compiled, each for its
+   instruction set, and selected at runtime. Otherwise only the
+   kernels of the instruction sets the compiler targets are
+   available. */
+#if (defined(__GNUC__) || defined(__clang__))           \
+    && (defined(__x86_64__) || defined(__i386__))
+#    define ISA_DISPATCH
+#    define ISA_SSE2
+#    define ISA_AVX2
+#    define ISA_AVX512
+#    define TARGET(name) __attribute__((target(name)))
+#else
+#    if defined(__SSE2__) || defined(_M_X64)
+#        define ISA_SSE2
+#    endif
+#    if defined(__AVX2__)
+#        define ISA_AVX2
+#    endif
+#    if defined(__AVX512BW__)
+#        define ISA_AVX512
+#    endif
+#    define TARGET(name)
+#endif
+
+#if defined(ISA_SSE2)
+#    include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+#if defined(__AVX512BW__)
+#    define ISA_COMPILED BITSTREAM_ISA_AVX512
+#elif defined(__AVX2__)
+#    define ISA_COMPILED BITSTREAM_ISA_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#    define ISA_COMPILED BITSTREAM_ISA_SSE2
+#else
+#    define ISA_COMPILED BITSTREAM_ISA_SCALAR
+#endif
+
+/* Number of bytes loaded and stored at a time in window mode. */
+#define WINDOW_SIZE 8
+
+/* Size in bytes of buffers given without size, so that bit offsets
+   into them never overflow. */
+#define UNBOUNDED_SIZE (INT64_MAX / 8)
+
+/* The instruction set may be changed while other threads run kernels,
+   so it is read and written atomically. The kernels do not depend on
+   each other, so no ordering is needed. Aligned int accesses are
+   atomic on all targets of other compilers. */
+#if defined(__GNUC__) || defined(__clang__)
+static int isa = ISA_COMPILED;
+#    define ISA_LOAD() __atomic_load_n(&isa, __ATOMIC_RELAXED)
+#    define ISA_STORE(value) __atomic_store_n(&isa, (value), __ATOMIC_RELAXED)
+#else
+static volatile int isa = ISA_COMPILED;
+#    define ISA_LOAD() (isa)
+#    define ISA_STORE(value) (isa = (value))
+#endif
+
+/* The shifted copy kernels shift 16 bits lanes and mask away bits
+   from the neighbour byte, as there are no byte shifts. Each returns
+   the number of copied bytes. */
+
+#if defined(ISA_AVX512)
+
+TARGET("avx512bw")
+static int shifted_copy_avx512(uint8_t *dst_p,
+                               const uint8_t *src_p,
+                               int length,
+                               int shift)
+{
+    __m512i high_mask;
+    __m512i low_mask;
+    __m128i left_shift;
+    __m128i right_shift;
+    __m512i high;
+    __m512i low;
+    int i;
+
+    high_mask = _mm512_set1_epi8((char)(0xff << shift));
+    low_mask = _mm512_set1_epi8((char)(0xff >> (8 - shift)));
+    left_shift = _mm_cvtsi32_si128(shift);
+    right_shift = _mm_cvtsi32_si128(8 - shift);
+
+    for (i = 0; i + 64 <= length; i += 64) {
+        high = _mm512_loadu_si512((const void *)&src_p[i]);
+        low = _mm512_loadu_si512((const void *)&src_p[i + 1]);
+        high = _mm512_and_si512(_mm512_sll_epi16(high, left_shift), high_mask);
+        low = _mm512_and_si512(_mm512_srl_epi16(low, right_shift), low_mask);
+        _mm512_storeu_si512((void *)&dst_p[i], _mm512_or_si512(high, low));
+    }
+
+    return (i);
+}
+
+#endif
+
+#if defined(ISA_AVX2)
+
+TARGET("avx2")
+static int shifted_copy_avx2(uint8_t *dst_p,
+                             const uint8_t *src_p,
+                             int length,
+                             int shift)
+{
+    __m256i high_mask;
+    __m256i low_mask;
+    __m128i left_shift;
+    __m128i right_shift;
+    __m256i high;
+    __m256i low;
+    int i;
+
+    high_mask = _mm256_set1_epi8((char)(0xff << shift));
+    low_mask = _mm256_set1_epi8((char)(0xff >> (8 - shift)));
+    left_shift = _mm_cvtsi32_si128(shift);
+    right_shift = _mm_cvtsi32_si128(8 - shift);
+
+    for (i = 0; i + 32 <= length; i += 32) {
+        high = _mm256_loadu_si256((const __m256i *)&src_p[i]);
+        low = _mm256_loadu_si256((const __m256i *)&src_p[i + 1]);
+        high = _mm256_and_si256(_mm256_sll_epi16(high, left_shift), high_mask);
+        low = _mm256_and_si256(_mm256_srl_epi16(low, right_shift), low_mask);
+        _mm256_storeu_si256((__m256i *)&dst_p[i], _mm256_or_si256(high, low));
+    }
+
+    return (i);
+}
+
+#endif
+
+#if defined(ISA_SSE2)
+
+TARGET("sse2")
+static int shifted_copy_sse2(uint8_t *dst_p,
+                             const uint8_t *src_p,
+                             int length,
+                             int shift)
+{
+    __m128i high_mask;
+    __m128i low_mask;
+    __m128i left_shift;
+    __m128i right_shift;
+    __m128i high;
+    __m128i low;
+    int i;
+
+    high_mask = _mm_set1_epi8((char)(0xff << shift));
+    low_mask = _mm_set1_epi8((char)(0xff >> (8 - shift)));
+    left_shift = _mm_cvtsi32_si128(shift);
+    right_shift = _mm_cvtsi32_si128(8 - shift);
+
+    for (i = 0; i + 16 <= length; i += 16) {
+        high = _mm_loadu_si128((const __m128i *)&src_p[i]);
+        low = _mm_loadu_si128((const __m128i *)&src_p[i + 1]);
+        high = _mm_and_si128(_mm_sll_epi16(high, left_shift), high_mask);
+        low = _mm_and_si128(_mm_srl_epi16(low, right_shift), low_mask);
+        _mm_storeu_si128((__m128i *)&dst_p[i], _mm_or_si128(high, low));
+    }
+
+    return (i);
+}
+
+#endif
+
+/* Copy given number of bytes starting at given bit, 1 to 7, in the
+   source. That is, dst_p[i] = ((src_p[i] << shift) | (src_p[i + 1]
+   >> (8 - shift))), so src_p[length] is also read. */
+static void shifted_copy(uint8_t *dst_p,
+                         const uint8_t *src_p,
+                         int length,
+                         int shift)
+{
+    int i;
+
+    i = 0;
+
+#if defined(ISA_AVX512)
+    if (ISA_LOAD() >= BITSTREAM_ISA_AVX512) {
+        i += shifted_copy_avx512(&dst_p[i], &src_p[i], length - i, shift);
+    }
+#endif
+
+#if defined(ISA_AVX2)
+    if (ISA_LOAD() >= BITSTREAM_ISA_AVX2) {
+        i += shifted_copy_avx2(&dst_p[i], &src_p[i], length - i, shift);
+    }
+#endif
+
+#if defined(ISA_SSE2)
+    if (ISA_LOAD() >= BITSTREAM_ISA_SSE2) {
+        i += shifted_copy_sse2(&dst_p[i], &src_p[i], length - i, shift);
+    }
+#endif
+
+    /* Both windows agree on the bits they have in common. */
+    for (; i + 8 <= length; i += 8) {
+        bitstream_window_store(&dst_p[i],
+                               ((bitstream_window_load(&src_p[i]) << shift)
+                                | (bitstream_window_load(&src_p[i + 1])
+                                   >> (8 - shift))));
+    }
+
+    for (; i < length; i++) {
+        dst_p[i] = (uint8_t)((src_p[i] << shift) | (src_p[i + 1] >> (8 - shift)));
+    }
+}
+
 void bitstream_writer_init(struct bitstream_writer_t *self_p,
                            uint8_t *buf_p)
 {
     self_p->buf_p = buf_p;
     self_p->byte_offset = 0;
     self_p->bit_offset = 0;
+    self_p->window_end = -1;
+    self_p->size = UNBOUNDED_SIZE;
 }
 
-int bitstream_writer_size_in_bits(struct bitstream_writer_t *self_p)
+void bitstream_writer_init_window(struct bitstream_writer_t *self_p,
+                                  uint8_t *buf_p,
+                                  int64_t size)
+{
+    bitstream_writer_init(self_p, buf_p);
+    self_p->window_end = (size - WINDOW_SIZE);
+    self_p->size = size;
+}
+
+int64_t bitstream_writer_size_in_bits(struct bitstream_writer_t *self_p)
 {
     return (8 * self_p->byte_offset + self_p->bit_offset);
 }
 
-int bitstream_writer_size_in_bytes(struct bitstream_writer_t *self_p)
+int64_t bitstream_writer_size_in_bytes(struct bitstream_writer_t *self_p)
 {
     return (self_p->byte_offset + (self_p->bit_offset + 7) / 8);
 }
@@ -67,18 +292,16 @@ void bitstream_writer_write_bytes(struct bitstream_writer_t *self_p,
                                   const uint8_t *buf_p,
                                   int length)
 {
-    int i;
     uint8_t *dst_p;
 
     dst_p = &self_p->buf_p[self_p->byte_offset];
 
     if (self_p->bit_offset == 0) {
         memcpy(dst_p, buf_p, sizeof(uint8_t) * length);
-    } else {
-        for (i = 0; i < length; i++) {
-            dst_p[i] |= (buf_p[i] >> self_p->bit_offset);
-            dst_p[i + 1] = (uint8_t)(buf_p[i] << (8 - self_p->bit_offset));
-        }
+    } else if (length > 0) {
+        dst_p[0] |= (buf_p[0] >> self_p->bit_offset);
+        shifted_copy(&dst_p[1], buf_p, length - 1, 8 - self_p->bit_offset);
+        dst_p[length] = (uint8_t)(buf_p[length - 1] << (8 - self_p->bit_offset));
     }
 
     self_p->byte_offset += length;
@@ -162,6 +385,30 @@ void bitstream_writer_write_u64(struct bitstream_writer_t *self_p,
 void bitstream_writer_write_u64_bits(struct bitstream_writer_t *self_p,
                                      uint64_t value,
                                      int number_of_bits)
+{
+    bitstream_writer_write_u64_bits_inline(self_p, value, number_of_bits);
+}
+
+void bitstream_writer_write_u64_bits_le(struct bitstream_writer_t *self_p,
+                                        uint64_t value,
+                                        int number_of_bits)
+{
+    bitstream_writer_write_u64_bits_le_inline(self_p, value, number_of_bits);
+}
+
+void bitstream_writer_write_u64_bits_le_bytes(struct bitstream_writer_t *self_p,
+                                              uint64_t value,
+                                              int number_of_bits)
+{
+    bitstream_writer_write_u64_bits_bytes(
+        self_p,
+        bitstream_reverse_u64_bits(value, number_of_bits),
+        number_of_bits);
+}
+
+void bitstream_writer_write_u64_bits_bytes(struct bitstream_writer_t *self_p,
+                                           uint64_t value,
+                                           int number_of_bits)
 {
     int i;
     int first_byte_bits;
@@ -214,6 +461,316 @@ void bitstream_writer_write_u64_bits(struct bitstream_writer_t *self_p,
     self_p->byte_offset += full_bytes;
 }
 
+void bitstream_writer_write_u64_bits_lsb_byte_first(
+    struct bitstream_writer_t *self_p,
+    uint64_t value,
+    int number_of_bits)
+{
+    uint64_t ordered;
+    int chunk_bits;
+    int remaining;
+
+    /* Reorder the chunks so that the value can be written most
+       significant bit first. */
+    ordered = 0;
+    chunk_bits = (8 - self_p->bit_offset);
+    remaining = number_of_bits;
+
+    while (remaining > 0) {
+        if (chunk_bits > remaining) {
+            chunk_bits = remaining;
+        }
+
+        ordered <<= chunk_bits;
+        ordered |= (value & ((1u << chunk_bits) - 1));
+        value >>= chunk_bits;
+        remaining -= chunk_bits;
+        chunk_bits = 8;
+    }
+
+    bitstream_writer_write_u64_bits(self_p, ordered, number_of_bits);
+}
+
+/* Reduce in the item type so that the loop can be vectorized. */
+#define ARRAY_MIN_MAX(type)                                             \
+    {                                                                   \
+        type item;                                                      \
+        type lowest = 0;                                                \
+        type highest = 0;                                               \
+                                                                        \
+        for (i = 0; i < count; i++) {                                   \
+            item = ((const type *)src_p)[i];                            \
+            lowest = ((item < lowest) ? item : lowest);                 \
+            highest = ((item > highest) ? item : highest);              \
+        }                                                               \
+                                                                        \
+        minimum = lowest;                                               \
+        maximum = highest;                                              \
+    }
+
+static int is_array_in_range_signed(const void *src_p,
+                                    int item_size,
+                                    int64_t count,
+                                    int64_t lower,
+                                    uint64_t upper)
+{
+    int64_t i;
+    int64_t minimum;
+    int64_t maximum;
+
+    minimum = 0;
+    maximum = 0;
+
+    switch (item_size) {
+
+    case 1:
+        ARRAY_MIN_MAX(int8_t);
+        break;
+
+    case 2:
+        ARRAY_MIN_MAX(int16_t);
+        break;
+
+    case 4:
+        ARRAY_MIN_MAX(int32_t);
+        break;
+
+    default:
+        ARRAY_MIN_MAX(int64_t);
+        break;
+    }
+
+    return ((minimum >= lower)
+            && ((maximum < 0) || ((uint64_t)maximum <= upper)));
+}
+
+#define ARRAY_MAX(type)                                                 \
+    {                                                                   \
+        type item;                                                      \
+        type highest = 0;                                               \
+                                                                        \
+        for (i = 0; i < count; i++) {                                   \
+            item = ((const type *)src_p)[i];                            \
+            highest = ((item > highest) ? item : highest);              \
+        }                                                               \
+                                                                        \
+        maximum = highest;                                              \
+    }
+
+static int is_array_in_range_unsigned(const void *src_p,
+                                      int item_size,
+                                      int64_t count,
+                                      uint64_t upper)
+{
+    int64_t i;
+    uint64_t maximum;
+
+    maximum = 0;
+
+    switch (item_size) {
+
+    case 1:
+        ARRAY_MAX(uint8_t);
+        break;
+
+    case 2:
+        ARRAY_MAX(uint16_t);
+        break;
+
+    case 4:
+        ARRAY_MAX(uint32_t);
+        break;
+
+    default:
+        ARRAY_MAX(uint64_t);
+        break;
+    }
+
+    return (maximum <= upper);
+}
+
+/* Get an array item sign or zero extended to 64 bits. */
+static uint64_t array_get(const void *src_p,
+                          int item_size,
+                          int is_item_signed,
+                          int64_t index)
+{
+    switch (item_size) {
+
+    case 1:
+        if (is_item_signed) {
+            return ((uint64_t)((const int8_t *)src_p)[index]);
+        } else {
+            return (((const uint8_t *)src_p)[index]);
+        }
+
+    case 2:
+        if (is_item_signed) {
+            return ((uint64_t)((const int16_t *)src_p)[index]);
+        } else {
+            return (((const uint16_t *)src_p)[index]);
+        }
+
+    case 4:
+        if (is_item_signed) {
+            return ((uint64_t)((const int32_t *)src_p)[index]);
+        } else {
+            return (((const uint32_t *)src_p)[index]);
+        }
+
+    default:
+        return (((const uint64_t *)src_p)[index]);
+    }
+}
+
+/* Values are accumulated in a 64 bits register, and written 32 bits
+   at a time without reading the buffer. At most 32 bits are added at
+   a time, so wider values are added in two parts. */
+#define ACCUMULATE(value, number_of_bits)                               \
+    accumulator = ((accumulator << (number_of_bits)) | (value));        \
+    accumulator_bits += (number_of_bits);                               \
+                                                                        \
+    if (accumulator_bits >= 32) {                                       \
+        accumulator_bits -= 32;                                         \
+        word = (uint32_t)(accumulator >> accumulator_bits);             \
+        dst_p[0] = (uint8_t)(word >> 24);                               \
+        dst_p[1] = (uint8_t)(word >> 16);                               \
+        dst_p[2] = (uint8_t)(word >> 8);                                \
+        dst_p[3] = (uint8_t)word;                                       \
+        dst_p += 4;                                                     \
+    }
+
+#define WRITE_ARRAY_BITS(type)                                          \
+    if (number_of_bits <= 32) {                                         \
+        for (i = 0; i < count; i++) {                                   \
+            value = ((uint64_t)((const type *)src_p)[i] & mask);        \
+            ACCUMULATE(value, number_of_bits);                          \
+        }                                                               \
+    } else {                                                            \
+        for (i = 0; i < count; i++) {                                   \
+            value = ((uint64_t)((const type *)src_p)[i] & mask);        \
+            ACCUMULATE(value >> 32, number_of_bits - 32);               \
+            ACCUMULATE(value & 0xffffffff, 32);                         \
+        }                                                               \
+    }
+
+int64_t bitstream_writer_write_array_bits(struct bitstream_writer_t *self_p,
+                                          const void *src_p,
+                                          int item_size,
+                                          int is_item_signed,
+                                          int number_of_bits,
+                                          int is_signed,
+                                          int64_t count)
+{
+    int64_t i;
+    int64_t lower;
+    uint64_t upper;
+    uint64_t mask;
+    uint64_t value;
+    uint64_t accumulator;
+    int accumulator_bits;
+    uint32_t word;
+    uint8_t *dst_p;
+    int is_in_range;
+
+    if (number_of_bits == 64) {
+        mask = UINT64_MAX;
+    } else {
+        mask = ((1ull << number_of_bits) - 1);
+    }
+
+    if (is_signed) {
+        upper = (mask >> 1);
+        lower = (-(int64_t)upper - 1);
+    } else {
+        upper = mask;
+        lower = 0;
+    }
+
+    /* Range check all values before writing. */
+    if (is_item_signed) {
+        is_in_range = is_array_in_range_signed(src_p,
+                                               item_size,
+                                               count,
+                                               lower,
+                                               upper);
+    } else {
+        is_in_range = is_array_in_range_unsigned(src_p,
+                                                 item_size,
+                                                 count,
+                                                 upper);
+    }
+
+    if (!is_in_range) {
+        for (i = 0; i < count; i++) {
+            value = array_get(src_p, item_size, is_item_signed, i);
+
+            if (is_item_signed && ((int64_t)value < 0)) {
+                if ((int64_t)value < lower) {
+                    return (i);
+                }
+            } else if (value > upper) {
+                return (i);
+            }
+        }
+    }
+
+    /* Start with the bits already written to the current byte. */
+    dst_p = &self_p->buf_p[self_p->byte_offset];
+    accumulator = (self_p->bit_offset != 0
+                   ? (*dst_p >> (8 - self_p->bit_offset))
+                   : 0);
+    accumulator_bits = self_p->bit_offset;
+
+    switch (item_size) {
+
+    case 1:
+        if (is_item_signed) {
+            WRITE_ARRAY_BITS(int8_t);
+        } else {
+            WRITE_ARRAY_BITS(uint8_t);
+        }
+
+        break;
+
+    case 2:
+        if (is_item_signed) {
+            WRITE_ARRAY_BITS(int16_t);
+        } else {
+            WRITE_ARRAY_BITS(uint16_t);
+        }
+
+        break;
+
+    case 4:
+        if (is_item_signed) {
+            WRITE_ARRAY_BITS(int32_t);
+        } else {
+            WRITE_ARRAY_BITS(uint32_t);
+        }
+
+        break;
+
+    default:
+        WRITE_ARRAY_BITS(uint64_t);
+        break;
+    }
+
+    while (accumulator_bits >= 8) {
+        accumulator_bits -= 8;
+        *dst_p++ = (uint8_t)(accumulator >> accumulator_bits);
+    }
+
+    if (accumulator_bits > 0) {
+        *dst_p = (uint8_t)(accumulator << (8 - accumulator_bits));
+    }
+
+    self_p->byte_offset = (dst_p - self_p->buf_p);
+    self_p->bit_offset = accumulator_bits;
+
+    return (-1);
+}
+
 void bitstream_writer_write_repeated_bit(struct bitstream_writer_t *self_p,
                                          int value,
                                          int length)
@@ -224,20 +781,47 @@ void bitstream_writer_write_repeated_bit(struct bitstream_writer_t *self_p,
         value = 0xff;
     }
 
-    rest = (length % 8);
+    /* Align beginning. */
+    rest = ((8 - self_p->bit_offset) % 8);
+
+    if (rest > length) {
+        rest = length;
+    }
+
     bitstream_writer_write_u64_bits(self_p, value & ((1 << rest) - 1), rest);
+    length -= rest;
     bitstream_writer_write_repeated_u8(self_p, value, length / 8);
+    rest = (length % 8);
+    bitstream_writer_write_u64_bits(self_p, value & ((1 << rest) - 1), rest);
 }
 
 void bitstream_writer_write_repeated_u8(struct bitstream_writer_t *self_p,
                                         uint8_t value,
                                         int length)
 {
-    int i;
+    uint8_t *dst_p;
+    int bit_offset;
+
+    if (length <= 0) {
+        return;
+    }
+
+    dst_p = &self_p->buf_p[self_p->byte_offset];
+    bit_offset = self_p->bit_offset;
 
-    for (i = 0; i < length; i++) {
-        bitstream_writer_write_u8(self_p, value);
+    if (bit_offset == 0) {
+        memset(dst_p, value, length);
+    } else {
+        /* Every byte but the first and the last is the value rotated
+           by the bit offset. */
+        dst_p[0] |= (value >> bit_offset);
+        memset(&dst_p[1],
+               (uint8_t)((value >> bit_offset) | (value << (8 - bit_offset))),
+               length - 1);
+        dst_p[length] = (uint8_t)(value << (8 - bit_offset));
     }
+
+    self_p->byte_offset += length;
 }
 
 void bitstream_writer_insert_bit(struct bitstream_writer_t *self_p,
@@ -334,16 +918,16 @@ void bitstream_writer_insert_u64_bits(struct bitstream_writer_t *self_p,
 }
 
 void bitstream_writer_seek(struct bitstream_writer_t *self_p,
-                           int offset)
+                           int64_t offset)
 {
     offset += ((8 * self_p->byte_offset) + self_p->bit_offset);
     self_p->byte_offset = (offset / 8);
-    self_p->bit_offset = (offset % 8);
+    self_p->bit_offset = (int)(offset % 8);
 }
 
 void bitstream_writer_bounds_save(struct bitstream_writer_bounds_t *self_p,
                                   struct bitstream_writer_t *writer_p,
-                                  int bit_offset,
+                                  int64_t bit_offset,
                                   int length)
 {
     int number_of_bits;
@@ -386,12 +970,65 @@ void bitstream_writer_bounds_restore(struct bitstream_writer_bounds_t *self_p)
     }
 }
 
+int64_t bitstream_writer_remaining_bits(struct bitstream_writer_t *self_p)
+{
+    return ((8 * self_p->size) - bitstream_writer_size_in_bits(self_p));
+}
+
+int bitstream_writer_check(struct bitstream_writer_t *self_p,
+                           int64_t number_of_bits)
+{
+    if ((number_of_bits < 0)
+        || (number_of_bits > bitstream_writer_remaining_bits(self_p))) {
+        return (-1);
+    }
+
+    return (0);
+}
+
+int bitstream_writer_write_u64_bits_checked(struct bitstream_writer_t *self_p,
+                                            uint64_t value,
+                                            int number_of_bits)
+{
+    if (bitstream_writer_check(self_p, number_of_bits) != 0) {
+        return (-1);
+    }
+
+    bitstream_writer_write_u64_bits_inline(self_p, value, number_of_bits);
+
+    return (0);
+}
+
+int bitstream_writer_write_bytes_checked(struct bitstream_writer_t *self_p,
+                                         const uint8_t *buf_p,
+                                         int length)
+{
+    if (bitstream_writer_check(self_p, 8 * (int64_t)length) != 0) {
+        return (-1);
+    }
+
+    bitstream_writer_write_bytes(self_p, buf_p, length);
+
+    return (0);
+}
+
 void bitstream_reader_init(struct bitstream_reader_t *self_p,
                            const uint8_t *buf_p)
 {
     self_p->buf_p = buf_p;
     self_p->byte_offset = 0;
     self_p->bit_offset = 0;
+    self_p->window_end = -1;
+    self_p->size = UNBOUNDED_SIZE;
+}
+
+void bitstream_reader_init_window(struct bitstream_reader_t *self_p,
+                                  const uint8_t *buf_p,
+                                  int64_t size)
+{
+    bitstream_reader_init(self_p, buf_p);
+    self_p->window_end = (size - WINDOW_SIZE);
+    self_p->size = size;
 }
 
 int bitstream_reader_read_bit(struct bitstream_reader_t *self_p)
@@ -419,7 +1056,6 @@ void bitstream_reader_read_bytes(struct bitstream_reader_t *self_p,
                                  uint8_t *buf_p,
                                  int length)
 {
-    int i;
     const uint8_t *src_p;
 
     src_p = &self_p->buf_p[self_p->byte_offset];
@@ -427,10 +1063,7 @@ void bitstream_reader_read_bytes(struct bitstream_reader_t *self_p,
     if (self_p->bit_offset == 0) {
         memcpy(buf_p, src_p, sizeof(uint8_t) * length);
     } else {
-        for (i = 0; i < length; i++) {
-            buf_p[i] = (src_p[i] << self_p->bit_offset);
-            buf_p[i] |= (src_p[i + 1] >> (8 - self_p->bit_offset));
-        }
+        shifted_copy(buf_p, src_p, length, self_p->bit_offset);
     }
 
     self_p->byte_offset += length;
@@ -527,6 +1160,27 @@ uint64_t bitstream_reader_read_u64(struct bitstream_reader_t *self_p)
 
 uint64_t bitstream_reader_read_u64_bits(struct bitstream_reader_t *self_p,
                                         int number_of_bits)
+{
+    return (bitstream_reader_read_u64_bits_inline(self_p, number_of_bits));
+}
+
+uint64_t bitstream_reader_read_u64_bits_le(struct bitstream_reader_t *self_p,
+                                           int number_of_bits)
+{
+    return (bitstream_reader_read_u64_bits_le_inline(self_p, number_of_bits));
+}
+
+uint64_t bitstream_reader_read_u64_bits_le_bytes(
+    struct bitstream_reader_t *self_p,
+    int number_of_bits)
+{
+    return (bitstream_reverse_u64_bits(
+                bitstream_reader_read_u64_bits_bytes(self_p, number_of_bits),
+                number_of_bits));
+}
+
+uint64_t bitstream_reader_read_u64_bits_bytes(struct bitstream_reader_t *self_p,
+                                              int number_of_bits)
 {
     uint64_t value;
     int i;
@@ -586,15 +1240,1342 @@ uint64_t bitstream_reader_read_u64_bits(struct bitstream_reader_t *self_p,
     return (value);
 }
 
+uint64_t bitstream_reader_read_u64_bits_lsb_byte_first(
+    struct bitstream_reader_t *self_p,
+    int number_of_bits)
+{
+    uint64_t ordered;
+    uint64_t value;
+    int chunk_bits;
+    int remaining;
+    int shift;
+
+    chunk_bits = (8 - self_p->bit_offset);
+    ordered = bitstream_reader_read_u64_bits(self_p, number_of_bits);
+    value = 0;
+    remaining = number_of_bits;
+    shift = 0;
+
+    while (remaining > 0) {
+        if (chunk_bits > remaining) {
+            chunk_bits = remaining;
+        }
+
+        remaining -= chunk_bits;
+        value |= (((ordered >> remaining) & ((1u << chunk_bits) - 1)) << shift);
+        shift += chunk_bits;
+        chunk_bits = 8;
+    }
+
+    return (value);
+}
+
+#if defined(ISA_AVX2)
+
+/* Read eight values of at most 25 bits at a time. Each 128 bits lane
+   shuffles four big endian 32 bits words into place, which are then
+   shifted so that the values are right aligned. As eight values are a
+   whole number of bytes, the shuffle and shifts are the same for all
+   groups. Returns the number of read values. */
+TARGET("avx2")
+static int64_t read_array_bits_avx2(struct bitstream_reader_t *self_p,
+                                    void *dst_p,
+                                    int item_size,
+                                    int number_of_bits,
+                                    int is_signed,
+                                    int64_t count)
+{
+    uint8_t shuffle[32];
+    uint32_t shifts[8];
+    const uint8_t *src_p;
+    int lane_offset;
+    int bit;
+    int i;
+    int j;
+    int64_t done;
+    __m256i shuffle_mask;
+    __m256i shift_counts;
+    __m128i right_shift;
+    __m256i values;
+    __m256i packed;
+
+    lane_offset = ((self_p->bit_offset + 4 * number_of_bits) / 8);
+
+    for (i = 0; i < 8; i++) {
+        bit = (self_p->bit_offset + i * number_of_bits);
+
+        if (i >= 4) {
+            bit -= (8 * lane_offset);
+        }
+
+        shifts[i] = (bit % 8);
+
+        for (j = 0; j < 4; j++) {
+            shuffle[4 * i + j] = (uint8_t)(bit / 8 + 3 - j);
+        }
+    }
+
+    shuffle_mask = _mm256_loadu_si256((const __m256i *)&shuffle[0]);
+    shift_counts = _mm256_loadu_si256((const __m256i *)&shifts[0]);
+    right_shift = _mm_cvtsi32_si128(32 - number_of_bits);
+    src_p = &self_p->buf_p[self_p->byte_offset];
+
+    /* Both lanes load 16 bytes, which must be within the window. */
+    for (done = 0;
+         (done + 8 <= count)
+             && (self_p->byte_offset + lane_offset + 16
+                 <= self_p->window_end + WINDOW_SIZE);
+         done += 8) {
+        values = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)src_p)),
+            _mm_loadu_si128((const __m128i *)(src_p + lane_offset)),
+            1);
+        values = _mm256_shuffle_epi8(values, shuffle_mask);
+        values = _mm256_sllv_epi32(values, shift_counts);
+
+        if (is_signed) {
+            values = _mm256_sra_epi32(values, right_shift);
+        } else {
+            values = _mm256_srl_epi32(values, right_shift);
+        }
+
+        switch (item_size) {
+
+        case 2:
+            if (is_signed) {
+                packed = _mm256_packs_epi32(values, values);
+            } else {
+                packed = _mm256_packus_epi32(values, values);
+            }
+
+            packed = _mm256_permute4x64_epi64(packed, 0x08);
+            _mm_storeu_si128((__m128i *)((uint16_t *)dst_p + done),
+                             _mm256_castsi256_si128(packed));
+            break;
+
+        case 4:
+            _mm256_storeu_si256((__m256i *)((uint32_t *)dst_p + done), values);
+            break;
+
+        default:
+            if (is_signed) {
+                packed = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(values));
+                values = _mm256_cvtepi32_epi64(
+                    _mm256_extracti128_si256(values, 1));
+            } else {
+                packed = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(values));
+                values = _mm256_cvtepu32_epi64(
+                    _mm256_extracti128_si256(values, 1));
+            }
+
+            _mm256_storeu_si256((__m256i *)((uint64_t *)dst_p + done), packed);
+            _mm256_storeu_si256((__m256i *)((uint64_t *)dst_p + done + 4),
+                                values);
+            break;
+        }
+
+        src_p += number_of_bits;
+        self_p->byte_offset += number_of_bits;
+    }
+
+    return (done);
+}
+
+#endif
+
+/* Values of at most 56 bits are always within one window. Read
+   values from the window while not too close to the end, and then
+   the rest one by one. */
+#define READ_ARRAY_BITS(type)                                           \
+    i = 0;                                                              \
+                                                                        \
+    if (number_of_bits <= 56) {                                         \
+        position = (8 * self_p->byte_offset + self_p->bit_offset);      \
+        shift = (64 - number_of_bits);                                  \
+                                                                        \
+        while ((i < count) && ((position / 8) <= self_p->window_end)) { \
+            value = bitstream_window_load(&self_p->buf_p[position / 8]); \
+            value = ((value << (position % 8)) >> shift);               \
+            ((type *)dst_p)[i] = (type)((value ^ sign_bit) - sign_bit); \
+            position += number_of_bits;                                 \
+            i++;                                                        \
+        }                                                               \
+                                                                        \
+        self_p->byte_offset = (position / 8);                           \
+        self_p->bit_offset = (int)(position % 8);                       \
+    }                                                                   \
+                                                                        \
+    for (; i < count; i++) {                                            \
+        value = bitstream_reader_read_u64_bits(self_p, number_of_bits); \
+        ((type *)dst_p)[i] = (type)((value ^ sign_bit) - sign_bit);     \
+    }
+
+void bitstream_reader_read_array_bits(struct bitstream_reader_t *self_p,
+                                      void *dst_p,
+                                      int item_size,
+                                      int number_of_bits,
+                                      int is_signed,
+                                      int64_t count)
+{
+    int64_t i;
+    int64_t position;
+    int shift;
+    uint64_t value;
+    uint64_t sign_bit;
+
+#if defined(ISA_AVX2)
+    if ((ISA_LOAD() >= BITSTREAM_ISA_AVX2) && (number_of_bits <= 25)) {
+        i = read_array_bits_avx2(self_p,
+                                 dst_p,
+                                 item_size,
+                                 number_of_bits,
+                                 is_signed,
+                                 count);
+        dst_p = ((uint8_t *)dst_p + i * item_size);
+        count -= i;
+    }
+#endif
+
+    if (is_signed) {
+        sign_bit = (1ull << (number_of_bits - 1));
+    } else {
+        sign_bit = 0;
+    }
+
+    switch (item_size) {
+
+    case 2:
+        READ_ARRAY_BITS(uint16_t);
+        break;
+
+    case 4:
+        READ_ARRAY_BITS(uint32_t);
+        break;
+
+    default:
+        READ_ARRAY_BITS(uint64_t);
+        break;
+    }
+}
+
 void bitstream_reader_seek(struct bitstream_reader_t *self_p,
-                           int offset)
+                           int64_t offset)
 {
     offset += ((8 * self_p->byte_offset) + self_p->bit_offset);
     self_p->byte_offset = (offset / 8);
-    self_p->bit_offset = (offset % 8);
+    self_p->bit_offset = (int)(offset % 8);
 }
 
-int bitstream_reader_tell(struct bitstream_reader_t *self_p)
+int64_t bitstream_reader_tell(struct bitstream_reader_t *self_p)
 {
     return ((8 * self_p->byte_offset) + self_p->bit_offset);
 }
+
+int64_t bitstream_reader_remaining_bits(struct bitstream_reader_t *self_p)
+{
+    return ((8 * self_p->size) - bitstream_reader_tell(self_p));
+}
+
+int bitstream_reader_check(struct bitstream_reader_t *self_p,
+                           int64_t number_of_bits)
+{
+    if ((number_of_bits < 0)
+        || (number_of_bits > bitstream_reader_remaining_bits(self_p))) {
+        return (-1);
+    }
+
+    return (0);
+}
+
+int bitstream_reader_read_u64_bits_checked(struct bitstream_reader_t *self_p,
+                                           uint64_t *value_p,
+                                           int number_of_bits)
+{
+    if (bitstream_reader_check(self_p, number_of_bits) != 0) {
+        return (-1);
+    }
+
+    *value_p = bitstream_reader_read_u64_bits_inline(self_p, number_of_bits);
+
+    return (0);
+}
+
+int bitstream_reader_read_bytes_checked(struct bitstream_reader_t *self_p,
+                                        uint8_t *buf_p,
+                                        int length)
+{
+    if (bitstream_reader_check(self_p, 8 * (int64_t)length) != 0) {
+        return (-1);
+    }
+
+    bitstream_reader_read_bytes(self_p, buf_p, length);
+
+    return (0);
+}
+
+int bitstream_reader_seek_checked(struct bitstream_reader_t *self_p,
+                                  int64_t offset)
+{
+    if ((offset < -bitstream_reader_tell(self_p))
+        || (offset > bitstream_reader_remaining_bits(self_p))) {
+        return (-1);
+    }
+
+    bitstream_reader_seek(self_p, offset);
+
+    return (0);
+}
+
+void bitstream_copy_bits(uint8_t *dst_p,
+                         int64_t dst_offset,
+                         const uint8_t *src_p,
+                         int64_t src_offset,
+                         int64_t number_of_bits)
+{
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    int64_t length;
+    int chunk;
+    int head;
+
+    bitstream_writer_init(&writer, dst_p);
+    bitstream_writer_seek(&writer, dst_offset);
+    bitstream_reader_init(&reader, src_p);
+    bitstream_reader_seek(&reader, src_offset);
+
+    /* Fill the first destination byte if partial. */
+    if ((writer.bit_offset != 0) && (number_of_bits > 0)) {
+        head = (8 - writer.bit_offset);
+
+        if (head > number_of_bits) {
+            head = (int)number_of_bits;
+        }
+
+        bitstream_writer_insert_u64_bits(
+            &writer,
+            bitstream_reader_read_u64_bits(&reader, head),
+            head);
+        number_of_bits -= head;
+    }
+
+    /* Whole destination bytes, a word or vector at a time. */
+    length = (number_of_bits / 8);
+
+    while (length > 0) {
+        chunk = (int)(length < INT_MAX ? length : INT_MAX);
+
+        if (reader.bit_offset == 0) {
+            memcpy(&writer.buf_p[writer.byte_offset],
+                   &reader.buf_p[reader.byte_offset],
+                   chunk);
+        } else {
+            shifted_copy(&writer.buf_p[writer.byte_offset],
+                         &reader.buf_p[reader.byte_offset],
+                         chunk,
+                         reader.bit_offset);
+        }
+
+        writer.byte_offset += chunk;
+        reader.byte_offset += chunk;
+        length -= chunk;
+    }
+
+    number_of_bits %= 8;
+
+    if (number_of_bits > 0) {
+        bitstream_writer_insert_u64_bits(
+            &writer,
+            bitstream_reader_read_u64_bits(&reader, (int)number_of_bits),
+            (int)number_of_bits);
+    }
+}
+
+/* The byte swap kernels reverse the bytes of each item in a vector of
+   items at a time and return the number of swapped bytes. Each item
+   is loaded before stored, so the source and destination may be the
+   same buffer. */
+
+#if defined(ISA_AVX512)
+
+TARGET("avx512bw")
+static int64_t byteswap_avx512(uint8_t *dst_p,
+                               const uint8_t *src_p,
+                               int item_size,
+                               int64_t length)
+{
+    __m512i shuffle;
+    __m512i value;
+    int64_t i;
+
+    if (item_size == 2) {
+        shuffle = _mm512_broadcast_i32x4(
+            _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+    } else if (item_size == 4) {
+        shuffle = _mm512_broadcast_i32x4(
+            _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    } else {
+        shuffle = _mm512_broadcast_i32x4(
+            _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+    }
+
+    for (i = 0; i + 64 <= length; i += 64) {
+        value = _mm512_loadu_si512((const void *)&src_p[i]);
+        _mm512_storeu_si512((void *)&dst_p[i], _mm512_shuffle_epi8(value, shuffle));
+    }
+
+    return (i);
+}
+
+#endif
+
+#if defined(ISA_AVX2)
+
+TARGET("avx2")
+static int64_t byteswap_avx2(uint8_t *dst_p,
+                             const uint8_t *src_p,
+                             int item_size,
+                             int64_t length)
+{
+    __m256i shuffle;
+    __m256i value;
+    int64_t i;
+
+    if (item_size == 2) {
+        shuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                   9, 8, 11, 10, 13, 12, 15, 14,
+                                   1, 0, 3, 2, 5, 4, 7, 6,
+                                   9, 8, 11, 10, 13, 12, 15, 14);
+    } else if (item_size == 4) {
+        shuffle = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                   11, 10, 9, 8, 15, 14, 13, 12,
+                                   3, 2, 1, 0, 7, 6, 5, 4,
+                                   11, 10, 9, 8, 15, 14, 13, 12);
+    } else {
+        shuffle = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+                                   15, 14, 13, 12, 11, 10, 9, 8,
+                                   7, 6, 5, 4, 3, 2, 1, 0,
+                                   15, 14, 13, 12, 11, 10, 9, 8);
+    }
+
+    for (i = 0; i + 32 <= length; i += 32) {
+        value = _mm256_loadu_si256((const __m256i *)&src_p[i]);
+        _mm256_storeu_si256((__m256i *)&dst_p[i],
+                            _mm256_shuffle_epi8(value, shuffle));
+    }
+
+    return (i);
+}
+
+#endif
+
+#if defined(ISA_SSE2)
+
+/* There is no byte shuffle in SSE2, so bytes are swapped in 16 bits
+   lanes and then the lanes are reordered. */
+TARGET("sse2")
+static int64_t byteswap_sse2(uint8_t *dst_p,
+                             const uint8_t *src_p,
+                             int item_size,
+                             int64_t length)
+{
+    __m128i value;
+    int64_t i;
+
+    for (i = 0; i + 16 <= length; i += 16) {
+        value = _mm_loadu_si128((const __m128i *)&src_p[i]);
+        value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+
+        if (item_size == 4) {
+            value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+            value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        } else if (item_size == 8) {
+            value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+            value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(0, 1, 2, 3));
+        }
+
+        _mm_storeu_si128((__m128i *)&dst_p[i], value);
+    }
+
+    return (i);
+}
+
+#endif
+
+void bitstream_byteswap(uint8_t *dst_p,
+                        const uint8_t *src_p,
+                        int item_size,
+                        int64_t count)
+{
+    uint64_t value;
+    int64_t length;
+    int64_t i;
+    int j;
+
+    length = (item_size * count);
+
+    if (item_size == 1) {
+        if (dst_p != src_p) {
+            memcpy(dst_p, src_p, (size_t)length);
+        }
+
+        return;
+    }
+
+    i = 0;
+
+#if defined(ISA_AVX512)
+    if (ISA_LOAD() >= BITSTREAM_ISA_AVX512) {
+        i += byteswap_avx512(&dst_p[i], &src_p[i], item_size, length - i);
+    }
+#endif
+
+#if defined(ISA_AVX2)
+    if (ISA_LOAD() >= BITSTREAM_ISA_AVX2) {
+        i += byteswap_avx2(&dst_p[i], &src_p[i], item_size, length - i);
+    }
+#endif
+
+#if defined(ISA_SSE2)
+    if (ISA_LOAD() >= BITSTREAM_ISA_SSE2) {
+        i += byteswap_sse2(&dst_p[i], &src_p[i], item_size, length - i);
+    }
+#endif
+
+    /* Eight bytes at a time, in any host byte order. */
+    for (; i + 8 <= length; i += 8) {
+        value = bitstream_window_load(&src_p[i]);
+
+        if (item_size == 2) {
+            value = ((value << 32) | (value >> 32));
+            value = (((value & 0x0000ffff0000ffffull) << 16)
+                     | ((value >> 16) & 0x0000ffff0000ffffull));
+        } else if (item_size == 4) {
+            value = ((value << 32) | (value >> 32));
+        }
+
+        bitstream_window_store_le(&dst_p[i], value);
+    }
+
+    for (; i < length; i += item_size) {
+        for (j = 0; j < item_size / 2; j++) {
+            value = src_p[i + j];
+            dst_p[i + j] = src_p[i + item_size - 1 - j];
+            dst_p[i + item_size - 1 - j] = (uint8_t)value;
+        }
+    }
+}
+
+#if defined(ISA_AVX2)
+
+/* As many whole records as fit in 16 bytes are shuffled at a time if
+   they are adjacent. The remaining bytes of each store are rewritten
+   as loaded, and by the next store if not in place. Returns the number
+   of reordered records. */
+TARGET("avx2")
+static int64_t byteswap_records_avx2(uint8_t *dst_p,
+                                     const uint8_t *src_p,
+                                     const uint8_t *mask_p,
+                                     int size,
+                                     int64_t stride,
+                                     int64_t count)
+{
+    uint8_t shuffle[16];
+    __m128i shuffle_mask;
+    __m128i value;
+    int64_t length;
+    int64_t i;
+    int records_per_shuffle;
+    int j;
+
+    if (stride == size) {
+        records_per_shuffle = (16 / size);
+    } else if (dst_p == src_p) {
+        records_per_shuffle = 1;
+    } else {
+        return (0);
+    }
+
+    for (j = 0; j < 16; j++) {
+        if (j < records_per_shuffle * size) {
+            shuffle[j] = (uint8_t)((j / size) * size + mask_p[j % size]);
+        } else {
+            shuffle[j] = (uint8_t)j;
+        }
+    }
+
+    shuffle_mask = _mm_loadu_si128((const __m128i *)&shuffle[0]);
+    length = ((count - 1) * stride + size);
+
+    for (i = 0; i * stride + 16 <= length; i += records_per_shuffle) {
+        value = _mm_loadu_si128((const __m128i *)&src_p[i * stride]);
+        _mm_storeu_si128((__m128i *)&dst_p[i * stride],
+                         _mm_shuffle_epi8(value, shuffle_mask));
+    }
+
+    return (i);
+}
+
+#endif
+
+void bitstream_byteswap_records(uint8_t *dst_p,
+                                const uint8_t *src_p,
+                                const uint8_t *mask_p,
+                                int size,
+                                int64_t stride,
+                                int64_t count)
+{
+    uint8_t record[BITSTREAM_BYTESWAP_RECORD_MAX_SIZE];
+    int64_t i;
+    int j;
+
+    if (count == 0) {
+        return;
+    }
+
+    i = 0;
+
+#if defined(ISA_AVX2)
+    if (ISA_LOAD() >= BITSTREAM_ISA_AVX2) {
+        i += byteswap_records_avx2(dst_p, src_p, mask_p, size, stride, count);
+    }
+#endif
+
+    for (; i < count; i++) {
+        memcpy(&record[0], &src_p[i * stride], (size_t)size);
+
+        for (j = 0; j < size; j++) {
+            dst_p[i * stride + j] = record[mask_p[j]];
+        }
+    }
+}
+
+static uint8_t reverse_u8_bits(uint8_t value)
+{
+    value = (uint8_t)(((value >> 1) & 0x55) | ((value & 0x55) << 1));
+    value = (uint8_t)(((value >> 2) & 0x33) | ((value & 0x33) << 2));
+    value = (uint8_t)((value >> 4) | (value << 4));
+
+    return (value);
+}
+
+uint64_t bitstream_reverse_u64_bits(uint64_t value, int number_of_bits)
+{
+    if (number_of_bits == 0) {
+        return (0);
+    }
+
+    value = (((value >> 1) & 0x5555555555555555ull)
+             | ((value & 0x5555555555555555ull) << 1));
+    value = (((value >> 2) & 0x3333333333333333ull)
+             | ((value & 0x3333333333333333ull) << 2));
+    value = (((value >> 4) & 0x0f0f0f0f0f0f0f0full)
+             | ((value & 0x0f0f0f0f0f0f0f0full) << 4));
+    value = (((value >> 8) & 0x00ff00ff00ff00ffull)
+             | ((value & 0x00ff00ff00ff00ffull) << 8));
+    value = (((value >> 16) & 0x0000ffff0000ffffull)
+             | ((value & 0x0000ffff0000ffffull) << 16));
+    value = ((value >> 32) | (value << 32));
+
+    return (value >> (64 - number_of_bits));
+}
+
+void bitstream_reverse_bytes_bits(uint8_t *buf_p, int length)
+{
+    int i;
+    uint8_t value;
+
+    for (i = 0; i < length / 2; i++) {
+        value = reverse_u8_bits(buf_p[i]);
+        buf_p[i] = reverse_u8_bits(buf_p[length - i - 1]);
+        buf_p[length - i - 1] = value;
+    }
+
+    if ((length % 2) != 0) {
+        buf_p[length / 2] = reverse_u8_bits(buf_p[length / 2]);
+    }
+}
+
+/* Number of leading zero bits. The value must not be zero. */
+static int clz64(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (__builtin_clzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+
+    _BitScanReverse64(&index, value);
+
+    return (63 - (int)index);
+#else
+    int count;
+
+    count = 0;
+
+    while ((value & 0x8000000000000000ull) == 0) {
+        value <<= 1;
+        count++;
+    }
+
+    return (count);
+#endif
+}
+
+static int bit_length(uint64_t value)
+{
+    if (value == 0) {
+        return (0);
+    }
+
+    return (64 - clz64(value));
+}
+
+/* Signed Exp-Golomb codes are unsigned codes of 1, -1, 2, -2, ...
+   mapped to 1, 2, 3, 4, ... */
+static uint64_t exp_golomb_from_signed(int64_t value)
+{
+    if (value > 0) {
+        return (2 * (uint64_t)value - 1);
+    }
+
+    return (2 * (0 - (uint64_t)value));
+}
+
+static int64_t exp_golomb_to_signed(uint64_t value)
+{
+    if ((value & 1) != 0) {
+        return ((int64_t)(value / 2 + 1));
+    }
+
+    return (-(int64_t)(value / 2));
+}
+
+int bitstream_exp_golomb_size(uint64_t value)
+{
+    return (2 * bit_length(value + 1) - 1);
+}
+
+int bitstream_exp_golomb_signed_size(int64_t value)
+{
+    return (bitstream_exp_golomb_size(exp_golomb_from_signed(value)));
+}
+
+void bitstream_writer_write_exp_golomb(struct bitstream_writer_t *self_p,
+                                       uint64_t value)
+{
+    int number_of_bits;
+
+    value++;
+    number_of_bits = bit_length(value);
+
+    /* The leading zeros are part of the value if it fits. */
+    if (number_of_bits <= 32) {
+        bitstream_writer_write_u64_bits_inline(self_p,
+                                               value,
+                                               2 * number_of_bits - 1);
+    } else {
+        bitstream_writer_write_u64_bits_inline(self_p, 0, number_of_bits - 1);
+        bitstream_writer_write_u64_bits_inline(self_p, value, number_of_bits);
+    }
+}
+
+void bitstream_writer_write_exp_golomb_signed(struct bitstream_writer_t *self_p,
+                                              int64_t value)
+{
+    bitstream_writer_write_exp_golomb(self_p, exp_golomb_from_signed(value));
+}
+
+int bitstream_reader_read_exp_golomb(struct bitstream_reader_t *self_p,
+                                     uint64_t *value_p)
+{
+    int64_t remaining;
+    uint64_t window;
+    int number_of_bits;
+    int zeros;
+    int rest;
+
+    remaining = bitstream_reader_remaining_bits(self_p);
+    zeros = 0;
+
+    /* Count leading zeros a window at a time. */
+    while (1) {
+        number_of_bits = (int)(remaining - zeros < 64 ? remaining - zeros : 64);
+
+        if (number_of_bits <= 0) {
+            bitstream_reader_seek(self_p, -zeros);
+
+            return (-1);
+        }
+
+        window = bitstream_reader_read_u64_bits_inline(self_p, number_of_bits);
+
+        if (window != 0) {
+            break;
+        }
+
+        zeros += number_of_bits;
+
+        if (zeros >= 64) {
+            bitstream_reader_seek(self_p, -zeros);
+
+            return (-2);
+        }
+    }
+
+    /* Bits read from the first one. */
+    rest = (64 - clz64(window));
+    zeros += (number_of_bits - rest);
+
+    if (zeros >= 64) {
+        bitstream_reader_seek(self_p, -(zeros + rest));
+
+        return (-2);
+    }
+
+    /* Common case, the value is in the window. */
+    if (zeros + 1 <= rest) {
+        bitstream_reader_seek(self_p, -(rest - (zeros + 1)));
+        *value_p = ((window >> (rest - (zeros + 1))) - 1);
+
+        return (0);
+    }
+
+    bitstream_reader_seek(self_p, -rest);
+
+    if (remaining - zeros < zeros + 1) {
+        bitstream_reader_seek(self_p, -zeros);
+
+        return (-1);
+    }
+
+    *value_p = (bitstream_reader_read_u64_bits_inline(self_p, zeros + 1) - 1);
+
+    return (0);
+}
+
+int bitstream_reader_read_exp_golomb_signed(struct bitstream_reader_t *self_p,
+                                            int64_t *value_p)
+{
+    uint64_t value;
+    int res;
+
+    res = bitstream_reader_read_exp_golomb(self_p, &value);
+
+    if (res == 0) {
+        *value_p = exp_golomb_to_signed(value);
+    }
+
+    return (res);
+}
+
+int bitstream_leb128_size(uint64_t value)
+{
+    int length;
+
+    length = ((bit_length(value) + 6) / 7);
+
+    return (8 * (length > 0 ? length : 1));
+}
+
+int bitstream_sleb128_size(int64_t value)
+{
+    if (value < 0) {
+        value = ~value;
+    }
+
+    /* Plus one for the sign bit. */
+    return (8 * ((bit_length((uint64_t)value) + 7) / 7));
+}
+
+/* Write given bytes, first byte in the most significant byte. */
+static void write_leb128_bytes(struct bitstream_writer_t *self_p,
+                               uint64_t bytes,
+                               int length)
+{
+    bitstream_writer_write_u64_bits_inline(self_p, bytes, 8 * length);
+}
+
+void bitstream_writer_write_leb128(struct bitstream_writer_t *self_p,
+                                   uint64_t value)
+{
+    uint64_t bytes;
+    int length;
+
+    bytes = 0;
+    length = 0;
+
+    while (value >= 0x80) {
+        if (length == 8) {
+            write_leb128_bytes(self_p, bytes, length);
+            bytes = 0;
+            length = 0;
+        }
+
+        bytes = ((bytes << 8) | 0x80 | (value & 0x7f));
+        length++;
+        value >>= 7;
+    }
+
+    if (length == 8) {
+        write_leb128_bytes(self_p, bytes, length);
+        bytes = 0;
+        length = 0;
+    }
+
+    write_leb128_bytes(self_p, (bytes << 8) | value, length + 1);
+}
+
+void bitstream_writer_write_sleb128(struct bitstream_writer_t *self_p,
+                                    int64_t value)
+{
+    uint64_t bytes;
+    uint64_t byte;
+    int length;
+
+    bytes = 0;
+    length = 0;
+
+    while (1) {
+        byte = ((uint64_t)value & 0x7f);
+        /* Arithmetic shift, also for negative values. */
+        value = (value < 0 ? ~(~value >> 7) : value >> 7);
+
+        if (((value == 0) && ((byte & 0x40) == 0))
+            || ((value == -1) && ((byte & 0x40) != 0))) {
+            break;
+        }
+
+        if (length == 8) {
+            write_leb128_bytes(self_p, bytes, length);
+            bytes = 0;
+            length = 0;
+        }
+
+        bytes = ((bytes << 8) | 0x80 | byte);
+        length++;
+    }
+
+    if (length == 8) {
+        write_leb128_bytes(self_p, bytes, length);
+        bytes = 0;
+        length = 0;
+    }
+
+    write_leb128_bytes(self_p, (bytes << 8) | byte, length + 1);
+}
+
+/* Read the bytes of a code, at most ten. The value is truncated to 64
+   bits. Returns zero on success, -1 if short and -2 if longer than
+   ten bytes. */
+static int read_leb128(struct bitstream_reader_t *self_p,
+                       uint64_t *value_p,
+                       int *length_p,
+                       uint8_t *last_p)
+{
+    int64_t remaining;
+    uint64_t window;
+    uint64_t ends;
+    uint64_t value;
+    uint8_t byte;
+    int length;
+    int i;
+
+    remaining = bitstream_reader_remaining_bits(self_p);
+
+    /* Find the last byte of codes of up to eight bytes with a single
+       window load, as its continuation bit is clear. */
+    if (remaining >= 64) {
+        window = bitstream_reader_read_u64_bits_inline(self_p, 64);
+        ends = (~window & 0x8080808080808080ull);
+
+        if (ends != 0) {
+            length = (clz64(ends) / 8 + 1);
+            bitstream_reader_seek(self_p, -(64 - 8 * length));
+            value = 0;
+
+            for (i = 0; i < length; i++) {
+                value |= (((window >> (56 - 8 * i)) & 0x7f) << (7 * i));
+            }
+
+            *value_p = value;
+            *length_p = length;
+            *last_p = (uint8_t)(window >> (64 - 8 * length));
+
+            return (0);
+        }
+
+        bitstream_reader_seek(self_p, -64);
+    }
+
+    value = 0;
+
+    for (i = 0; i < 10; i++) {
+        if (remaining < 8 * (i + 1)) {
+            bitstream_reader_seek(self_p, -8 * i);
+
+            return (-1);
+        }
+
+        byte = (uint8_t)bitstream_reader_read_u64_bits_inline(self_p, 8);
+        value |= ((uint64_t)(byte & 0x7f) << (7 * i));
+
+        if ((byte & 0x80) == 0) {
+            *value_p = value;
+            *length_p = (i + 1);
+            *last_p = byte;
+
+            return (0);
+        }
+    }
+
+    bitstream_reader_seek(self_p, -80);
+
+    return (-2);
+}
+
+int bitstream_reader_read_leb128(struct bitstream_reader_t *self_p,
+                                 uint64_t *value_p)
+{
+    int res;
+    int length;
+    uint8_t last;
+
+    res = read_leb128(self_p, value_p, &length, &last);
+
+    if (res != 0) {
+        return (res);
+    }
+
+    /* Only the lowest bit of a tenth byte fits. */
+    if ((length == 10) && (last > 1)) {
+        bitstream_reader_seek(self_p, -80);
+
+        return (-2);
+    }
+
+    return (0);
+}
+
+int bitstream_reader_read_sleb128(struct bitstream_reader_t *self_p,
+                                  int64_t *value_p)
+{
+    uint64_t value;
+    int res;
+    int length;
+    uint8_t last;
+
+    res = read_leb128(self_p, &value, &length, &last);
+
+    if (res != 0) {
+        return (res);
+    }
+
+    if (length < 10) {
+        if ((last & 0x40) != 0) {
+            value |= (UINT64_MAX << (7 * length));
+        }
+    } else if ((last != 0x00) && (last != 0x7f)) {
+        /* Bits above the 64th must be copies of it. */
+        bitstream_reader_seek(self_p, -80);
+
+        return (-2);
+    }
+
+    *value_p = (int64_t)value;
+
+    return (0);
+}
+
+static uint32_t prefix_code_left_aligned(
+    const struct bitstream_prefix_code_entry_t *entry_p)
+{
+    return (entry_p->code << (32 - entry_p->length));
+}
+
+static int prefix_code_compare(const void *left_p, const void *right_p)
+{
+    const struct bitstream_prefix_code_entry_t *left_entry_p;
+    const struct bitstream_prefix_code_entry_t *right_entry_p;
+    uint32_t left;
+    uint32_t right;
+
+    left_entry_p = left_p;
+    right_entry_p = right_p;
+    left = prefix_code_left_aligned(left_entry_p);
+    right = prefix_code_left_aligned(right_entry_p);
+
+    if (left != right) {
+        return (left < right ? -1 : 1);
+    }
+
+    return (left_entry_p->length - right_entry_p->length);
+}
+
+int bitstream_prefix_code_init(struct bitstream_prefix_code_t *self_p,
+                               struct bitstream_prefix_code_entry_t *entries_p,
+                               int number_of_entries)
+{
+    struct bitstream_prefix_code_entry_t *entry_p;
+    uint32_t first;
+    uint32_t entry;
+    int shift;
+    int i;
+
+    if (number_of_entries < 1) {
+        return (-1);
+    }
+
+    self_p->max_length = 0;
+
+    for (i = 0; i < number_of_entries; i++) {
+        entry_p = &entries_p[i];
+
+        if ((entry_p->length < 1) || (entry_p->length > 32)) {
+            return (-1);
+        }
+
+        if ((entry_p->length < 32) && ((entry_p->code >> entry_p->length) != 0)) {
+            return (-1);
+        }
+
+        if (entry_p->symbol >= (1u << 24)) {
+            return (-1);
+        }
+
+        if (entry_p->length > self_p->max_length) {
+            self_p->max_length = entry_p->length;
+        }
+    }
+
+    /* In this order a code can only be a prefix of the next code. */
+    qsort(entries_p, number_of_entries, sizeof(*entries_p), prefix_code_compare);
+
+    for (i = 0; i < number_of_entries - 1; i++) {
+        entry_p = &entries_p[i];
+        shift = (32 - entry_p->length);
+
+        if ((prefix_code_left_aligned(&entries_p[i + 1]) >> shift)
+            == (prefix_code_left_aligned(entry_p) >> shift)) {
+            return (-1);
+        }
+    }
+
+    memset(&self_p->lookup[0], 0, sizeof(self_p->lookup));
+
+    for (i = 0; i < number_of_entries; i++) {
+        entry_p = &entries_p[i];
+
+        if (entry_p->length > BITSTREAM_PREFIX_CODE_LOOKUP_BITS) {
+            continue;
+        }
+
+        shift = (BITSTREAM_PREFIX_CODE_LOOKUP_BITS - entry_p->length);
+        first = (entry_p->code << shift);
+        entry = ((entry_p->symbol << 8) | (uint32_t)entry_p->length);
+
+        while ((first >> shift) == entry_p->code) {
+            self_p->lookup[first] = entry;
+            first++;
+        }
+    }
+
+    self_p->entries_p = entries_p;
+    self_p->number_of_entries = number_of_entries;
+
+    return (0);
+}
+
+/* Binary search for the code at the start of given window among codes
+   sorted as left aligned. Returns its length, or zero if not found. */
+static int prefix_code_find(const struct bitstream_prefix_code_t *self_p,
+                            uint64_t window,
+                            uint32_t *symbol_p)
+{
+    const struct bitstream_prefix_code_entry_t *entry_p;
+    uint32_t bits;
+    int low;
+    int high;
+    int middle;
+
+    bits = (uint32_t)(window >> 32);
+    low = 0;
+    high = self_p->number_of_entries;
+
+    while ((high - low) > 1) {
+        middle = ((low + high) / 2);
+
+        if (prefix_code_left_aligned(&self_p->entries_p[middle]) <= bits) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    entry_p = &self_p->entries_p[low];
+
+    if (((bits ^ prefix_code_left_aligned(entry_p)) >> (32 - entry_p->length))
+        != 0) {
+        return (0);
+    }
+
+    *symbol_p = entry_p->symbol;
+
+    return (entry_p->length);
+}
+
+/* Decode the code at the start of given window. Returns its length,
+   or zero if not a code. */
+static inline int prefix_code_decode(const struct bitstream_prefix_code_t *self_p,
+                                     uint64_t window,
+                                     uint32_t *symbol_p)
+{
+    uint32_t entry;
+
+    entry = self_p->lookup[window >> (64 - BITSTREAM_PREFIX_CODE_LOOKUP_BITS)];
+
+    if (entry != 0) {
+        *symbol_p = (entry >> 8);
+
+        return (entry & 0xff);
+    }
+
+    return (prefix_code_find(self_p, window, symbol_p));
+}
+
+int bitstream_reader_read_prefix_code(struct bitstream_reader_t *self_p,
+                                      const struct bitstream_prefix_code_t *code_p,
+                                      uint32_t *symbol_p)
+{
+    int64_t remaining;
+    uint64_t window;
+    int number_of_bits;
+    int length;
+
+    remaining = bitstream_reader_remaining_bits(self_p);
+
+    if (remaining <= 0) {
+        return (-1);
+    }
+
+    number_of_bits = (int)(remaining < code_p->max_length
+                           ? remaining
+                           : code_p->max_length);
+    window = (bitstream_reader_read_u64_bits_inline(self_p, number_of_bits)
+              << (64 - number_of_bits));
+    length = prefix_code_decode(code_p, window, symbol_p);
+
+    if (length == 0) {
+        bitstream_reader_seek(self_p, -number_of_bits);
+
+        return (number_of_bits < code_p->max_length ? -1 : -2);
+    }
+
+    if (length > number_of_bits) {
+        bitstream_reader_seek(self_p, -number_of_bits);
+
+        return (-1);
+    }
+
+    bitstream_reader_seek(self_p, length - number_of_bits);
+
+    return (0);
+}
+
+static inline void store_symbol(void *dst_p,
+                                int item_size,
+                                int64_t index,
+                                uint32_t symbol)
+{
+    if (item_size == 2) {
+        ((uint16_t *)dst_p)[index] = (uint16_t)symbol;
+    } else {
+        ((uint32_t *)dst_p)[index] = symbol;
+    }
+}
+
+int bitstream_reader_read_prefix_codes(struct bitstream_reader_t *self_p,
+                                       const struct bitstream_prefix_code_t *code_p,
+                                       void *dst_p,
+                                       int item_size,
+                                       int64_t count)
+{
+    uint64_t window;
+    uint32_t symbol;
+    int64_t i;
+    int available;
+    int used;
+    int length;
+    int res;
+
+    i = 0;
+
+    /* Decode as many codes as fit in each window load. */
+    while ((i < count) && (self_p->byte_offset <= self_p->window_end)) {
+        window = (bitstream_window_load(&self_p->buf_p[self_p->byte_offset])
+                  << self_p->bit_offset);
+        available = (64 - self_p->bit_offset);
+        used = 0;
+
+        while ((i < count) && (used + code_p->max_length <= available)) {
+            length = prefix_code_decode(code_p, window << used, &symbol);
+
+            if (length == 0) {
+                bitstream_reader_seek(self_p, used);
+
+                return (-2);
+            }
+
+            store_symbol(dst_p, item_size, i, symbol);
+            used += length;
+            i++;
+        }
+
+        bitstream_reader_seek(self_p, used);
+    }
+
+    for (; i < count; i++) {
+        res = bitstream_reader_read_prefix_code(self_p, code_p, &symbol);
+
+        if (res != 0) {
+            return (res);
+        }
+
+        store_symbol(dst_p, item_size, i, symbol);
+    }
+
+    return (0);
+}
+
+int bitstream_isa_detect(void)
+{
+#if defined(ISA_DISPATCH)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512bw")) {
+        return (BITSTREAM_ISA_AVX512);
+    } else if (__builtin_cpu_supports("avx2")) {
+        return (BITSTREAM_ISA_AVX2);
+    } else if (__builtin_cpu_supports("sse2")) {
+        return (BITSTREAM_ISA_SSE2);
+    } else {
+        return (BITSTREAM_ISA_SCALAR);
+    }
+#else
+    return (ISA_COMPILED);
+#endif
+}
+
+int bitstream_isa_set(int value)
+{
+    if ((value < BITSTREAM_ISA_SCALAR) || (value > bitstream_isa_detect())) {
+        return (-1);
+    }
+
+    ISA_STORE(value);
+
+    return (0);
+}
+
+int bitstream_isa_get(void)
+{
+    return (ISA_LOAD());
+}
@@ -28,27 +28,32 @@
 #define BITSTREAM_H
 
 #include <stdint.h>
+#include <string.h>
 
 #define BITSTREAM_VERSION "0.8.0"
 
 struct bitstream_writer_t {
     uint8_t *buf_p;
-    int byte_offset;
+    int64_t byte_offset;
     int bit_offset;
+    int64_t window_end;
+    int64_t size;
 };
 
 struct bitstream_writer_bounds_t {
     struct bitstream_writer_t *writer_p;
-    int first_byte_offset;
+    int64_t first_byte_offset;
     uint8_t first_byte;
-    int last_byte_offset;
+    int64_t last_byte_offset;
     uint8_t last_byte;
 };
 
 struct bitstream_reader_t {
     const uint8_t *buf_p;
-    int byte_offset;
+    int64_t byte_offset;
     int bit_offset;
+    int64_t window_end;
+    int64_t size;
 };
 
 /*
@@ -58,9 +63,16 @@ struct bitstream_reader_t {
 void bitstream_writer_init(struct bitstream_writer_t *self_p,
                            uint8_t *buf_p);
 
-int bitstream_writer_size_in_bits(struct bitstream_writer_t *self_p);
+/* Initialize in 64 bits window mode, where bits are written using
+   eight bytes wide loads and stores. The buffer must be given size
+   in bytes. Bytes after the last written byte are left unmodified. */
+void bitstream_writer_init_window(struct bitstream_writer_t *self_p,
+                                  uint8_t *buf_p,
+                                  int64_t size);
 
-int bitstream_writer_size_in_bytes(struct bitstream_writer_t *self_p);
+int64_t bitstream_writer_size_in_bits(struct bitstream_writer_t *self_p);
+
+int64_t bitstream_writer_size_in_bytes(struct bitstream_writer_t *self_p);
 
 /* Write bits to the stream. Clears each byte before bits are
    written. */
@@ -83,11 +95,50 @@ void bitstream_writer_write_u32(struct bitstream_writer_t *self_p,
 void bitstream_writer_write_u64(struct bitstream_writer_t *self_p,
                                 uint64_t value);
 
-/* Upper unused bits must be zero. */
+/* Upper unused bits must be zero. See also
+   bitstream_writer_write_u64_bits_inline(). */
 void bitstream_writer_write_u64_bits(struct bitstream_writer_t *self_p,
                                      uint64_t value,
                                      int number_of_bits);
 
+/* Same as above, but one byte at a time, also in window mode. */
+void bitstream_writer_write_u64_bits_bytes(struct bitstream_writer_t *self_p,
+                                           uint64_t value,
+                                           int number_of_bits);
+
+/* Write bits with least significant bit first, that is, in the bit
+   order of bitstruct's '<' format. Upper unused bits must be zero. See
+   also bitstream_writer_write_u64_bits_le_inline(). */
+void bitstream_writer_write_u64_bits_le(struct bitstream_writer_t *self_p,
+                                        uint64_t value,
+                                        int number_of_bits);
+
+/* Same as above, but one byte at a time, also in window mode. */
+void bitstream_writer_write_u64_bits_le_bytes(struct bitstream_writer_t *self_p,
+                                              uint64_t value,
+                                              int number_of_bits);
+
+/* Write bits with least significant byte first. The first chunk
+   written fills the current byte, followed by full bytes and then
+   the most significant bits. Upper unused bits must be zero. */
+void bitstream_writer_write_u64_bits_lsb_byte_first(
+    struct bitstream_writer_t *self_p,
+    uint64_t value,
+    int number_of_bits);
+
+/* Write given number of values of given width in bits from an array
+   of 1, 2, 4 or 8 bytes integers, signed if is_item_signed is
+   non-zero. All values are range checked against the field width and
+   signedness before anything is written. Returns -1 on success and
+   the index of the first out of range value otherwise. */
+int64_t bitstream_writer_write_array_bits(struct bitstream_writer_t *self_p,
+                                          const void *src_p,
+                                          int item_size,
+                                          int is_item_signed,
+                                          int number_of_bits,
+                                          int is_signed,
+                                          int64_t count);
+
 void bitstream_writer_write_repeated_bit(struct bitstream_writer_t *self_p,
                                          int value,
                                          int length);
@@ -124,17 +175,37 @@ void bitstream_writer_insert_u64_bits(struct bitstream_writer_t *self_p,
    smaller. Use write with care after seek, as seek does not clear
    bytes. */
 void bitstream_writer_seek(struct bitstream_writer_t *self_p,
-                           int offset);
+                           int64_t offset);
 
 /* Save-restore first and last bytes in given range, so write can be
    used in given range. */
 void bitstream_writer_bounds_save(struct bitstream_writer_bounds_t *self_p,
                                   struct bitstream_writer_t *writer_p,
-                                  int bit_offset,
+                                  int64_t bit_offset,
                                   int length);
 
 void bitstream_writer_bounds_restore(struct bitstream_writer_bounds_t *self_p);
 
+/* Get the number of bits from the write position to the end of the
+   buffer. Writers initialized without a size are unbounded. */
+int64_t bitstream_writer_remaining_bits(struct bitstream_writer_t *self_p);
+
+/* Check that given number of bits fits before the end of the buffer,
+   typically once before writing a batch of fields with the unchecked
+   functions. Returns zero if so and -1 otherwise. */
+int bitstream_writer_check(struct bitstream_writer_t *self_p,
+                           int64_t number_of_bits);
+
+/* Write bits if they fit before the end of the buffer. Returns zero
+   on success and -1 without writing anything otherwise. */
+int bitstream_writer_write_u64_bits_checked(struct bitstream_writer_t *self_p,
+                                            uint64_t value,
+                                            int number_of_bits);
+
+int bitstream_writer_write_bytes_checked(struct bitstream_writer_t *self_p,
+                                         const uint8_t *buf_p,
+                                         int length);
+
 /*
  * The reader.
  */
@@ -142,6 +213,12 @@ void bitstream_writer_bounds_restore(struct bitstream_writer_bounds_t *self_p);
 void bitstream_reader_init(struct bitstream_reader_t *self_p,
                            const uint8_t *buf_p);
 
+/* Initialize in 64 bits window mode, where bits are read using eight
+   bytes wide loads. The buffer must be given size in bytes. */
+void bitstream_reader_init_window(struct bitstream_reader_t *self_p,
+                                  const uint8_t *buf_p,
+                                  int64_t size);
+
 /* Read bits from the stream. */
 int bitstream_reader_read_bit(struct bitstream_reader_t *self_p);
 
@@ -157,14 +234,519 @@ uint32_t bitstream_reader_read_u32(struct bitstream_reader_t *self_p);
 
 uint64_t bitstream_reader_read_u64(struct bitstream_reader_t *self_p);
 
+/* See also bitstream_reader_read_u64_bits_inline(). */
 uint64_t bitstream_reader_read_u64_bits(struct bitstream_reader_t *self_p,
                                         int number_of_bits);
 
+/* Same as above, but one byte at a time, also in window mode. */
+uint64_t bitstream_reader_read_u64_bits_bytes(struct bitstream_reader_t *self_p,
+                                              int number_of_bits);
+
+/* Read bits written with least significant bit first. See also
+   bitstream_reader_read_u64_bits_le_inline(). */
+uint64_t bitstream_reader_read_u64_bits_le(struct bitstream_reader_t *self_p,
+                                           int number_of_bits);
+
+/* Same as above, but one byte at a time, also in window mode. */
+uint64_t bitstream_reader_read_u64_bits_le_bytes(
+    struct bitstream_reader_t *self_p,
+    int number_of_bits);
+
+/* Read bits written with least significant byte first. */
+uint64_t bitstream_reader_read_u64_bits_lsb_byte_first(
+    struct bitstream_reader_t *self_p,
+    int number_of_bits);
+
+/* Read given number of values of given width in bits into an array
+   of uint16_t, uint32_t or uint64_t, that is, item size 2, 4 or 8
+   bytes. Signed values are sign extended. Values of at most 25 bits
+   are read eight at a time with AVX2 if selected in window mode. */
+void bitstream_reader_read_array_bits(struct bitstream_reader_t *self_p,
+                                      void *dst_p,
+                                      int item_size,
+                                      int number_of_bits,
+                                      int is_signed,
+                                      int64_t count);
+
 /* Move read position. */
 void bitstream_reader_seek(struct bitstream_reader_t *self_p,
-                           int offset);
+                           int64_t offset);
 
 /* Get read position. */
-int bitstream_reader_tell(struct bitstream_reader_t *self_p);
+int64_t bitstream_reader_tell(struct bitstream_reader_t *self_p);
+
+/* Get the number of bits from the read position to the end of the
+   buffer. Readers initialized without a size are unbounded. */
+int64_t bitstream_reader_remaining_bits(struct bitstream_reader_t *self_p);
+
+/* Check that given number of bits can be read before the end of the
+   buffer, typically once before reading a batch of fields with the
+   unchecked functions. Returns zero if so and -1 otherwise. */
+int bitstream_reader_check(struct bitstream_reader_t *self_p,
+                           int64_t number_of_bits);
+
+/* Read bits if available before the end of the buffer. Returns zero
+   on success and -1 without moving the read position otherwise. */
+int bitstream_reader_read_u64_bits_checked(struct bitstream_reader_t *self_p,
+                                           uint64_t *value_p,
+                                           int number_of_bits);
+
+int bitstream_reader_read_bytes_checked(struct bitstream_reader_t *self_p,
+                                        uint8_t *buf_p,
+                                        int length);
+
+/* Move read position within the buffer. Returns zero on success and
+   -1 without moving otherwise. */
+int bitstream_reader_seek_checked(struct bitstream_reader_t *self_p,
+                                  int64_t offset);
+
+/*
+ * Copy.
+ */
+
+/* Copy given number of bits from source bit offset to destination bit
+   offset, most significant bit first. All other destination bits are
+   left unmodified. The source and destination bytes must not
+   overlap. */
+void bitstream_copy_bits(uint8_t *dst_p,
+                         int64_t dst_offset,
+                         const uint8_t *src_p,
+                         int64_t src_offset,
+                         int64_t number_of_bits);
+
+/*
+ * Byte swap.
+ */
+
+/* Reverse the byte order of given number of items of 1, 2, 4 or 8
+   bytes each, 64 bytes at a time with AVX-512, 32 with AVX2 and 16
+   with SSE2 if selected. The source and destination may be the same
+   buffer, but must not overlap otherwise. */
+void bitstream_byteswap(uint8_t *dst_p,
+                        const uint8_t *src_p,
+                        int item_size,
+                        int64_t count);
+
+#define BITSTREAM_BYTESWAP_RECORD_MAX_SIZE 16
+
+/* Reorder the first size bytes, at most
+   BITSTREAM_BYTESWAP_RECORD_MAX_SIZE, of given number of records
+   stride bytes apart, where byte i of each destination record is byte
+   mask_p[i] of the source record. Other bytes of the destination are
+   left as is. Records are reordered with one byte shuffle per 16 bytes
+   with AVX2 or AVX-512 if selected, which for a stride larger than size
+   requires the source and destination to be the same buffer. They must
+   not overlap otherwise. */
+void bitstream_byteswap_records(uint8_t *dst_p,
+                                const uint8_t *src_p,
+                                const uint8_t *mask_p,
+                                int size,
+                                int64_t stride,
+                                int64_t count);
+
+/*
+ * Variable length integers.
+ */
+
+/* Size in bits of given value as an Exp-Golomb code, as ue(v) and
+   se(v) in H.264. Unsigned values must be less than UINT64_MAX and
+   signed values greater than INT64_MIN. */
+int bitstream_exp_golomb_size(uint64_t value);
+
+int bitstream_exp_golomb_signed_size(int64_t value);
+
+void bitstream_writer_write_exp_golomb(struct bitstream_writer_t *self_p,
+                                       uint64_t value);
+
+void bitstream_writer_write_exp_golomb_signed(struct bitstream_writer_t *self_p,
+                                              int64_t value);
+
+/* Read an Exp-Golomb code, counting its leading zeros a 64 bits
+   window at a time. May read up to eight bytes after the code, but
+   never past the size given to bitstream_reader_init_window(). Returns
+   zero on success, -1 if the data is short and -2 if the code has 64
+   or more leading zeros. The read position is only moved on
+   success. */
+int bitstream_reader_read_exp_golomb(struct bitstream_reader_t *self_p,
+                                     uint64_t *value_p);
+
+int bitstream_reader_read_exp_golomb_signed(struct bitstream_reader_t *self_p,
+                                            int64_t *value_p);
+
+/* Size in bits of given value as an unsigned or signed LEB128 code,
+   seven bits per byte starting with the least significant, and the
+   most significant bit of each byte set if more bytes follow. */
+int bitstream_leb128_size(uint64_t value);
+
+int bitstream_sleb128_size(int64_t value);
+
+void bitstream_writer_write_leb128(struct bitstream_writer_t *self_p,
+                                   uint64_t value);
+
+void bitstream_writer_write_sleb128(struct bitstream_writer_t *self_p,
+                                    int64_t value);
+
+/* Read a LEB128 code, finding the last byte of codes of up to eight
+   bytes in a single window load. Reads ahead as the Exp-Golomb reader
+   above. Returns zero on success, -1 if the
+   data is short and -2 if the code does not fit in 64 bits. The read
+   position is only moved on success. */
+int bitstream_reader_read_leb128(struct bitstream_reader_t *self_p,
+                                 uint64_t *value_p);
+
+int bitstream_reader_read_sleb128(struct bitstream_reader_t *self_p,
+                                  int64_t *value_p);
+
+/*
+ * Prefix codes.
+ */
+
+/* Codes of up to this many bits are decoded with a single table
+   lookup, and longer codes with a binary search. */
+#define BITSTREAM_PREFIX_CODE_LOOKUP_BITS 10
+
+struct bitstream_prefix_code_entry_t {
+    /* Right aligned. */
+    uint32_t code;
+    int length;
+    uint32_t symbol;
+};
+
+struct bitstream_prefix_code_t {
+    /* Symbol and length of the code starting with given bits, as
+       symbol << 8 | length, or zero if there is no such code of at
+       most BITSTREAM_PREFIX_CODE_LOOKUP_BITS bits. */
+    uint32_t lookup[1 << BITSTREAM_PREFIX_CODE_LOOKUP_BITS];
+    /* All codes, sorted as left aligned. */
+    const struct bitstream_prefix_code_entry_t *entries_p;
+    int number_of_entries;
+    int max_length;
+};
+
+/* Initialize a decoder of given codes of 1 to 32 bits with symbols
+   less than 2^24, for example a Huffman table. The entries are sorted
+   in place and must be kept as long as the decoder is used. Returns
+   zero on success and -1 if a code is invalid or a prefix of another
+   code. */
+int bitstream_prefix_code_init(struct bitstream_prefix_code_t *self_p,
+                               struct bitstream_prefix_code_entry_t *entries_p,
+                               int number_of_entries);
+
+/* Read a code and get its symbol. Returns zero on success, -1 if the
+   data is short and -2 if the bits are not a code. The read position
+   is only moved on success. */
+int bitstream_reader_read_prefix_code(struct bitstream_reader_t *self_p,
+                                      const struct bitstream_prefix_code_t *code_p,
+                                      uint32_t *symbol_p);
+
+/* Read given number of codes into an array of uint16_t or uint32_t
+   symbols, that is, item size 2 or 4 bytes. In window mode all codes
+   that fit in a 64 bits window are decoded from a single load.
+   Returns as the function above, with the read position after the
+   last read code on failure. */
+int bitstream_reader_read_prefix_codes(struct bitstream_reader_t *self_p,
+                                       const struct bitstream_prefix_code_t *code_p,
+                                       void *dst_p,
+                                       int item_size,
+                                       int64_t count);
+
+/*
+ * Bit order.
+ */
+
+/* Reverse the order of the lowest given number of bits. Upper unused
+   bits must be zero. */
+uint64_t bitstream_reverse_u64_bits(uint64_t value, int number_of_bits);
+
+/* Reverse the bit order of given buffer, that is, the byte order is
+   reversed and so is the bit order in each byte. */
+void bitstream_reverse_bytes_bits(uint8_t *buf_p, int length);
+
+/*
+ * Instruction set.
+ */
+
+/* Instruction sets of the vectorized kernels, from worst to best. */
+#define BITSTREAM_ISA_SCALAR 0
+#define BITSTREAM_ISA_SSE2 1
+#define BITSTREAM_ISA_AVX2 2
+#define BITSTREAM_ISA_AVX512 3
+
+/* Get the best instruction set supported by both the build and the
+   CPU. */
+int bitstream_isa_detect(void);
+
+/* Select the instruction set of the kernels. It must not be better
+   than the detected one. The default is the instruction set the
+   compiler targets, for example SSE2 on x86-64. It may be selected
+   while other threads are running kernels. Returns zero on success and
+   -1 on failure. */
+int bitstream_isa_set(int value);
+
+int bitstream_isa_get(void);
+
+/*
+ * Inline hot paths, for callers reading or writing many fields.
+ */
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#    define BITSTREAM_WINDOW_TO_BE(value) __builtin_bswap64(value)
+#    define BITSTREAM_WINDOW_TO_LE(value) (value)
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#    define BITSTREAM_WINDOW_TO_BE(value) (value)
+#    define BITSTREAM_WINDOW_TO_LE(value) __builtin_bswap64(value)
+#elif defined(_MSC_VER)
+#    include <stdlib.h>
+#    define BITSTREAM_WINDOW_TO_BE(value) _byteswap_uint64(value)
+#    define BITSTREAM_WINDOW_TO_LE(value) (value)
+#endif
+
+/* Load eight bytes as a big endian integer. */
+static inline uint64_t bitstream_window_load(const uint8_t *buf_p)
+{
+#if defined(BITSTREAM_WINDOW_TO_BE)
+    uint64_t value;
+
+    memcpy(&value, buf_p, sizeof(value));
+
+    return (BITSTREAM_WINDOW_TO_BE(value));
+#else
+    return (((uint64_t)buf_p[0] << 56)
+            | ((uint64_t)buf_p[1] << 48)
+            | ((uint64_t)buf_p[2] << 40)
+            | ((uint64_t)buf_p[3] << 32)
+            | ((uint64_t)buf_p[4] << 24)
+            | ((uint64_t)buf_p[5] << 16)
+            | ((uint64_t)buf_p[6] << 8)
+            | (uint64_t)buf_p[7]);
+#endif
+}
+
+/* Store given integer as eight big endian bytes. */
+static inline void bitstream_window_store(uint8_t *buf_p, uint64_t value)
+{
+#if defined(BITSTREAM_WINDOW_TO_BE)
+    value = BITSTREAM_WINDOW_TO_BE(value);
+    memcpy(buf_p, &value, sizeof(value));
+#else
+    int i;
+
+    for (i = 7; i >= 0; i--) {
+        buf_p[i] = (uint8_t)value;
+        value >>= 8;
+    }
+#endif
+}
+
+/* Same as bitstream_writer_write_u64_bits(). Read-modify-writes the
+   window if not too close to the end, and otherwise calls
+   bitstream_writer_write_u64_bits_bytes(). */
+static inline void bitstream_writer_write_u64_bits_inline(
+    struct bitstream_writer_t *self_p,
+    uint64_t value,
+    int number_of_bits)
+{
+    unsigned int total;
+    uint8_t *dst_p;
+    uint64_t mask;
+    uint64_t window;
+
+    total = (self_p->bit_offset + number_of_bits);
+
+    if ((number_of_bits == 0)
+        || ((self_p->byte_offset + (total > 64)) > self_p->window_end)) {
+        bitstream_writer_write_u64_bits_bytes(self_p, value, number_of_bits);
+
+        return;
+    }
+
+    dst_p = &self_p->buf_p[self_p->byte_offset];
+    window = bitstream_window_load(dst_p);
+    mask = (UINT64_MAX >> self_p->bit_offset);
+
+    if (total > 64) {
+        window &= ~mask;
+        window |= ((value >> (total - 64)) & mask);
+        dst_p[8] = (uint8_t)(value << (72 - total));
+    } else {
+        /* Also clear bits after the value in its last byte. */
+        if (total <= 56) {
+            mask &= ~(UINT64_MAX >> ((total + 7) & ~7));
+        }
+
+        window &= ~mask;
+        window |= ((value << (64 - total)) & mask);
+    }
+
+    bitstream_window_store(dst_p, window);
+    self_p->byte_offset += (total / 8);
+    self_p->bit_offset = (total % 8);
+}
+
+/* Same as bitstream_reader_read_u64_bits(). Loads the window if not
+   too close to the end, and otherwise calls
+   bitstream_reader_read_u64_bits_bytes(). */
+static inline uint64_t bitstream_reader_read_u64_bits_inline(
+    struct bitstream_reader_t *self_p,
+    int number_of_bits)
+{
+    unsigned int total;
+    const uint8_t *src_p;
+    uint64_t value;
+
+    total = (self_p->bit_offset + number_of_bits);
+
+    if ((number_of_bits == 0)
+        || ((self_p->byte_offset + (total > 64)) > self_p->window_end)) {
+        return (bitstream_reader_read_u64_bits_bytes(self_p, number_of_bits));
+    }
+
+    src_p = &self_p->buf_p[self_p->byte_offset];
+    value = (bitstream_window_load(src_p) << self_p->bit_offset);
+
+    if (total > 64) {
+        value |= (src_p[8] >> (8 - self_p->bit_offset));
+    }
+
+    self_p->byte_offset += (total / 8);
+    self_p->bit_offset = (total % 8);
+
+    return (value >> (64 - number_of_bits));
+}
+
+/* Load eight bytes as a little endian integer. */
+static inline uint64_t bitstream_window_load_le(const uint8_t *buf_p)
+{
+#if defined(BITSTREAM_WINDOW_TO_LE)
+    uint64_t value;
+
+    memcpy(&value, buf_p, sizeof(value));
+
+    return (BITSTREAM_WINDOW_TO_LE(value));
+#else
+    return (((uint64_t)buf_p[7] << 56)
+            | ((uint64_t)buf_p[6] << 48)
+            | ((uint64_t)buf_p[5] << 40)
+            | ((uint64_t)buf_p[4] << 32)
+            | ((uint64_t)buf_p[3] << 24)
+            | ((uint64_t)buf_p[2] << 16)
+            | ((uint64_t)buf_p[1] << 8)
+            | (uint64_t)buf_p[0]);
+#endif
+}
+
+/* Store given integer as eight little endian bytes. */
+static inline void bitstream_window_store_le(uint8_t *buf_p, uint64_t value)
+{
+#if defined(BITSTREAM_WINDOW_TO_LE)
+    value = BITSTREAM_WINDOW_TO_LE(value);
+    memcpy(buf_p, &value, sizeof(value));
+#else
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        buf_p[i] = (uint8_t)value;
+        value >>= 8;
+    }
+#endif
+}
+
+/* Reverse the bit order in each byte of given integer, keeping the
+   byte order. A little endian window with reversed bytes has stream
+   bit i at bit i. */
+static inline uint64_t bitstream_reverse_bits_in_bytes(uint64_t value)
+{
+    value = (((value >> 1) & 0x5555555555555555ull)
+             | ((value & 0x5555555555555555ull) << 1));
+    value = (((value >> 2) & 0x3333333333333333ull)
+             | ((value & 0x3333333333333333ull) << 2));
+    value = (((value >> 4) & 0x0f0f0f0f0f0f0f0full)
+             | ((value & 0x0f0f0f0f0f0f0f0full) << 4));
+
+    return (value);
+}
+
+/* Same as bitstream_writer_write_u64_bits_le(). Bit i of the value is
+   written to stream bit bit_offset + i of a little endian window, so
+   only the bits in each byte are reversed, and not the whole value as
+   bitstream_reverse_u64_bits() does. */
+static inline void bitstream_writer_write_u64_bits_le_inline(
+    struct bitstream_writer_t *self_p,
+    uint64_t value,
+    int number_of_bits)
+{
+    unsigned int total;
+    uint8_t *dst_p;
+    uint64_t mask;
+    uint64_t window;
+
+    total = (self_p->bit_offset + number_of_bits);
+
+    if ((number_of_bits == 0)
+        || ((self_p->byte_offset + (total > 64)) > self_p->window_end)) {
+        bitstream_writer_write_u64_bits_le_bytes(self_p, value, number_of_bits);
+
+        return;
+    }
+
+    dst_p = &self_p->buf_p[self_p->byte_offset];
+    window = bitstream_window_load_le(dst_p);
+
+    /* Bytes from the current one to the last one of the value, but
+       not the bits before the value in the current byte. */
+    if (total <= 56) {
+        mask = ((1ull << (8 * ((total + 7) / 8))) - 1);
+    } else {
+        mask = UINT64_MAX;
+    }
+
+    mask &= ~(uint64_t)(uint8_t)~(0xff >> self_p->bit_offset);
+    window &= ~mask;
+    window |= bitstream_reverse_bits_in_bytes(value << self_p->bit_offset);
+    bitstream_window_store_le(dst_p, window);
+
+    if (total > 64) {
+        dst_p[8] = (uint8_t)bitstream_reverse_bits_in_bytes(
+            value >> (64 - self_p->bit_offset));
+    }
+
+    self_p->byte_offset += (total / 8);
+    self_p->bit_offset = (total % 8);
+}
+
+/* Same as bitstream_reader_read_u64_bits_le(). */
+static inline uint64_t bitstream_reader_read_u64_bits_le_inline(
+    struct bitstream_reader_t *self_p,
+    int number_of_bits)
+{
+    unsigned int total;
+    const uint8_t *src_p;
+    uint64_t value;
+
+    total = (self_p->bit_offset + number_of_bits);
+
+    if ((number_of_bits == 0)
+        || ((self_p->byte_offset + (total > 64)) > self_p->window_end)) {
+        return (bitstream_reader_read_u64_bits_le_bytes(self_p, number_of_bits));
+    }
+
+    src_p = &self_p->buf_p[self_p->byte_offset];
+    value = (bitstream_reverse_bits_in_bytes(bitstream_window_load_le(src_p))
+             >> self_p->bit_offset);
+
+    if (total > 64) {
+        value |= (bitstream_reverse_bits_in_bytes(src_p[8])
+                  << (64 - self_p->bit_offset));
+    }
+
+    self_p->byte_offset += (total / 8);
+    self_p->bit_offset = (total % 8);
+
+    if (number_of_bits < 64) {
+        value &= ((1ull << number_of_bits) - 1);
+    }
+
+    return (value);
+}
 
 #endif
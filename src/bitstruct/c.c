@@ -8,7 +8,12 @@
 
 #include <stdio.h>
 
+/* Largest offset in bits. Leaves room for adding format and data
+   sizes in bits without overflow. */
+#define OFFSET_MAX (LLONG_MAX / 4)
+
 struct field_info_t;
+struct column_t;
 
 typedef void (*pack_field_t)(struct bitstream_writer_t *self_p,
                              PyObject *value_p,
@@ -17,11 +22,50 @@ typedef void (*pack_field_t)(struct bitstream_writer_t *self_p,
 typedef PyObject *(*unpack_field_t)(struct bitstream_reader_t *self_p,
                                     struct field_info_t *field_info_p);
 
+/* Unpack a field into given index of a typed column. */
+typedef void (*unpack_column_field_t)(struct bitstream_reader_t *self_p,
+                                      struct field_info_t *field_info_p,
+                                      void *column_p,
+                                      Py_ssize_t index);
+
+/* Load and store a field starting on a byte boundary. */
+typedef uint64_t (*load_field_t)(const uint8_t *buf_p);
+
+typedef void (*store_field_t)(uint8_t *buf_p, uint64_t value);
+
+/* Pack given index of a typed column into a field. Returns zero on
+   success and -1 on failure. */
+typedef int (*pack_column_field_t)(struct bitstream_writer_t *self_p,
+                                   struct field_info_t *field_info_p,
+                                   struct column_t *column_p,
+                                   Py_ssize_t index);
+
+struct prefix_code_t;
+
+/* Packed size in bits of given value of a variable length field.
+   Returns -1 on failure. */
+typedef long long (*size_field_t)(PyObject *value_p,
+                                  struct field_info_t *field_info_p);
+
 struct field_info_t {
     pack_field_t pack;
     unpack_field_t unpack;
+    unpack_column_field_t unpack_column;
+    pack_column_field_t pack_column;
+    /* Byte aligned kernels, or NULL if not available. */
+    load_field_t load;
+    store_field_t store;
+    /* NULL for fixed size fields. */
+    size_field_t size;
+    /* Code of prefix code fields, or NULL if not set. */
+    const struct prefix_code_t *prefix_code_p;
+    /* Column array type code, or '\0' if not supported. */
+    char column_type_code;
+    /* Smallest size of variable length fields. */
     int number_of_bits;
     bool is_padding;
+    bool is_bit_order_lsb_first;
+    bool is_byte_order_lsb_first;
     union {
         struct {
             int64_t lower;
@@ -33,17 +77,46 @@ struct field_info_t {
     } limits;
 };
 
+/* A buffer of integers or floats, such as an array.array. */
+struct column_t {
+    Py_buffer view;
+    /* 'i' for signed integers, 'u' for unsigned integers and 'f' for
+       floats. */
+    char kind;
+};
+
 struct info_t {
+    /* Number of users of a cached format, see format_cache_get(). */
+    int refcount;
+    /* Smallest size if there are variable length fields. */
     int number_of_bits;
     int number_of_fields;
     int number_of_non_padding_fields;
+    int number_of_variable_length_fields;
+    /* Unpack byte aligned raw fields as memoryviews of the data. Only
+       set on compiled formats. */
+    bool raw_as_memoryview;
     struct field_info_t fields[1];
 };
 
+/* A prefix code set on a compiled format, for example a Huffman
+   table. */
+struct prefix_code_t {
+    struct bitstream_prefix_code_t decoder;
+    /* The codes as given, for copies and pickling. */
+    PyObject *codes_p;
+    int number_of_symbols;
+    /* Code of each symbol, for packing. */
+    struct bitstream_prefix_code_entry_t *symbols_p;
+    /* Sorted by the decoder. */
+    struct bitstream_prefix_code_entry_t entries[1];
+};
+
 struct compiled_format_t {
     PyObject_HEAD
     struct info_t *info_p;
     PyObject *format_p;
+    struct prefix_code_t *prefix_code_p;
 };
 
 struct compiled_format_dict_t {
@@ -51,6 +124,13 @@ struct compiled_format_dict_t {
     struct info_t *info_p;
     PyObject *format_p;
     PyObject *names_p;
+    struct prefix_code_t *prefix_code_p;
+};
+
+struct compiled_byteswap_t {
+    PyObject_HEAD
+    struct byteswap_format_t *format_p;
+    PyObject *pattern_p;
 };
 
 static const char* pickle_version_key = "_pickle_version";
@@ -70,22 +150,56 @@ static int compiled_format_init_inner(struct compiled_format_t *self_p,
 static void compiled_format_dealloc(struct compiled_format_t *self_p);
 
 static PyObject *m_compiled_format_pack(struct compiled_format_t *self_p,
-                                        PyObject *args_p);
+                                        PyObject *const *args_pp,
+                                        Py_ssize_t number_of_args);
 
 static PyObject *m_compiled_format_unpack(struct compiled_format_t *self_p,
-                                          PyObject *args_p,
-                                          PyObject *kwargs_p);
+                                          PyObject *const *args_pp,
+                                          Py_ssize_t number_of_args,
+                                          PyObject *kwnames_p);
 
 static PyObject *m_compiled_format_pack_into(struct compiled_format_t *self_p,
+                                             PyObject *const *args_pp,
+                                             Py_ssize_t number_of_args,
+                                             PyObject *kwnames_p);
+
+static PyObject *m_compiled_format_unpack_from(struct compiled_format_t *self_p,
+                                               PyObject *const *args_pp,
+                                               Py_ssize_t number_of_args,
+                                               PyObject *kwnames_p);
+
+static PyObject *m_compiled_format_pack_many(struct compiled_format_t *self_p,
                                              PyObject *args_p,
                                              PyObject *kwargs_p);
 
-static PyObject *m_compiled_format_unpack_from(struct compiled_format_t *self_p,
+static PyObject *m_compiled_format_pack_many_into(struct compiled_format_t *self_p,
+                                                  PyObject *args_p,
+                                                  PyObject *kwargs_p);
+
+static PyObject *m_compiled_format_unpack_many(struct compiled_format_t *self_p,
                                                PyObject *args_p,
                                                PyObject *kwargs_p);
 
+static PyObject *m_compiled_format_unpack_columns(struct compiled_format_t *self_p,
+                                                  PyObject *args_p,
+                                                  PyObject *kwargs_p);
+
+static PyObject *m_compiled_format_pack_columns(struct compiled_format_t *self_p,
+                                                PyObject *args_p,
+                                                PyObject *kwargs_p);
+
 static PyObject *m_compiled_format_calcsize(struct compiled_format_t *self_p);
 
+static PyObject *m_compiled_format_set_prefix_code(
+    struct compiled_format_t *self_p,
+    PyObject *codes_p);
+
+static PyObject *m_compiled_format_unpack_symbols(
+    struct compiled_format_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p);
+
 static PyObject *m_compiled_format_copy(struct compiled_format_t *self_p);
 
 static PyObject *m_compiled_format_deepcopy(struct compiled_format_t *self_p,
@@ -115,16 +229,44 @@ static PyObject *m_compiled_format_dict_pack(struct compiled_format_dict_t *self
                                              PyObject *data_p);
 
 static PyObject *m_compiled_format_dict_unpack(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p);
+
+static PyObject *m_compiled_format_dict_pack_into(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p);
+
+static PyObject *m_compiled_format_dict_unpack_from(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p);
+
+static PyObject *m_compiled_format_dict_pack_many(
     struct compiled_format_dict_t *self_p,
     PyObject *args_p,
     PyObject *kwargs_p);
 
-static PyObject *m_compiled_format_dict_pack_into(
+static PyObject *m_compiled_format_dict_pack_many_into(
     struct compiled_format_dict_t *self_p,
     PyObject *args_p,
     PyObject *kwargs_p);
 
-static PyObject *m_compiled_format_dict_unpack_from(
+static PyObject *m_compiled_format_dict_unpack_many(
+    struct compiled_format_dict_t *self_p,
+    PyObject *args_p,
+    PyObject *kwargs_p);
+
+static PyObject *m_compiled_format_dict_unpack_columns(
+    struct compiled_format_dict_t *self_p,
+    PyObject *args_p,
+    PyObject *kwargs_p);
+
+static PyObject *m_compiled_format_dict_pack_columns(
     struct compiled_format_dict_t *self_p,
     PyObject *args_p,
     PyObject *kwargs_p);
@@ -132,6 +274,16 @@ static PyObject *m_compiled_format_dict_unpack_from(
 static PyObject *m_compiled_format_dict_calcsize(
     struct compiled_format_dict_t *self_p);
 
+static PyObject *m_compiled_format_dict_set_prefix_code(
+    struct compiled_format_dict_t *self_p,
+    PyObject *codes_p);
+
+static PyObject *m_compiled_format_dict_unpack_symbols(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p);
+
 static PyObject *m_compiled_format_dict_copy(
     struct compiled_format_dict_t *self_p);
 
@@ -145,6 +297,37 @@ static PyObject *m_compiled_format_dict_getstate(struct compiled_format_dict_t *
 static PyObject *m_compiled_format_dict_setstate(struct compiled_format_dict_t *self_p,
                                                  PyObject *args_p);
 
+static PyObject *compiled_byteswap_new(PyTypeObject *type_p,
+                                       PyObject *args_p,
+                                       PyObject *kwargs_p);
+
+static int compiled_byteswap_init(struct compiled_byteswap_t *self_p,
+                                  PyObject *args_p,
+                                  PyObject *kwargs_p);
+
+static void compiled_byteswap_dealloc(struct compiled_byteswap_t *self_p);
+
+static PyObject *m_compiled_byteswap_swap(struct compiled_byteswap_t *self_p,
+                                          PyObject *const *args_pp,
+                                          Py_ssize_t number_of_args,
+                                          PyObject *kwnames_p);
+
+static PyObject *m_compiled_byteswap_swap_into(
+    struct compiled_byteswap_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p);
+
+static PyObject *m_compiled_byteswap_swap_many(
+    struct compiled_byteswap_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p);
+
+static PyObject *m_compiled_byteswap_calcsize(struct compiled_byteswap_t *self_p);
+
+static PyObject *m_compiled_byteswap_reduce(struct compiled_byteswap_t *self_p);
+
 PyDoc_STRVAR(pack___doc__,
              "pack(fmt, *args)\n"
              "--\n"
@@ -181,6 +364,36 @@ PyDoc_STRVAR(compiled_format_unpack_from___doc__,
              "--\n"
              "\n");
 
+PyDoc_STRVAR(pack_many___doc__,
+             "pack_many(records, stride=None)\n"
+             "--\n"
+             "\n");
+
+PyDoc_STRVAR(pack_many_into___doc__,
+             "pack_many_into(buf, offset, records, stride=None, fill_padding=True)\n"
+             "--\n"
+             "\n");
+
+PyDoc_STRVAR(unpack_many___doc__,
+             "unpack_many(data, count=None, stride=None, offset=0)\n"
+             "--\n"
+             "\n");
+
+PyDoc_STRVAR(unpack_columns___doc__,
+             "unpack_columns(data, count=None, stride=None, offset=0)\n"
+             "--\n"
+             "\n");
+
+PyDoc_STRVAR(pack_columns___doc__,
+             "pack_columns(*columns, stride=None)\n"
+             "--\n"
+             "\n");
+
+PyDoc_STRVAR(compiled_format_dict_pack_columns___doc__,
+             "pack_columns(columns, stride=None)\n"
+             "--\n"
+             "\n");
+
 PyDoc_STRVAR(calcsize___doc__,
              "calcsize(fmt)\n"
              "--\n"
@@ -190,39 +403,96 @@ PyDoc_STRVAR(compiled_format_calcsize___doc__,
              "--\n"
              "\n");
 
+PyDoc_STRVAR(set_prefix_code___doc__,
+             "set_prefix_code(codes)\n"
+             "--\n"
+             "\n"
+             "Set the prefix code of h fields, for example a Huffman table,\n"
+             "as a sequence of bit strings. The symbol of a code is its\n"
+             "index. It can only be set once.");
+
+PyDoc_STRVAR(unpack_symbols___doc__,
+             "unpack_symbols(data, count, offset=0)\n"
+             "--\n"
+             "\n"
+             "Decode count prefix codes from data as an array.array of\n"
+             "symbols.");
+
 static PyObject *py_zero_p = NULL;
 
 static struct PyMethodDef compiled_format_methods[] = {
     {
         "pack",
         (PyCFunction)m_compiled_format_pack,
-        METH_VARARGS,
+        METH_FASTCALL,
         compiled_format_pack___doc__
     },
     {
         "unpack",
         (PyCFunction)m_compiled_format_unpack,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         compiled_format_unpack___doc__
     },
     {
         "pack_into",
         (PyCFunction)m_compiled_format_pack_into,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         compiled_format_pack_into___doc__
     },
     {
         "unpack_from",
         (PyCFunction)m_compiled_format_unpack_from,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         compiled_format_unpack_from___doc__
     },
+    {
+        "pack_many",
+        (PyCFunction)m_compiled_format_pack_many,
+        METH_VARARGS | METH_KEYWORDS,
+        pack_many___doc__
+    },
+    {
+        "pack_many_into",
+        (PyCFunction)m_compiled_format_pack_many_into,
+        METH_VARARGS | METH_KEYWORDS,
+        pack_many_into___doc__
+    },
+    {
+        "unpack_many",
+        (PyCFunction)m_compiled_format_unpack_many,
+        METH_VARARGS | METH_KEYWORDS,
+        unpack_many___doc__
+    },
+    {
+        "unpack_columns",
+        (PyCFunction)m_compiled_format_unpack_columns,
+        METH_VARARGS | METH_KEYWORDS,
+        unpack_columns___doc__
+    },
+    {
+        "pack_columns",
+        (PyCFunction)m_compiled_format_pack_columns,
+        METH_VARARGS | METH_KEYWORDS,
+        pack_columns___doc__
+    },
     {
         "calcsize",
         (PyCFunction)m_compiled_format_calcsize,
         METH_NOARGS,
         compiled_format_calcsize___doc__
     },
+    {
+        "set_prefix_code",
+        (PyCFunction)m_compiled_format_set_prefix_code,
+        METH_O,
+        set_prefix_code___doc__
+    },
+    {
+        "unpack_symbols",
+        (PyCFunction)m_compiled_format_unpack_symbols,
+        METH_FASTCALL | METH_KEYWORDS,
+        unpack_symbols___doc__
+    },
     {
         "__copy__",
         (PyCFunction)m_compiled_format_copy,
@@ -269,27 +539,69 @@ static struct PyMethodDef compiled_format_dict_methods[] = {
     {
         "unpack",
         (PyCFunction)m_compiled_format_dict_unpack,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         unpack___doc__
     },
     {
         "pack_into",
         (PyCFunction)m_compiled_format_dict_pack_into,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         pack_into___doc__
     },
     {
         "unpack_from",
         (PyCFunction)m_compiled_format_dict_unpack_from,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         unpack_from___doc__
     },
+    {
+        "pack_many",
+        (PyCFunction)m_compiled_format_dict_pack_many,
+        METH_VARARGS | METH_KEYWORDS,
+        pack_many___doc__
+    },
+    {
+        "pack_many_into",
+        (PyCFunction)m_compiled_format_dict_pack_many_into,
+        METH_VARARGS | METH_KEYWORDS,
+        pack_many_into___doc__
+    },
+    {
+        "unpack_many",
+        (PyCFunction)m_compiled_format_dict_unpack_many,
+        METH_VARARGS | METH_KEYWORDS,
+        unpack_many___doc__
+    },
+    {
+        "unpack_columns",
+        (PyCFunction)m_compiled_format_dict_unpack_columns,
+        METH_VARARGS | METH_KEYWORDS,
+        unpack_columns___doc__
+    },
+    {
+        "pack_columns",
+        (PyCFunction)m_compiled_format_dict_pack_columns,
+        METH_VARARGS | METH_KEYWORDS,
+        compiled_format_dict_pack_columns___doc__
+    },
     {
         "calcsize",
         (PyCFunction)m_compiled_format_dict_calcsize,
         METH_NOARGS,
         calcsize___doc__
     },
+    {
+        "set_prefix_code",
+        (PyCFunction)m_compiled_format_dict_set_prefix_code,
+        METH_O,
+        set_prefix_code___doc__
+    },
+    {
+        "unpack_symbols",
+        (PyCFunction)m_compiled_format_dict_unpack_symbols,
+        METH_FASTCALL | METH_KEYWORDS,
+        unpack_symbols___doc__
+    },
     {
         "__copy__",
         (PyCFunction)m_compiled_format_dict_copy,
@@ -326,6 +638,79 @@ static PyTypeObject compiled_format_dict_type = {
     .tp_methods = compiled_format_dict_methods,
 };
 
+PyDoc_STRVAR(compiled_byteswap_swap___doc__,
+             "swap(data, offset=0)\n"
+             "--\n"
+             "\n"
+             "Return one swapped record of data, starting at byte offset.");
+
+PyDoc_STRVAR(compiled_byteswap_swap_into___doc__,
+             "swap_into(buf, offset=0)\n"
+             "--\n"
+             "\n"
+             "Swap one record of the writable buffer buf in place, starting\n"
+             "at byte offset.");
+
+PyDoc_STRVAR(compiled_byteswap_swap_many___doc__,
+             "swap_many(data, count, offset=0, inplace=False)\n"
+             "--\n"
+             "\n"
+             "Swap count consecutive records of data, starting at byte\n"
+             "offset, and return the swapped bytes. If inplace is True the\n"
+             "writable buffer data is swapped and None returned.");
+
+PyDoc_STRVAR(compiled_byteswap_calcsize___doc__,
+             "calcsize()\n"
+             "--\n"
+             "\n"
+             "Return the size of a record in bytes.");
+
+static struct PyMethodDef compiled_byteswap_methods[] = {
+    {
+        "swap",
+        (PyCFunction)m_compiled_byteswap_swap,
+        METH_FASTCALL | METH_KEYWORDS,
+        compiled_byteswap_swap___doc__
+    },
+    {
+        "swap_into",
+        (PyCFunction)m_compiled_byteswap_swap_into,
+        METH_FASTCALL | METH_KEYWORDS,
+        compiled_byteswap_swap_into___doc__
+    },
+    {
+        "swap_many",
+        (PyCFunction)m_compiled_byteswap_swap_many,
+        METH_FASTCALL | METH_KEYWORDS,
+        compiled_byteswap_swap_many___doc__
+    },
+    {
+        "calcsize",
+        (PyCFunction)m_compiled_byteswap_calcsize,
+        METH_NOARGS,
+        compiled_byteswap_calcsize___doc__
+    },
+    {
+        "__reduce__",
+        (PyCFunction)m_compiled_byteswap_reduce,
+        METH_NOARGS
+    },
+    { NULL }
+};
+
+static PyTypeObject compiled_byteswap_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "bitstruct.c.CompiledByteswap",
+    .tp_doc = NULL,
+    .tp_basicsize = sizeof(struct compiled_byteswap_t),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = compiled_byteswap_new,
+    .tp_init = (initproc)compiled_byteswap_init,
+    .tp_dealloc = (destructor)compiled_byteswap_dealloc,
+    .tp_methods = compiled_byteswap_methods,
+};
+
 static bool is_names_list(PyObject *names_p)
 {
     if (!PyList_Check(names_p)) {
@@ -337,1741 +722,6017 @@ static bool is_names_list(PyObject *names_p)
     return (true);
 }
 
-static void pack_signed_integer(struct bitstream_writer_t *self_p,
-                                PyObject *value_p,
-                                struct field_info_t *field_info_p)
+/* Parse given fast call arguments into given values. Optional values
+   must be initialized with their default value, and required values
+   with NULL. Returns zero on success and -1 on failure. */
+static int parse_args(PyObject *const *args_pp,
+                      Py_ssize_t number_of_args,
+                      PyObject *kwnames_p,
+                      const char *const *keywords_pp,
+                      PyObject **values_pp)
 {
-    int64_t value;
-    int64_t lower;
-    int64_t upper;
+    PyObject *kwname_p;
+    Py_ssize_t number_of_keywords;
+    Py_ssize_t number_of_kwargs;
+    Py_ssize_t i;
+    Py_ssize_t j;
 
-    value = PyLong_AsLongLong(value_p);
+    number_of_keywords = 0;
 
-    if ((value == -1) && PyErr_Occurred()) {
-        return;
+    while (keywords_pp[number_of_keywords] != NULL) {
+        number_of_keywords++;
     }
 
-    if (field_info_p->number_of_bits < 64) {
-        lower = field_info_p->limits.s.lower;
-        upper = field_info_p->limits.s.upper;
+    if (number_of_args > number_of_keywords) {
+        PyErr_Format(PyExc_TypeError,
+                     "function takes at most %zd arguments (%zd given)",
+                     number_of_keywords,
+                     number_of_args);
 
-        if ((value < lower) || (value > upper)) {
-            PyErr_Format(PyExc_OverflowError,
-                         "Signed integer value %lld out of range.",
-                         (long long)value);
-        }
+        return (-1);
+    }
 
-        value &= ((1ull << field_info_p->number_of_bits) - 1);
+    for (i = 0; i < number_of_args; i++) {
+        values_pp[i] = args_pp[i];
     }
 
-    bitstream_writer_write_u64_bits(self_p,
-                                    (uint64_t)value,
-                                    field_info_p->number_of_bits);
-}
+    if (kwnames_p != NULL) {
+        number_of_kwargs = PyTuple_GET_SIZE(kwnames_p);
 
-static PyObject *unpack_signed_integer(struct bitstream_reader_t *self_p,
-                                       struct field_info_t *field_info_p)
-{
-    uint64_t value;
-    uint64_t sign_bit;
+        for (i = 0; i < number_of_kwargs; i++) {
+            kwname_p = PyTuple_GET_ITEM(kwnames_p, i);
 
-    value = bitstream_reader_read_u64_bits(self_p, field_info_p->number_of_bits);
-    sign_bit = (1ull << (field_info_p->number_of_bits - 1));
+            for (j = 0; j < number_of_keywords; j++) {
+                if (PyUnicode_CompareWithASCIIString(kwname_p,
+                                                     keywords_pp[j]) == 0) {
+                    break;
+                }
+            }
 
-    if (value & sign_bit) {
-        value |= ~(((sign_bit) << 1) - 1);
-    }
+            if (j == number_of_keywords) {
+                PyErr_Format(PyExc_TypeError,
+                             "'%U' is an invalid keyword argument for this "
+                             "function",
+                             kwname_p);
 
-    return (PyLong_FromLongLong((long long)value));
-}
+                return (-1);
+            }
 
-static void pack_unsigned_integer(struct bitstream_writer_t *self_p,
-                                  PyObject *value_p,
-                                  struct field_info_t *field_info_p)
-{
-    uint64_t value;
+            if (j < number_of_args) {
+                PyErr_Format(PyExc_TypeError,
+                             "argument for function given by name ('%s') "
+                             "and position (%zd)",
+                             keywords_pp[j],
+                             j + 1);
 
-    value = PyLong_AsUnsignedLongLong(value_p);
+                return (-1);
+            }
 
-    if ((value == (uint64_t)-1) && PyErr_Occurred()) {
-        return;
+            values_pp[j] = args_pp[number_of_args + i];
+        }
     }
 
-    if (value > field_info_p->limits.u.upper) {
-        PyErr_Format(PyExc_OverflowError,
-                     "Unsigned integer value %llu out of range.",
-                     (unsigned long long)value);
+    for (i = 0; i < number_of_keywords; i++) {
+        if (values_pp[i] == NULL) {
+            PyErr_Format(PyExc_TypeError,
+                         "function missing required argument '%s' (pos %zd)",
+                         keywords_pp[i],
+                         i + 1);
+
+            return (-1);
+        }
     }
 
-    bitstream_writer_write_u64_bits(self_p,
-                                    value,
-                                    field_info_p->number_of_bits);
+    return (0);
 }
 
-static PyObject *unpack_unsigned_integer(struct bitstream_reader_t *self_p,
-                                         struct field_info_t *field_info_p)
-{
-    uint64_t value;
+#if defined(_MSC_VER)
+#    include <stdlib.h>
+#    define BSWAP16(x) _byteswap_ushort(x)
+#    define BSWAP32(x) _byteswap_ulong(x)
+#    define BSWAP64(x) _byteswap_uint64(x)
+#else
+#    define BSWAP16(x) __builtin_bswap16(x)
+#    define BSWAP32(x) __builtin_bswap32(x)
+#    define BSWAP64(x) __builtin_bswap64(x)
+#endif
 
-    value = bitstream_reader_read_u64_bits(self_p,
-                                           field_info_p->number_of_bits);
+#if PY_LITTLE_ENDIAN
+#    define BE16(x) BSWAP16(x)
+#    define BE32(x) BSWAP32(x)
+#    define BE64(x) BSWAP64(x)
+#    define LE16(x) (x)
+#    define LE32(x) (x)
+#    define LE64(x) (x)
+#else
+#    define BE16(x) (x)
+#    define BE32(x) (x)
+#    define BE64(x) (x)
+#    define LE16(x) BSWAP16(x)
+#    define LE32(x) BSWAP32(x)
+#    define LE64(x) BSWAP64(x)
+#endif
 
-    return (PyLong_FromUnsignedLongLong(value));
+static uint64_t load_u8(const uint8_t *buf_p)
+{
+    return (buf_p[0]);
 }
 
-#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 6
-
-static void pack_float_16(struct bitstream_writer_t *self_p,
-                          PyObject *value_p,
-                          struct field_info_t *field_info_p)
+static void store_u8(uint8_t *buf_p, uint64_t value)
 {
-    uint8_t buf[2];
-
-#if PY_VERSION_HEX >= 0x030B00A7
-    PyFloat_Pack2(PyFloat_AsDouble(value_p),
-                  (char*)&buf[0],
-                  0);
-#else
-    _PyFloat_Pack2(PyFloat_AsDouble(value_p),
-                   &buf[0],
-                   0);
-#endif
-    bitstream_writer_write_bytes(self_p, &buf[0], sizeof(buf));
+    buf_p[0] = (uint8_t)value;
 }
 
-static PyObject *unpack_float_16(struct bitstream_reader_t *self_p,
-                                 struct field_info_t *field_info_p)
+#define LOAD_STORE(bits, order)                                         \
+    static uint64_t load_u ## bits ## _ ## order(const uint8_t *buf_p)  \
+    {                                                                   \
+        uint ## bits ## _t value;                                       \
+                                                                        \
+        memcpy(&value, buf_p, sizeof(value));                           \
+                                                                        \
+        return (order ## bits(value));                                  \
+    }                                                                   \
+                                                                        \
+    static void store_u ## bits ## _ ## order(uint8_t *buf_p,           \
+                                              uint64_t value)           \
+    {                                                                   \
+        uint ## bits ## _t data;                                        \
+                                                                        \
+        data = order ## bits((uint ## bits ## _t)value);                \
+        memcpy(buf_p, &data, sizeof(data));                             \
+    }
+
+LOAD_STORE(16, BE)
+LOAD_STORE(32, BE)
+LOAD_STORE(64, BE)
+LOAD_STORE(16, LE)
+LOAD_STORE(32, LE)
+LOAD_STORE(64, LE)
+
+static void write_field_bits(struct bitstream_writer_t *self_p,
+                             uint64_t value,
+                             struct field_info_t *field_info_p)
 {
-    uint8_t buf[2];
-    double value;
+    bool is_aligned;
 
-    bitstream_reader_read_bytes(self_p, &buf[0], sizeof(buf));
-#if PY_VERSION_HEX >= 0x030B00A7
-    value = PyFloat_Unpack2((const char*)&buf[0], 0);
-#else
-    value = _PyFloat_Unpack2(&buf[0], 0);
-#endif
+    is_aligned = ((self_p->bit_offset == 0) && (field_info_p->store != NULL));
 
-    return (PyFloat_FromDouble(value));
-}
+    if (field_info_p->is_bit_order_lsb_first) {
+        if (!is_aligned && !field_info_p->is_byte_order_lsb_first) {
+            bitstream_writer_write_u64_bits_le_inline(
+                self_p,
+                value,
+                field_info_p->number_of_bits);
 
-#endif
+            return;
+        }
 
-static void pack_float_32(struct bitstream_writer_t *self_p,
-                          PyObject *value_p,
-                          struct field_info_t *field_info_p)
-{
-    float value;
-    uint32_t data;
+        value = bitstream_reverse_u64_bits(value, field_info_p->number_of_bits);
+    }
 
-    value = (float)PyFloat_AsDouble(value_p);
-    memcpy(&data, &value, sizeof(data));
-    bitstream_writer_write_u32(self_p, data);
+    if (is_aligned) {
+        field_info_p->store(&self_p->buf_p[self_p->byte_offset], value);
+        self_p->byte_offset += (field_info_p->number_of_bits / 8);
+    } else if (field_info_p->is_byte_order_lsb_first) {
+        bitstream_writer_write_u64_bits_lsb_byte_first(
+            self_p,
+            value,
+            field_info_p->number_of_bits);
+    } else {
+        bitstream_writer_write_u64_bits_inline(self_p,
+                                               value,
+                                               field_info_p->number_of_bits);
+    }
 }
 
-static PyObject *unpack_float_32(struct bitstream_reader_t *self_p,
-                                 struct field_info_t *field_info_p)
+static uint64_t read_field_bits(struct bitstream_reader_t *self_p,
+                                struct field_info_t *field_info_p)
 {
-    float value;
-    uint32_t data;
+    uint64_t value;
 
-    data = bitstream_reader_read_u32(self_p);
-    memcpy(&value, &data, sizeof(value));
+    if ((self_p->bit_offset == 0) && (field_info_p->load != NULL)) {
+        value = field_info_p->load(&self_p->buf_p[self_p->byte_offset]);
+        self_p->byte_offset += (field_info_p->number_of_bits / 8);
+    } else if (field_info_p->is_byte_order_lsb_first) {
+        value = bitstream_reader_read_u64_bits_lsb_byte_first(
+            self_p,
+            field_info_p->number_of_bits);
+    } else if (field_info_p->is_bit_order_lsb_first) {
+        return (bitstream_reader_read_u64_bits_le_inline(
+                    self_p,
+                    field_info_p->number_of_bits));
+    } else {
+        value = bitstream_reader_read_u64_bits_inline(
+            self_p,
+            field_info_p->number_of_bits);
+    }
 
-    return (PyFloat_FromDouble(value));
+    if (field_info_p->is_bit_order_lsb_first) {
+        value = bitstream_reverse_u64_bits(value, field_info_p->number_of_bits);
+    }
+
+    return (value);
 }
 
-static void pack_float_64(struct bitstream_writer_t *self_p,
-                          PyObject *value_p,
-                          struct field_info_t *field_info_p)
+static void write_field_bytes(struct bitstream_writer_t *self_p,
+                              const uint8_t *buf_p,
+                              struct field_info_t *field_info_p)
 {
-    double value;
-    uint64_t data;
+    int i;
+    int number_of_bytes;
 
-    value = PyFloat_AsDouble(value_p);
-    memcpy(&data, &value, sizeof(data));
-    bitstream_writer_write_u64_bits(self_p,
-                                    data,
-                                    field_info_p->number_of_bits);
+    number_of_bytes = (field_info_p->number_of_bits / 8);
+
+    if (field_info_p->is_bit_order_lsb_first) {
+        for (i = number_of_bytes - 1; i >= 0; i--) {
+            bitstream_writer_write_u8(
+                self_p,
+                (uint8_t)bitstream_reverse_u64_bits(buf_p[i], 8));
+        }
+    } else {
+        bitstream_writer_write_bytes(self_p, buf_p, number_of_bytes);
+    }
 }
 
-static PyObject *unpack_float_64(struct bitstream_reader_t *self_p,
-                                 struct field_info_t *field_info_p)
+static void read_field_bytes(struct bitstream_reader_t *self_p,
+                             uint8_t *buf_p,
+                             struct field_info_t *field_info_p)
 {
-    double value;
-    uint64_t data;
+    int number_of_bytes;
 
-    data = bitstream_reader_read_u64(self_p);
-    memcpy(&value, &data, sizeof(value));
+    number_of_bytes = (field_info_p->number_of_bits / 8);
+    bitstream_reader_read_bytes(self_p, buf_p, number_of_bytes);
 
-    return (PyFloat_FromDouble(value));
+    if (field_info_p->is_bit_order_lsb_first) {
+        bitstream_reverse_bytes_bits(buf_p, number_of_bytes);
+    }
 }
 
-static void pack_bool(struct bitstream_writer_t *self_p,
-                      PyObject *value_p,
-                      struct field_info_t *field_info_p)
+static int64_t column_get_signed(struct column_t *self_p, Py_ssize_t index)
 {
-    bitstream_writer_write_u64_bits(self_p,
-                                    PyObject_IsTrue(value_p),
-                                    field_info_p->number_of_bits);
+    int64_t value;
+
+    switch (self_p->view.itemsize) {
+
+    case 1:
+        value = ((int8_t *)self_p->view.buf)[index];
+        break;
+
+    case 2:
+        value = ((int16_t *)self_p->view.buf)[index];
+        break;
+
+    case 4:
+        value = ((int32_t *)self_p->view.buf)[index];
+        break;
+
+    default:
+        value = ((int64_t *)self_p->view.buf)[index];
+        break;
+    }
+
+    return (value);
 }
 
-static PyObject *unpack_bool(struct bitstream_reader_t *self_p,
-                             struct field_info_t *field_info_p)
+static uint64_t column_get_unsigned(struct column_t *self_p, Py_ssize_t index)
 {
-    return (PyBool_FromLong((long)bitstream_reader_read_u64_bits(
-                                self_p,
-                                field_info_p->number_of_bits)));
+    uint64_t value;
+
+    switch (self_p->view.itemsize) {
+
+    case 1:
+        value = ((uint8_t *)self_p->view.buf)[index];
+        break;
+
+    case 2:
+        value = ((uint16_t *)self_p->view.buf)[index];
+        break;
+
+    case 4:
+        value = ((uint32_t *)self_p->view.buf)[index];
+        break;
+
+    default:
+        value = ((uint64_t *)self_p->view.buf)[index];
+        break;
+    }
+
+    return (value);
 }
 
-static void pack_text(struct bitstream_writer_t *self_p,
-                      PyObject *value_p,
-                      struct field_info_t *field_info_p)
+static double column_get_double(struct column_t *self_p, Py_ssize_t index)
 {
-    Py_ssize_t size;
-    const char* buf_p;
+    double value;
 
-    buf_p = PyUnicode_AsUTF8AndSize(value_p, &size);
+    switch (self_p->kind) {
 
-    if (buf_p != NULL) {
-        if (size < (field_info_p->number_of_bits / 8)) {
-            PyErr_SetString(PyExc_NotImplementedError, "Short text.");
+    case 'i':
+        value = (double)column_get_signed(self_p, index);
+        break;
+
+    case 'u':
+        value = (double)column_get_unsigned(self_p, index);
+        break;
+
+    default:
+        if (self_p->view.itemsize == 4) {
+            value = ((float *)self_p->view.buf)[index];
         } else {
-            bitstream_writer_write_bytes(self_p,
-                                         (uint8_t *)buf_p,
-                                         field_info_p->number_of_bits / 8);
+            value = ((double *)self_p->view.buf)[index];
         }
+
+        break;
     }
+
+    return (value);
 }
 
-static PyObject *unpack_text(struct bitstream_reader_t *self_p,
-                             struct field_info_t *field_info_p)
+/* Returns zero on success and -1 if the value is out of range. */
+static int write_signed_integer(struct bitstream_writer_t *self_p,
+                                int64_t value,
+                                struct field_info_t *field_info_p)
 {
-    uint8_t *buf_p;
-    PyObject *value_p;
-    int number_of_bytes;
+    int64_t lower;
+    int64_t upper;
+    int res;
 
-    number_of_bytes = (field_info_p->number_of_bits / 8);
-    buf_p = PyMem_RawMalloc(number_of_bytes);
+    res = 0;
 
-    if (buf_p == NULL) {
-        return (NULL);
+    if (field_info_p->number_of_bits < 64) {
+        lower = field_info_p->limits.s.lower;
+        upper = field_info_p->limits.s.upper;
+
+        if ((value < lower) || (value > upper)) {
+            PyErr_Format(PyExc_OverflowError,
+                         "Signed integer value %lld out of range.",
+                         (long long)value);
+            res = -1;
+        }
+
+        value &= ((1ull << field_info_p->number_of_bits) - 1);
     }
 
-    bitstream_reader_read_bytes(self_p, buf_p, number_of_bytes);
-    value_p = PyUnicode_FromStringAndSize((const char *)buf_p, number_of_bytes);
-    PyMem_RawFree(buf_p);
+    write_field_bits(self_p, (uint64_t)value, field_info_p);
 
-    return (value_p);
+    return (res);
 }
 
-static void pack_raw(struct bitstream_writer_t *self_p,
-                     PyObject *value_p,
-                     struct field_info_t *field_info_p)
+static void pack_signed_integer(struct bitstream_writer_t *self_p,
+                                PyObject *value_p,
+                                struct field_info_t *field_info_p)
 {
-    Py_ssize_t size;
-    char* buf_p;
-    int res;
+    int64_t value;
 
-    res = PyBytes_AsStringAndSize(value_p, &buf_p, &size);
+    value = PyLong_AsLongLong(value_p);
 
-    if (res != -1) {
-        if (size < (field_info_p->number_of_bits / 8)) {
-            PyErr_SetString(PyExc_NotImplementedError, "Short raw data.");
-        } else {
-            bitstream_writer_write_bytes(self_p,
-                                         (uint8_t *)buf_p,
-                                         field_info_p->number_of_bits / 8);
-        }
+    if ((value == -1) && PyErr_Occurred()) {
+        return;
     }
+
+    write_signed_integer(self_p, value, field_info_p);
 }
 
-static PyObject *unpack_raw(struct bitstream_reader_t *self_p,
-                            struct field_info_t *field_info_p)
+static int pack_column_signed_integer(struct bitstream_writer_t *self_p,
+                                      struct field_info_t *field_info_p,
+                                      struct column_t *column_p,
+                                      Py_ssize_t index)
 {
-    uint8_t *buf_p;
-    PyObject *value_p;
-    int number_of_bytes;
+    uint64_t value;
 
-    number_of_bytes = (field_info_p->number_of_bits / 8);
-    value_p = PyBytes_FromStringAndSize(NULL, number_of_bytes);
-    buf_p = (uint8_t *)PyBytes_AS_STRING(value_p);
-    bitstream_reader_read_bytes(self_p, buf_p, number_of_bytes);
+    if (column_p->kind == 'i') {
+        return (write_signed_integer(self_p,
+                                     column_get_signed(column_p, index),
+                                     field_info_p));
+    }
 
-    return (value_p);
+    value = column_get_unsigned(column_p, index);
+
+    if (value > INT64_MAX) {
+        PyErr_Format(PyExc_OverflowError,
+                     "Signed integer value %llu out of range.",
+                     (unsigned long long)value);
+
+        return (-1);
+    }
+
+    return (write_signed_integer(self_p, (int64_t)value, field_info_p));
 }
 
-static void pack_zero_padding(struct bitstream_writer_t *self_p,
-                              PyObject *value_p,
-                              struct field_info_t *field_info_p)
+static int64_t read_signed_integer(struct bitstream_reader_t *self_p,
+                                   struct field_info_t *field_info_p)
 {
-    bitstream_writer_write_repeated_bit(self_p,
-                                        0,
-                                        field_info_p->number_of_bits);
+    uint64_t value;
+    uint64_t sign_bit;
+
+    value = read_field_bits(self_p, field_info_p);
+    sign_bit = (1ull << (field_info_p->number_of_bits - 1));
+
+    if (value & sign_bit) {
+        value |= ~(((sign_bit) << 1) - 1);
+    }
+
+    return ((int64_t)value);
 }
 
-static void pack_one_padding(struct bitstream_writer_t *self_p,
-                             PyObject *value_p,
-                             struct field_info_t *field_info_p)
+static PyObject *unpack_signed_integer(struct bitstream_reader_t *self_p,
+                                       struct field_info_t *field_info_p)
 {
-    bitstream_writer_write_repeated_bit(self_p,
-                                        1,
-                                        field_info_p->number_of_bits);
+    return (PyLong_FromLongLong(read_signed_integer(self_p, field_info_p)));
 }
 
-static PyObject *unpack_padding(struct bitstream_reader_t *self_p,
-                                struct field_info_t *field_info_p)
+static void unpack_column_signed_integer(struct bitstream_reader_t *self_p,
+                                         struct field_info_t *field_info_p,
+                                         void *column_p,
+                                         Py_ssize_t index)
 {
-    bitstream_reader_seek(self_p, field_info_p->number_of_bits);
-
-    return (NULL);
+    ((int64_t *)column_p)[index] = read_signed_integer(self_p, field_info_p);
 }
 
-static int field_info_init_signed(struct field_info_t *self_p,
-                                  int number_of_bits)
+/* Returns zero on success and -1 if the value is out of range. */
+static int write_unsigned_integer(struct bitstream_writer_t *self_p,
+                                  uint64_t value,
+                                  struct field_info_t *field_info_p)
 {
-    uint64_t limit;
+    int res;
 
-    self_p->pack = pack_signed_integer;
-    self_p->unpack = unpack_signed_integer;
+    res = 0;
 
-    if (number_of_bits > 64) {
-        PyErr_SetString(PyExc_NotImplementedError,
-                        "Signed integer over 64 bits.");
-        return (-1);
+    if (value > field_info_p->limits.u.upper) {
+        PyErr_Format(PyExc_OverflowError,
+                     "Unsigned integer value %llu out of range.",
+                     (unsigned long long)value);
+        res = -1;
     }
 
-    limit = (1ull << (number_of_bits - 1));
-    self_p->limits.s.lower = -limit;
-    self_p->limits.s.upper = (limit - 1);
+    write_field_bits(self_p, value, field_info_p);
 
-    return (0);
+    return (res);
 }
 
-static int field_info_init_unsigned(struct field_info_t *self_p,
-                                    int number_of_bits)
+static void pack_unsigned_integer(struct bitstream_writer_t *self_p,
+                                  PyObject *value_p,
+                                  struct field_info_t *field_info_p)
 {
-    self_p->pack = pack_unsigned_integer;
-    self_p->unpack = unpack_unsigned_integer;
+    uint64_t value;
 
-    if (number_of_bits > 64) {
-        PyErr_SetString(PyExc_NotImplementedError,
-                        "Unsigned integer over 64 bits.");
-        return (-1);
-    }
+    value = PyLong_AsUnsignedLongLong(value_p);
 
-    if (number_of_bits < 64) {
-        self_p->limits.u.upper = ((1ull << number_of_bits) - 1);
-    } else {
-        self_p->limits.u.upper = (uint64_t)-1;
+    if ((value == (uint64_t)-1) && PyErr_Occurred()) {
+        return;
     }
 
-    return (0);
+    write_unsigned_integer(self_p, value, field_info_p);
 }
 
-static int field_info_init_float(struct field_info_t *self_p,
-                                 int number_of_bits)
+static int pack_column_unsigned_integer(struct bitstream_writer_t *self_p,
+                                        struct field_info_t *field_info_p,
+                                        struct column_t *column_p,
+                                        Py_ssize_t index)
 {
-    switch (number_of_bits) {
+    int64_t value;
 
-#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 6
-    case 16:
-        self_p->pack = pack_float_16;
-        self_p->unpack = unpack_float_16;
-        break;
-#endif
+    if (column_p->kind == 'u') {
+        return (write_unsigned_integer(self_p,
+                                       column_get_unsigned(column_p, index),
+                                       field_info_p));
+    }
 
-    case 32:
-        self_p->pack = pack_float_32;
-        self_p->unpack = unpack_float_32;
-        break;
+    value = column_get_signed(column_p, index);
 
-    case 64:
-        self_p->pack = pack_float_64;
-        self_p->unpack = unpack_float_64;
-        break;
+    if (value < 0) {
+        PyErr_Format(PyExc_OverflowError,
+                     "Unsigned integer value %lld out of range.",
+                     (long long)value);
 
-    default:
-#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 6
-        PyErr_SetString(PyExc_NotImplementedError,
-                        "Float not 16, 32 or 64 bits.");
-#else
-        PyErr_SetString(PyExc_NotImplementedError, "Float not 32 or 64 bits.");
-#endif
         return (-1);
     }
 
-    return (0);
+    return (write_unsigned_integer(self_p, (uint64_t)value, field_info_p));
 }
 
-static int field_info_init_bool(struct field_info_t *self_p,
-                                int number_of_bits)
+static PyObject *unpack_unsigned_integer(struct bitstream_reader_t *self_p,
+                                         struct field_info_t *field_info_p)
 {
-    self_p->pack = pack_bool;
-    self_p->unpack = unpack_bool;
+    uint64_t value;
 
-    if (number_of_bits > 64) {
-        PyErr_SetString(PyExc_NotImplementedError, "Bool over 64 bits.");
-        return (-1);
+    value = read_field_bits(self_p, field_info_p);
+
+    return (PyLong_FromUnsignedLongLong(value));
+}
+
+static void unpack_column_unsigned_integer(struct bitstream_reader_t *self_p,
+                                           struct field_info_t *field_info_p,
+                                           void *column_p,
+                                           Py_ssize_t index)
+{
+    ((uint64_t *)column_p)[index] = read_field_bits(self_p, field_info_p);
+}
+
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 6
+
+static int write_float_16(struct bitstream_writer_t *self_p,
+                          double value,
+                          struct field_info_t *field_info_p)
+{
+    uint8_t buf[2];
+    int res;
+
+#if PY_VERSION_HEX >= 0x030B00A7
+    res = PyFloat_Pack2(value, (char*)&buf[0], 0);
+#else
+    res = _PyFloat_Pack2(value, &buf[0], 0);
+#endif
+    write_field_bits(self_p, ((uint64_t)buf[0] << 8) | buf[1], field_info_p);
+
+    return (res);
+}
+
+static void pack_float_16(struct bitstream_writer_t *self_p,
+                          PyObject *value_p,
+                          struct field_info_t *field_info_p)
+{
+    write_float_16(self_p, PyFloat_AsDouble(value_p), field_info_p);
+}
+
+static int pack_column_float_16(struct bitstream_writer_t *self_p,
+                                struct field_info_t *field_info_p,
+                                struct column_t *column_p,
+                                Py_ssize_t index)
+{
+    return (write_float_16(self_p,
+                           column_get_double(column_p, index),
+                           field_info_p));
+}
+
+static double read_float_16(struct bitstream_reader_t *self_p,
+                            struct field_info_t *field_info_p)
+{
+    uint8_t buf[2];
+    double value;
+    uint64_t data;
+
+    data = read_field_bits(self_p, field_info_p);
+    buf[0] = (uint8_t)(data >> 8);
+    buf[1] = (uint8_t)data;
+#if PY_VERSION_HEX >= 0x030B00A7
+    value = PyFloat_Unpack2((const char*)&buf[0], 0);
+#else
+    value = _PyFloat_Unpack2(&buf[0], 0);
+#endif
+
+    return (value);
+}
+
+static PyObject *unpack_float_16(struct bitstream_reader_t *self_p,
+                                 struct field_info_t *field_info_p)
+{
+    return (PyFloat_FromDouble(read_float_16(self_p, field_info_p)));
+}
+
+static void unpack_column_float_16(struct bitstream_reader_t *self_p,
+                                   struct field_info_t *field_info_p,
+                                   void *column_p,
+                                   Py_ssize_t index)
+{
+    ((double *)column_p)[index] = read_float_16(self_p, field_info_p);
+}
+
+#endif
+
+static void write_float_32(struct bitstream_writer_t *self_p,
+                           float value,
+                           struct field_info_t *field_info_p)
+{
+    uint32_t data;
+
+    memcpy(&data, &value, sizeof(data));
+    write_field_bits(self_p, data, field_info_p);
+}
+
+static void pack_float_32(struct bitstream_writer_t *self_p,
+                          PyObject *value_p,
+                          struct field_info_t *field_info_p)
+{
+    write_float_32(self_p, (float)PyFloat_AsDouble(value_p), field_info_p);
+}
+
+static int pack_column_float_32(struct bitstream_writer_t *self_p,
+                                struct field_info_t *field_info_p,
+                                struct column_t *column_p,
+                                Py_ssize_t index)
+{
+    write_float_32(self_p,
+                   (float)column_get_double(column_p, index),
+                   field_info_p);
+
+    return (0);
+}
+
+static double read_float_32(struct bitstream_reader_t *self_p,
+                            struct field_info_t *field_info_p)
+{
+    float value;
+    uint32_t data;
+
+    data = (uint32_t)read_field_bits(self_p, field_info_p);
+    memcpy(&value, &data, sizeof(value));
+
+    return (value);
+}
+
+static PyObject *unpack_float_32(struct bitstream_reader_t *self_p,
+                                 struct field_info_t *field_info_p)
+{
+    return (PyFloat_FromDouble(read_float_32(self_p, field_info_p)));
+}
+
+static void unpack_column_float_32(struct bitstream_reader_t *self_p,
+                                   struct field_info_t *field_info_p,
+                                   void *column_p,
+                                   Py_ssize_t index)
+{
+    ((double *)column_p)[index] = read_float_32(self_p, field_info_p);
+}
+
+static void write_float_64(struct bitstream_writer_t *self_p,
+                           double value,
+                           struct field_info_t *field_info_p)
+{
+    uint64_t data;
+
+    memcpy(&data, &value, sizeof(data));
+    write_field_bits(self_p, data, field_info_p);
+}
+
+static void pack_float_64(struct bitstream_writer_t *self_p,
+                          PyObject *value_p,
+                          struct field_info_t *field_info_p)
+{
+    write_float_64(self_p, PyFloat_AsDouble(value_p), field_info_p);
+}
+
+static int pack_column_float_64(struct bitstream_writer_t *self_p,
+                                struct field_info_t *field_info_p,
+                                struct column_t *column_p,
+                                Py_ssize_t index)
+{
+    write_float_64(self_p, column_get_double(column_p, index), field_info_p);
+
+    return (0);
+}
+
+static double read_float_64(struct bitstream_reader_t *self_p,
+                            struct field_info_t *field_info_p)
+{
+    double value;
+    uint64_t data;
+
+    data = read_field_bits(self_p, field_info_p);
+    memcpy(&value, &data, sizeof(value));
+
+    return (value);
+}
+
+static PyObject *unpack_float_64(struct bitstream_reader_t *self_p,
+                                 struct field_info_t *field_info_p)
+{
+    return (PyFloat_FromDouble(read_float_64(self_p, field_info_p)));
+}
+
+static void unpack_column_float_64(struct bitstream_reader_t *self_p,
+                                   struct field_info_t *field_info_p,
+                                   void *column_p,
+                                   Py_ssize_t index)
+{
+    ((double *)column_p)[index] = read_float_64(self_p, field_info_p);
+}
+
+static void pack_bool(struct bitstream_writer_t *self_p,
+                      PyObject *value_p,
+                      struct field_info_t *field_info_p)
+{
+    write_field_bits(self_p, PyObject_IsTrue(value_p), field_info_p);
+}
+
+static int pack_column_bool(struct bitstream_writer_t *self_p,
+                            struct field_info_t *field_info_p,
+                            struct column_t *column_p,
+                            Py_ssize_t index)
+{
+    write_field_bits(self_p,
+                     column_get_unsigned(column_p, index) != 0,
+                     field_info_p);
+
+    return (0);
+}
+
+static PyObject *unpack_bool(struct bitstream_reader_t *self_p,
+                             struct field_info_t *field_info_p)
+{
+    return (PyBool_FromLong(read_field_bits(self_p, field_info_p) != 0));
+}
+
+static void unpack_column_bool(struct bitstream_reader_t *self_p,
+                               struct field_info_t *field_info_p,
+                               void *column_p,
+                               Py_ssize_t index)
+{
+    ((uint8_t *)column_p)[index] = (read_field_bits(self_p, field_info_p) != 0);
+}
+
+static void pack_text(struct bitstream_writer_t *self_p,
+                      PyObject *value_p,
+                      struct field_info_t *field_info_p)
+{
+    Py_ssize_t size;
+    const char* buf_p;
+
+    buf_p = PyUnicode_AsUTF8AndSize(value_p, &size);
+
+    if (buf_p != NULL) {
+        if (size < (field_info_p->number_of_bits / 8)) {
+            PyErr_SetString(PyExc_NotImplementedError, "Short text.");
+        } else {
+            write_field_bytes(self_p, (uint8_t *)buf_p, field_info_p);
+        }
+    }
+}
+
+static PyObject *unpack_text(struct bitstream_reader_t *self_p,
+                             struct field_info_t *field_info_p)
+{
+    uint8_t *buf_p;
+    PyObject *value_p;
+    int number_of_bytes;
+
+    number_of_bytes = (field_info_p->number_of_bits / 8);
+    buf_p = PyMem_RawMalloc(number_of_bytes);
+
+    if (buf_p == NULL) {
+        return (NULL);
+    }
+
+    read_field_bytes(self_p, buf_p, field_info_p);
+    value_p = PyUnicode_FromStringAndSize((const char *)buf_p, number_of_bytes);
+    PyMem_RawFree(buf_p);
+
+    return (value_p);
+}
+
+static void pack_raw(struct bitstream_writer_t *self_p,
+                     PyObject *value_p,
+                     struct field_info_t *field_info_p)
+{
+    Py_ssize_t size;
+    char* buf_p;
+    int res;
+
+    res = PyBytes_AsStringAndSize(value_p, &buf_p, &size);
+
+    if (res != -1) {
+        if (size < (field_info_p->number_of_bits / 8)) {
+            PyErr_SetString(PyExc_NotImplementedError, "Short raw data.");
+        } else {
+            write_field_bytes(self_p, (uint8_t *)buf_p, field_info_p);
+        }
+    }
+}
+
+static PyObject *unpack_raw(struct bitstream_reader_t *self_p,
+                            struct field_info_t *field_info_p)
+{
+    uint8_t *buf_p;
+    PyObject *value_p;
+    int number_of_bytes;
+
+    number_of_bytes = (field_info_p->number_of_bits / 8);
+    value_p = PyBytes_FromStringAndSize(NULL, number_of_bytes);
+    buf_p = (uint8_t *)PyBytes_AS_STRING(value_p);
+    read_field_bytes(self_p, buf_p, field_info_p);
+
+    return (value_p);
+}
+
+/* Byte aligned raw fields are unpacked as slices of one memoryview of
+   the data, created on first use. */
+struct raw_memoryview_t {
+    PyObject *data_p;
+    /* Start of the data as read by the reader. */
+    const uint8_t *buf_p;
+    PyObject *memoryview_p;
+};
+
+/* Returns given raw memoryview if the format unpacks raw fields as
+   memoryviews, and otherwise NULL. */
+static struct raw_memoryview_t *raw_memoryview_init(
+    struct raw_memoryview_t *self_p,
+    struct info_t *info_p,
+    PyObject *data_p,
+    Py_buffer *view_p)
+{
+    if (!info_p->raw_as_memoryview) {
+        return (NULL);
+    }
+
+    self_p->data_p = data_p;
+    self_p->buf_p = (const uint8_t *)view_p->buf;
+    self_p->memoryview_p = NULL;
+
+    return (self_p);
+}
+
+static void raw_memoryview_destroy(struct raw_memoryview_t *self_p)
+{
+    if (self_p != NULL) {
+        Py_XDECREF(self_p->memoryview_p);
+    }
+}
+
+static PyObject *unpack_raw_memoryview(struct bitstream_reader_t *reader_p,
+                                       struct field_info_t *field_info_p,
+                                       struct raw_memoryview_t *self_p)
+{
+    PyObject *memoryview_p;
+    PyObject *value_p;
+    Py_buffer *view_p;
+    Py_ssize_t start;
+
+    if (self_p->memoryview_p == NULL) {
+        memoryview_p = PyMemoryView_FromObject(self_p->data_p);
+
+        if (memoryview_p == NULL) {
+            return (NULL);
+        }
+
+        view_p = PyMemoryView_GET_BUFFER(memoryview_p);
+
+        if ((view_p->ndim == 1) && (view_p->itemsize == 1)) {
+            self_p->memoryview_p = memoryview_p;
+        } else {
+            self_p->memoryview_p = PyObject_CallMethod(memoryview_p,
+                                                       "cast",
+                                                       "s",
+                                                       "B");
+            Py_DECREF(memoryview_p);
+
+            if (self_p->memoryview_p == NULL) {
+                return (NULL);
+            }
+        }
+    }
+
+    start = (reader_p->buf_p + reader_p->byte_offset - self_p->buf_p);
+    value_p = PySequence_GetSlice(self_p->memoryview_p,
+                                  start,
+                                  start + field_info_p->number_of_bits / 8);
+    bitstream_reader_seek(reader_p, field_info_p->number_of_bits);
+
+    return (value_p);
+}
+
+/* Unpack given field, as a memoryview if a byte aligned raw field and
+   raw memoryviews are enabled. Unaligned raw fields are copied. */
+static PyObject *unpack_field(struct bitstream_reader_t *reader_p,
+                              struct field_info_t *field_info_p,
+                              struct raw_memoryview_t *raw_p)
+{
+    if ((raw_p != NULL)
+        && (field_info_p->unpack == unpack_raw)
+        && (reader_p->bit_offset == 0)
+        && !field_info_p->is_bit_order_lsb_first) {
+        return (unpack_raw_memoryview(reader_p, field_info_p, raw_p));
+    }
+
+    return (field_info_p->unpack(reader_p, field_info_p));
+}
+
+static void pack_zero_padding(struct bitstream_writer_t *self_p,
+                              PyObject *value_p,
+                              struct field_info_t *field_info_p)
+{
+    bitstream_writer_write_repeated_bit(self_p,
+                                        0,
+                                        field_info_p->number_of_bits);
+}
+
+static void pack_one_padding(struct bitstream_writer_t *self_p,
+                             PyObject *value_p,
+                             struct field_info_t *field_info_p)
+{
+    bitstream_writer_write_repeated_bit(self_p,
+                                        1,
+                                        field_info_p->number_of_bits);
+}
+
+static int pack_column_padding(struct bitstream_writer_t *self_p,
+                               struct field_info_t *field_info_p,
+                               struct column_t *column_p,
+                               Py_ssize_t index)
+{
+    field_info_p->pack(self_p, NULL, field_info_p);
+
+    return (0);
+}
+
+static PyObject *unpack_padding(struct bitstream_reader_t *self_p,
+                                struct field_info_t *field_info_p)
+{
+    bitstream_reader_seek(self_p, field_info_p->number_of_bits);
+
+    return (NULL);
+}
+
+static void unpack_column_padding(struct bitstream_reader_t *self_p,
+                                  struct field_info_t *field_info_p,
+                                  void *column_p,
+                                  Py_ssize_t index)
+{
+    bitstream_reader_seek(self_p, field_info_p->number_of_bits);
+}
+
+/* Returns zero on success and -1 if the value is out of range. The
+   name is the first word(s) of the error message. */
+static int check_unsigned_value(uint64_t value,
+                                struct field_info_t *field_info_p,
+                                const char *name_p)
+{
+    if (value > field_info_p->limits.u.upper) {
+        PyErr_Format(PyExc_OverflowError,
+                     "%s value %llu out of range.",
+                     name_p,
+                     (unsigned long long)value);
+
+        return (-1);
+    }
+
+    return (0);
+}
+
+static int check_signed_value(int64_t value,
+                              struct field_info_t *field_info_p,
+                              const char *name_p)
+{
+    if ((value < field_info_p->limits.s.lower)
+        || (value > field_info_p->limits.s.upper)) {
+        PyErr_Format(PyExc_OverflowError,
+                     "%s value %lld out of range.",
+                     name_p,
+                     (long long)value);
+
+        return (-1);
+    }
+
+    return (0);
+}
+
+static int get_unsigned_value(PyObject *value_p,
+                              struct field_info_t *field_info_p,
+                              const char *name_p,
+                              uint64_t *result_p)
+{
+    *result_p = PyLong_AsUnsignedLongLong(value_p);
+
+    if ((*result_p == (uint64_t)-1) && PyErr_Occurred()) {
+        return (-1);
+    }
+
+    return (check_unsigned_value(*result_p, field_info_p, name_p));
+}
+
+static int get_signed_value(PyObject *value_p,
+                            struct field_info_t *field_info_p,
+                            const char *name_p,
+                            int64_t *result_p)
+{
+    *result_p = PyLong_AsLongLong(value_p);
+
+    if ((*result_p == -1) && PyErr_Occurred()) {
+        return (-1);
+    }
+
+    return (check_signed_value(*result_p, field_info_p, name_p));
+}
+
+/* Variable length integer fields. Unpack returns NULL without an
+   exception if the data is short. */
+#define VARIABLE_LENGTH_FIELD(code, type, sign, from_value, name)       \
+    static long long size_ ## code(PyObject *value_p,                   \
+                                   struct field_info_t *field_info_p)   \
+    {                                                                   \
+        type value;                                                     \
+                                                                        \
+        if (get_ ## sign ## _value(value_p,                             \
+                                   field_info_p,                        \
+                                   name,                                \
+                                   &value) != 0) {                      \
+            return (-1);                                                \
+        }                                                               \
+                                                                        \
+        return (bitstream_ ## code ## _size(value));                    \
+    }                                                                   \
+                                                                        \
+    static void pack_ ## code(struct bitstream_writer_t *self_p,        \
+                              PyObject *value_p,                        \
+                              struct field_info_t *field_info_p)        \
+    {                                                                   \
+        type value;                                                     \
+                                                                        \
+        if (get_ ## sign ## _value(value_p,                             \
+                                   field_info_p,                        \
+                                   name,                                \
+                                   &value) != 0) {                      \
+            return;                                                     \
+        }                                                               \
+                                                                        \
+        bitstream_writer_write_ ## code(self_p, value);                 \
+    }                                                                   \
+                                                                        \
+    static PyObject *unpack_ ## code(struct bitstream_reader_t *self_p, \
+                                     struct field_info_t *field_info_p) \
+    {                                                                   \
+        type value;                                                     \
+        int res;                                                        \
+                                                                        \
+        res = bitstream_reader_read_ ## code(self_p, &value);           \
+                                                                        \
+        if (res == -1) {                                                \
+            return (NULL);                                              \
+        }                                                               \
+                                                                        \
+        if (res != 0) {                                                 \
+            PyErr_SetString(PyExc_ValueError, "Bad " name " code.");    \
+                                                                        \
+            return (NULL);                                              \
+        }                                                               \
+                                                                        \
+        if (check_ ## sign ## _value(value, field_info_p, name) != 0) { \
+            return (NULL);                                              \
+        }                                                               \
+                                                                        \
+        return (from_value(value));                                     \
+    }
+
+VARIABLE_LENGTH_FIELD(exp_golomb,
+                      uint64_t,
+                      unsigned,
+                      PyLong_FromUnsignedLongLong,
+                      "Exp-Golomb")
+VARIABLE_LENGTH_FIELD(exp_golomb_signed,
+                      int64_t,
+                      signed,
+                      PyLong_FromLongLong,
+                      "Exp-Golomb")
+VARIABLE_LENGTH_FIELD(leb128,
+                      uint64_t,
+                      unsigned,
+                      PyLong_FromUnsignedLongLong,
+                      "LEB128")
+VARIABLE_LENGTH_FIELD(sleb128,
+                      int64_t,
+                      signed,
+                      PyLong_FromLongLong,
+                      "LEB128")
+
+/* The prefix code may be set by one thread while others are packing
+   and unpacking, so it is published with release and read with
+   acquire semantics. */
+#ifdef Py_GIL_DISABLED
+#    define PREFIX_CODE_LOAD(prefix_code_pp)            \
+    _Py_atomic_load_ptr_acquire(prefix_code_pp)
+#    define PREFIX_CODE_STORE(prefix_code_pp, prefix_code_p)    \
+    _Py_atomic_store_ptr_release(prefix_code_pp, prefix_code_p)
+#else
+#    define PREFIX_CODE_LOAD(prefix_code_pp) (*(prefix_code_pp))
+#    define PREFIX_CODE_STORE(prefix_code_pp, prefix_code_p)    \
+    (*(prefix_code_pp) = (prefix_code_p))
+#endif
+
+static const struct prefix_code_t *get_prefix_code(
+    struct field_info_t *field_info_p)
+{
+    const struct prefix_code_t *prefix_code_p;
+
+    prefix_code_p = PREFIX_CODE_LOAD(&field_info_p->prefix_code_p);
+
+    if (prefix_code_p == NULL) {
+        PyErr_SetString(PyExc_ValueError, "No prefix code.");
+    }
+
+    return (prefix_code_p);
+}
+
+/* Returns the code of given symbol, or NULL on failure. */
+static const struct bitstream_prefix_code_entry_t *get_prefix_code_symbol(
+    PyObject *value_p,
+    struct field_info_t *field_info_p)
+{
+    const struct prefix_code_t *prefix_code_p;
+    uint64_t value;
+
+    prefix_code_p = get_prefix_code(field_info_p);
+
+    if (prefix_code_p == NULL) {
+        return (NULL);
+    }
+
+    if (get_unsigned_value(value_p,
+                           field_info_p,
+                           "Unsigned integer",
+                           &value) != 0) {
+        return (NULL);
+    }
+
+    if (value >= (uint64_t)prefix_code_p->number_of_symbols) {
+        PyErr_Format(PyExc_ValueError,
+                     "No prefix code for symbol %llu.",
+                     (unsigned long long)value);
+
+        return (NULL);
+    }
+
+    return (&prefix_code_p->symbols_p[value]);
+}
+
+static long long size_prefix_code(PyObject *value_p,
+                                  struct field_info_t *field_info_p)
+{
+    const struct bitstream_prefix_code_entry_t *symbol_p;
+
+    symbol_p = get_prefix_code_symbol(value_p, field_info_p);
+
+    if (symbol_p == NULL) {
+        return (-1);
+    }
+
+    return (symbol_p->length);
+}
+
+static void pack_prefix_code(struct bitstream_writer_t *self_p,
+                             PyObject *value_p,
+                             struct field_info_t *field_info_p)
+{
+    const struct bitstream_prefix_code_entry_t *symbol_p;
+
+    symbol_p = get_prefix_code_symbol(value_p, field_info_p);
+
+    if (symbol_p == NULL) {
+        return;
+    }
+
+    bitstream_writer_write_u64_bits(self_p, symbol_p->code, symbol_p->length);
+}
+
+static PyObject *unpack_prefix_code(struct bitstream_reader_t *self_p,
+                                    struct field_info_t *field_info_p)
+{
+    const struct prefix_code_t *prefix_code_p;
+    uint32_t symbol;
+    int res;
+
+    prefix_code_p = get_prefix_code(field_info_p);
+
+    if (prefix_code_p == NULL) {
+        return (NULL);
+    }
+
+    res = bitstream_reader_read_prefix_code(self_p,
+                                            &prefix_code_p->decoder,
+                                            &symbol);
+
+    if (res == -1) {
+        return (NULL);
+    }
+
+    if (res != 0) {
+        PyErr_SetString(PyExc_ValueError, "Bad prefix code.");
+
+        return (NULL);
+    }
+
+    if (check_unsigned_value(symbol, field_info_p, "Unsigned integer") != 0) {
+        return (NULL);
+    }
+
+    return (PyLong_FromUnsignedLong(symbol));
+}
+
+static int field_info_init_signed(struct field_info_t *self_p,
+                                  int number_of_bits)
+{
+    uint64_t limit;
+
+    self_p->pack = pack_signed_integer;
+    self_p->unpack = unpack_signed_integer;
+    self_p->unpack_column = unpack_column_signed_integer;
+    self_p->pack_column = pack_column_signed_integer;
+    self_p->column_type_code = 'q';
+
+    if (number_of_bits > 64) {
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "Signed integer over 64 bits.");
+        return (-1);
+    }
+
+    limit = (1ull << (number_of_bits - 1));
+    self_p->limits.s.lower = -limit;
+    self_p->limits.s.upper = (limit - 1);
+
+    return (0);
+}
+
+static int field_info_init_unsigned(struct field_info_t *self_p,
+                                    int number_of_bits)
+{
+    self_p->pack = pack_unsigned_integer;
+    self_p->unpack = unpack_unsigned_integer;
+    self_p->unpack_column = unpack_column_unsigned_integer;
+    self_p->pack_column = pack_column_unsigned_integer;
+    self_p->column_type_code = 'Q';
+
+    if (number_of_bits > 64) {
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "Unsigned integer over 64 bits.");
+        return (-1);
+    }
+
+    if (number_of_bits < 64) {
+        self_p->limits.u.upper = ((1ull << number_of_bits) - 1);
+    } else {
+        self_p->limits.u.upper = (uint64_t)-1;
+    }
+
+    return (0);
+}
+
+static int field_info_init_float(struct field_info_t *self_p,
+                                 int number_of_bits)
+{
+    self_p->column_type_code = 'd';
+
+    switch (number_of_bits) {
+
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 6
+    case 16:
+        self_p->pack = pack_float_16;
+        self_p->unpack = unpack_float_16;
+        self_p->unpack_column = unpack_column_float_16;
+        self_p->pack_column = pack_column_float_16;
+        break;
+#endif
+
+    case 32:
+        self_p->pack = pack_float_32;
+        self_p->unpack = unpack_float_32;
+        self_p->unpack_column = unpack_column_float_32;
+        self_p->pack_column = pack_column_float_32;
+        break;
+
+    case 64:
+        self_p->pack = pack_float_64;
+        self_p->unpack = unpack_float_64;
+        self_p->unpack_column = unpack_column_float_64;
+        self_p->pack_column = pack_column_float_64;
+        break;
+
+    default:
+#if PY_MAJOR_VERSION == 3 && PY_MINOR_VERSION >= 6
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "Float not 16, 32 or 64 bits.");
+#else
+        PyErr_SetString(PyExc_NotImplementedError, "Float not 32 or 64 bits.");
+#endif
+        return (-1);
+    }
+
+    return (0);
+}
+
+static int field_info_init_bool(struct field_info_t *self_p,
+                                int number_of_bits)
+{
+    self_p->pack = pack_bool;
+    self_p->unpack = unpack_bool;
+    self_p->unpack_column = unpack_column_bool;
+    self_p->pack_column = pack_column_bool;
+    self_p->column_type_code = 'B';
+
+    if (number_of_bits > 64) {
+        PyErr_SetString(PyExc_NotImplementedError, "Bool over 64 bits.");
+        return (-1);
+    }
+
+    return (0);
+}
+
+static int field_info_init_text(struct field_info_t *self_p,
+                                int number_of_bits)
+{
+    self_p->pack = pack_text;
+    self_p->unpack = unpack_text;
+    self_p->unpack_column = NULL;
+    self_p->pack_column = NULL;
+    self_p->column_type_code = '\0';
+
+    if ((number_of_bits % 8) != 0) {
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "Text not multiple of 8 bits.");
+        return (-1);
+    }
+
+    return (0);
+}
+
+static int field_info_init_raw(struct field_info_t *self_p,
+                               int number_of_bits)
+{
+    self_p->pack = pack_raw;
+    self_p->unpack = unpack_raw;
+    self_p->unpack_column = NULL;
+    self_p->pack_column = NULL;
+    self_p->column_type_code = '\0';
+
+    if ((number_of_bits % 8) != 0) {
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "Raw not multiple of 8 bits.");
+        return (-1);
+    }
+
+    return (0);
+}
+
+/* Exp-Golomb fields of given width in bits, at least one bit
+   packed. */
+static int field_info_init_exp_golomb(struct field_info_t *self_p,
+                                      int number_of_bits,
+                                      bool is_signed)
+{
+    int res;
+
+    if (is_signed) {
+        res = field_info_init_signed(self_p, number_of_bits);
+        self_p->pack = pack_exp_golomb_signed;
+        self_p->unpack = unpack_exp_golomb_signed;
+        self_p->size = size_exp_golomb_signed;
+
+        /* As its code would not fit in 64 bits. */
+        if (self_p->limits.s.lower == INT64_MIN) {
+            self_p->limits.s.lower++;
+        }
+    } else {
+        res = field_info_init_unsigned(self_p, number_of_bits);
+        self_p->pack = pack_exp_golomb;
+        self_p->unpack = unpack_exp_golomb;
+        self_p->size = size_exp_golomb;
+
+        if (self_p->limits.u.upper == UINT64_MAX) {
+            self_p->limits.u.upper--;
+        }
+    }
+
+    self_p->unpack_column = NULL;
+    self_p->pack_column = NULL;
+    self_p->column_type_code = '\0';
+
+    return (res);
+}
+
+/* LEB128 fields of given width in bits, at least one byte packed. */
+static int field_info_init_leb128(struct field_info_t *self_p,
+                                  int number_of_bits,
+                                  bool is_signed)
+{
+    int res;
+
+    if (is_signed) {
+        res = field_info_init_signed(self_p, number_of_bits);
+        self_p->pack = pack_sleb128;
+        self_p->unpack = unpack_sleb128;
+        self_p->size = size_sleb128;
+    } else {
+        res = field_info_init_unsigned(self_p, number_of_bits);
+        self_p->pack = pack_leb128;
+        self_p->unpack = unpack_leb128;
+        self_p->size = size_leb128;
+    }
+
+    self_p->unpack_column = NULL;
+    self_p->pack_column = NULL;
+    self_p->column_type_code = '\0';
+
+    return (res);
+}
+
+/* Prefix code fields of given symbol width in bits, at least one bit
+   packed. The code is set later on the compiled format. */
+static int field_info_init_prefix_code(struct field_info_t *self_p,
+                                       int number_of_bits)
+{
+    int res;
+
+    res = field_info_init_unsigned(self_p, number_of_bits);
+    self_p->pack = pack_prefix_code;
+    self_p->unpack = unpack_prefix_code;
+    self_p->size = size_prefix_code;
+    self_p->unpack_column = NULL;
+    self_p->pack_column = NULL;
+    self_p->column_type_code = '\0';
+
+    return (res);
+}
+
+static int field_info_init_zero_padding(struct field_info_t *self_p)
+{
+    self_p->pack = pack_zero_padding;
+    self_p->unpack = unpack_padding;
+    self_p->unpack_column = unpack_column_padding;
+    self_p->pack_column = pack_column_padding;
+    self_p->column_type_code = '\0';
+
+    return (0);
+}
+
+static int field_info_init_one_padding(struct field_info_t *self_p)
+{
+    self_p->pack = pack_one_padding;
+    self_p->unpack = unpack_padding;
+    self_p->unpack_column = unpack_column_padding;
+    self_p->pack_column = pack_column_padding;
+    self_p->column_type_code = '\0';
+
+    return (0);
+}
+
+/* Select byte aligned kernels for fields of 8, 16, 32 and 64 bits. */
+static void field_info_init_kernels(struct field_info_t *self_p, int kind)
+{
+    self_p->load = NULL;
+    self_p->store = NULL;
+
+    if ((kind != 's') && (kind != 'u') && (kind != 'f') && (kind != 'b')) {
+        return;
+    }
+
+    switch (self_p->number_of_bits) {
+
+    case 8:
+        self_p->load = load_u8;
+        self_p->store = store_u8;
+        break;
+
+    case 16:
+        if (self_p->is_byte_order_lsb_first) {
+            self_p->load = load_u16_LE;
+            self_p->store = store_u16_LE;
+        } else {
+            self_p->load = load_u16_BE;
+            self_p->store = store_u16_BE;
+        }
+
+        break;
+
+    case 32:
+        if (self_p->is_byte_order_lsb_first) {
+            self_p->load = load_u32_LE;
+            self_p->store = store_u32_LE;
+        } else {
+            self_p->load = load_u32_BE;
+            self_p->store = store_u32_BE;
+        }
+
+        break;
+
+    case 64:
+        if (self_p->is_byte_order_lsb_first) {
+            self_p->load = load_u64_LE;
+            self_p->store = store_u64_LE;
+        } else {
+            self_p->load = load_u64_BE;
+            self_p->store = store_u64_BE;
+        }
+
+        break;
+
+    default:
+        break;
+    }
+}
+
+static int field_info_init(struct field_info_t *self_p,
+                           int kind,
+                           int number_of_bits,
+                           bool is_bit_order_lsb_first,
+                           bool is_byte_order_lsb_first)
+{
+    int res;
+    bool is_padding;
+
+    is_padding = false;
+    self_p->size = NULL;
+    self_p->prefix_code_p = NULL;
+
+    switch (kind) {
+
+    case 's':
+        res = field_info_init_signed(self_p, number_of_bits);
+        break;
+
+    case 'u':
+        res = field_info_init_unsigned(self_p, number_of_bits);
+        break;
+
+    case 'f':
+        res = field_info_init_float(self_p, number_of_bits);
+        break;
+
+    case 'b':
+        res = field_info_init_bool(self_p, number_of_bits);
+        break;
+
+    case 't':
+        res = field_info_init_text(self_p, number_of_bits);
+        break;
+
+    case 'r':
+        res = field_info_init_raw(self_p, number_of_bits);
+        break;
+
+    case 'e':
+        res = field_info_init_exp_golomb(self_p, number_of_bits, false);
+        number_of_bits = 1;
+        break;
+
+    case 'E':
+        res = field_info_init_exp_golomb(self_p, number_of_bits, true);
+        number_of_bits = 1;
+        break;
+
+    case 'v':
+        res = field_info_init_leb128(self_p, number_of_bits, false);
+        number_of_bits = 8;
+        break;
+
+    case 'V':
+        res = field_info_init_leb128(self_p, number_of_bits, true);
+        number_of_bits = 8;
+        break;
+
+    case 'h':
+        res = field_info_init_prefix_code(self_p, number_of_bits);
+        number_of_bits = 1;
+        break;
+
+    case 'p':
+        is_padding = true;
+        res = field_info_init_zero_padding(self_p);
+        break;
+
+    case 'P':
+        is_padding = true;
+        res = field_info_init_one_padding(self_p);
+        break;
+
+    default:
+        PyErr_Format(PyExc_ValueError, "Bad format field type '%c'.", kind);
+        res = -1;
+        break;
+    }
+
+    self_p->number_of_bits = number_of_bits;
+    self_p->is_padding = is_padding;
+    self_p->is_bit_order_lsb_first = is_bit_order_lsb_first;
+
+    /* Byte order does not apply to text and raw. */
+    if ((kind == 't') || (kind == 'r')) {
+        is_byte_order_lsb_first = false;
+    }
+
+    self_p->is_byte_order_lsb_first = is_byte_order_lsb_first;
+
+    /* Variable length codes have a fixed bit and byte order. */
+    if ((res == 0) && (self_p->size != NULL)) {
+        if (is_bit_order_lsb_first) {
+            PyErr_SetString(
+                PyExc_ValueError,
+                "Bit order does not apply to variable length fields.");
+            res = -1;
+        } else if (is_byte_order_lsb_first) {
+            PyErr_SetString(
+                PyExc_ValueError,
+                "Byte order does not apply to variable length fields.");
+            res = -1;
+        }
+    }
+
+    field_info_init_kernels(self_p, kind);
+
+    return (res);
+}
+
+static int count_number_of_fields(const char *format_p,
+                                  int *number_of_padding_fields_p)
+{
+    int count;
+
+    count = 0;
+    *number_of_padding_fields_p = 0;
+
+    while (*format_p != '\0') {
+        if ((*format_p >= 'A') && (*format_p <= 'z')) {
+            count++;
+
+            if ((*format_p == 'p') || (*format_p == 'P')) {
+                (*number_of_padding_fields_p)++;
+            }
+        }
+
+        format_p++;
+    }
+
+    return (count);
+}
+
+/* The bit order is kept from the previous field if not given. */
+const char *parse_field(const char *format_p,
+                        int *kind_p,
+                        int *number_of_bits_p,
+                        bool *is_bit_order_lsb_first_p)
+{
+    while (isspace(*format_p)) {
+        format_p++;
+    }
+
+    if (*format_p == '<') {
+        *is_bit_order_lsb_first_p = true;
+        format_p++;
+    } else if (*format_p == '>') {
+        *is_bit_order_lsb_first_p = false;
+        format_p++;
+    }
+
+    *kind_p = *format_p;
+    *number_of_bits_p = 0;
+    format_p++;
+
+    while (isdigit(*format_p)) {
+        if (*number_of_bits_p > (INT_MAX / 100)) {
+            PyErr_SetString(PyExc_ValueError, "Field too long.");
+
+            return (NULL);
+        }
+
+        *number_of_bits_p *= 10;
+        *number_of_bits_p += (*format_p - '0');
+        format_p++;
+    }
+
+    if (*number_of_bits_p == 0) {
+        PyErr_SetString(PyExc_ValueError, "Field of size 0.");
+        format_p = NULL;
+    }
+
+    return (format_p);
+}
+
+static struct info_t *parse_format(PyObject *format_obj_p)
+{
+    int number_of_fields;
+    struct info_t *info_p;
+    const char *format_p;
+    int i;
+    int kind;
+    int number_of_bits;
+    int number_of_padding_fields;
+    int res;
+    size_t length;
+    bool is_bit_order_lsb_first;
+    bool is_byte_order_lsb_first;
+
+    format_p = PyUnicode_AsUTF8(format_obj_p);
+
+    if (format_p == NULL) {
+        return (NULL);
+    }
+
+    /* Optional byte order last in the format string. */
+    length = strlen(format_p);
+    is_byte_order_lsb_first = ((length > 0) && (format_p[length - 1] == '<'));
+    is_bit_order_lsb_first = false;
+
+    number_of_fields = count_number_of_fields(format_p,
+                                              &number_of_padding_fields);
+
+    info_p = PyMem_RawMalloc(
+        sizeof(*info_p) + number_of_fields * sizeof(info_p->fields[0]));
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    info_p->refcount = 1;
+    info_p->number_of_bits = 0;
+    info_p->number_of_fields = number_of_fields;
+    info_p->number_of_non_padding_fields = (
+        number_of_fields - number_of_padding_fields);
+    info_p->number_of_variable_length_fields = 0;
+    info_p->raw_as_memoryview = false;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        format_p = parse_field(format_p,
+                               &kind,
+                               &number_of_bits,
+                               &is_bit_order_lsb_first);
+
+        if (format_p == NULL) {
+            PyMem_RawFree(info_p);
+
+            return (NULL);
+        }
+
+        res = field_info_init(&info_p->fields[i],
+                              kind,
+                              number_of_bits,
+                              is_bit_order_lsb_first,
+                              is_byte_order_lsb_first);
+
+        if (res != 0) {
+            PyMem_RawFree(info_p);
+
+            return (NULL);
+        }
+
+        number_of_bits = info_p->fields[i].number_of_bits;
+
+        if (number_of_bits > (INT_MAX - info_p->number_of_bits)) {
+            PyErr_SetString(PyExc_ValueError, "Format too long.");
+            PyMem_RawFree(info_p);
+
+            return (NULL);
+        }
+
+        info_p->number_of_bits += number_of_bits;
+
+        if (info_p->fields[i].size != NULL) {
+            info_p->number_of_variable_length_fields++;
+        }
+    }
+
+    return (info_p);
+}
+
+/* Maximum number of formats in the cache used by the module level
+   functions. */
+#define FORMAT_CACHE_SIZE 64
+
+struct format_cache_entry_t {
+    PyObject *format_p;
+    Py_hash_t hash;
+    struct info_t *info_p;
+    unsigned long long last_used;
+};
+
+static struct {
+    struct format_cache_entry_t entries[FORMAT_CACHE_SIZE];
+    unsigned long long tick;
+    Py_ssize_t hits;
+    Py_ssize_t misses;
+} format_cache;
+
+#ifdef Py_GIL_DISABLED
+static PyMutex format_cache_mutex = { 0 };
+#    define FORMAT_CACHE_LOCK() PyMutex_Lock(&format_cache_mutex)
+#    define FORMAT_CACHE_UNLOCK() PyMutex_Unlock(&format_cache_mutex)
+#else
+#    define FORMAT_CACHE_LOCK()
+#    define FORMAT_CACHE_UNLOCK()
+#endif
+
+/* Must be called with the cache locked. Returns true if the info
+   should be freed. */
+static bool format_cache_unref(struct info_t *info_p)
+{
+    info_p->refcount--;
+
+    return (info_p->refcount == 0);
+}
+
+/* Must be called with the cache locked. Returns the evicted format
+   and info, if any, to be released by the caller once the cache is
+   unlocked. */
+static void format_cache_evict(struct format_cache_entry_t *entry_p,
+                               PyObject **format_pp,
+                               struct info_t **info_pp)
+{
+    *format_pp = entry_p->format_p;
+    *info_pp = NULL;
+
+    if (entry_p->format_p != NULL) {
+        if (format_cache_unref(entry_p->info_p)) {
+            *info_pp = entry_p->info_p;
+        }
+    }
+
+    entry_p->format_p = NULL;
+    entry_p->info_p = NULL;
+}
+
+static struct info_t *format_cache_lookup(PyObject *format_p, Py_hash_t hash)
+{
+    struct format_cache_entry_t *entry_p;
+    int i;
+
+    for (i = 0; i < FORMAT_CACHE_SIZE; i++) {
+        entry_p = &format_cache.entries[i];
+
+        if (entry_p->format_p == NULL) {
+            continue;
+        }
+
+        if ((entry_p->format_p == format_p)
+            || ((entry_p->hash == hash)
+                && (PyUnicode_Compare(entry_p->format_p, format_p) == 0))) {
+            format_cache.tick++;
+            entry_p->last_used = format_cache.tick;
+            entry_p->info_p->refcount++;
+
+            return (entry_p->info_p);
+        }
+    }
+
+    return (NULL);
+}
+
+/* Returns the parsed format, from the cache if possible. Release it
+   with format_cache_release() when done. */
+static struct info_t *format_cache_get(PyObject *format_p)
+{
+    struct format_cache_entry_t *entry_p;
+    struct info_t *info_p;
+    struct info_t *cached_info_p;
+    struct info_t *evicted_info_p;
+    PyObject *evicted_format_p;
+    Py_hash_t hash;
+    int i;
+
+    if (!PyUnicode_CheckExact(format_p)) {
+        return (parse_format(format_p));
+    }
+
+    hash = PyObject_Hash(format_p);
+
+    if (hash == -1) {
+        return (NULL);
+    }
+
+    FORMAT_CACHE_LOCK();
+    info_p = format_cache_lookup(format_p, hash);
+
+    if (info_p != NULL) {
+        format_cache.hits++;
+    } else {
+        format_cache.misses++;
+    }
+
+    FORMAT_CACHE_UNLOCK();
+
+    if (info_p != NULL) {
+        return (info_p);
+    }
+
+    info_p = parse_format(format_p);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    Py_INCREF(format_p);
+    PyUnicode_InternInPlace(&format_p);
+    evicted_format_p = NULL;
+    evicted_info_p = NULL;
+
+    FORMAT_CACHE_LOCK();
+
+    /* Another thread may have added the format meanwhile. */
+    cached_info_p = format_cache_lookup(format_p, hash);
+
+    if (cached_info_p != NULL) {
+        evicted_format_p = format_p;
+        evicted_info_p = info_p;
+        info_p = cached_info_p;
+    } else {
+        entry_p = &format_cache.entries[0];
+
+        for (i = 0; i < FORMAT_CACHE_SIZE; i++) {
+            if (format_cache.entries[i].format_p == NULL) {
+                entry_p = &format_cache.entries[i];
+                break;
+            }
+
+            if (format_cache.entries[i].last_used < entry_p->last_used) {
+                entry_p = &format_cache.entries[i];
+            }
+        }
+
+        format_cache_evict(entry_p, &evicted_format_p, &evicted_info_p);
+        format_cache.tick++;
+        entry_p->format_p = format_p;
+        entry_p->hash = hash;
+        entry_p->info_p = info_p;
+        entry_p->last_used = format_cache.tick;
+        info_p->refcount++;
+    }
+
+    FORMAT_CACHE_UNLOCK();
+
+    Py_XDECREF(evicted_format_p);
+
+    if (evicted_info_p != NULL) {
+        PyMem_RawFree(evicted_info_p);
+    }
+
+    return (info_p);
+}
+
+static void format_cache_release(struct info_t *info_p)
+{
+    bool free_info;
+
+    FORMAT_CACHE_LOCK();
+    free_info = format_cache_unref(info_p);
+    FORMAT_CACHE_UNLOCK();
+
+    if (free_info) {
+        PyMem_RawFree(info_p);
+    }
+}
+
+static void format_cache_clear(void)
+{
+    struct info_t *evicted_infos[FORMAT_CACHE_SIZE];
+    PyObject *evicted_formats[FORMAT_CACHE_SIZE];
+    int i;
+
+    FORMAT_CACHE_LOCK();
+
+    for (i = 0; i < FORMAT_CACHE_SIZE; i++) {
+        format_cache_evict(&format_cache.entries[i],
+                           &evicted_formats[i],
+                           &evicted_infos[i]);
+    }
+
+    format_cache.hits = 0;
+    format_cache.misses = 0;
+
+    FORMAT_CACHE_UNLOCK();
+
+    for (i = 0; i < FORMAT_CACHE_SIZE; i++) {
+        Py_XDECREF(evicted_formats[i]);
+
+        if (evicted_infos[i] != NULL) {
+            PyMem_RawFree(evicted_infos[i]);
+        }
+    }
+}
+
+static PyObject *format_cache_info(void)
+{
+    Py_ssize_t hits;
+    Py_ssize_t misses;
+    int size;
+    int i;
+
+    size = 0;
+
+    FORMAT_CACHE_LOCK();
+
+    for (i = 0; i < FORMAT_CACHE_SIZE; i++) {
+        if (format_cache.entries[i].format_p != NULL) {
+            size++;
+        }
+    }
+
+    hits = format_cache.hits;
+    misses = format_cache.misses;
+
+    FORMAT_CACHE_UNLOCK();
+
+    return (Py_BuildValue("(nnii)", hits, misses, FORMAT_CACHE_SIZE, size));
+}
+
+/* Skip given padding field if not filling padding. Returns true if
+   skipped. Each run of other fields is written between the untouched
+   padding bits by saving and restoring the bits around it, instead of
+   around the whole format. */
+static bool pack_skip_padding(struct info_t *info_p,
+                              int index,
+                              struct bitstream_writer_t *writer_p,
+                              struct bitstream_writer_bounds_t *bounds_p,
+                              bool *in_run_p)
+{
+    struct field_info_t *field_p;
+    int number_of_bits;
+    int i;
+
+    field_p = &info_p->fields[index];
+
+    if (field_p->is_padding) {
+        if (*in_run_p) {
+            bitstream_writer_bounds_restore(bounds_p);
+            *in_run_p = false;
+        }
+
+        bitstream_writer_seek(writer_p, field_p->number_of_bits);
+
+        return (true);
+    }
+
+    if (!*in_run_p) {
+        number_of_bits = 0;
+
+        for (i = index; i < info_p->number_of_fields; i++) {
+            if (info_p->fields[i].is_padding) {
+                break;
+            }
+
+            number_of_bits += info_p->fields[i].number_of_bits;
+        }
+
+        bitstream_writer_bounds_save(bounds_p,
+                                     writer_p,
+                                     ((8 * writer_p->byte_offset)
+                                      + writer_p->bit_offset),
+                                     number_of_bits);
+        *in_run_p = true;
+    }
+
+    return (false);
+}
+
+static void pack_pack(struct info_t *info_p,
+                      PyObject *const *args_pp,
+                      struct bitstream_writer_t *writer_p,
+                      bool fill_padding)
+{
+    PyObject *value_p;
+    int i;
+    int consumed_args;
+    struct field_info_t *field_p;
+    struct bitstream_writer_bounds_t bounds;
+    bool in_run;
+
+    consumed_args = 0;
+    in_run = false;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        field_p = &info_p->fields[i];
+
+        if (!fill_padding
+            && pack_skip_padding(info_p, i, writer_p, &bounds, &in_run)) {
+            continue;
+        }
+
+        if (field_p->is_padding) {
+            value_p = NULL;
+        } else {
+            value_p = args_pp[consumed_args];
+            consumed_args++;
+        }
+
+        info_p->fields[i].pack(writer_p, value_p, field_p);
+    }
+
+    if (in_run) {
+        bitstream_writer_bounds_restore(&bounds);
+    }
+}
+
+/* Returns the packed size in bits of given values, read from given
+   arguments, or from given dictionary if names are given, or -1 on
+   failure. */
+static long long pack_size(struct info_t *info_p,
+                           PyObject *const *args_pp,
+                           PyObject *names_p,
+                           PyObject *data_p)
+{
+    PyObject *value_p;
+    struct field_info_t *field_p;
+    long long number_of_bits;
+    long long size;
+    int consumed_args;
+    int i;
+
+    number_of_bits = info_p->number_of_bits;
+
+    if (info_p->number_of_variable_length_fields == 0) {
+        return (number_of_bits);
+    }
+
+    consumed_args = 0;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        field_p = &info_p->fields[i];
+
+        if (field_p->is_padding) {
+            continue;
+        }
+
+        consumed_args++;
+
+        if (field_p->size == NULL) {
+            continue;
+        }
+
+        if (names_p == NULL) {
+            value_p = args_pp[consumed_args - 1];
+        } else {
+            value_p = PyDict_GetItem(data_p,
+                                     PyList_GET_ITEM(names_p,
+                                                     consumed_args - 1));
+
+            if (value_p == NULL) {
+                PyErr_SetString(PyExc_KeyError, "Missing value.");
+
+                return (-1);
+            }
+        }
+
+        size = field_p->size(value_p, field_p);
+
+        if (size == -1) {
+            return (-1);
+        }
+
+        number_of_bits += (size - field_p->number_of_bits);
+    }
+
+    return (number_of_bits);
+}
+
+static PyObject *pack_prepare(long long number_of_bits,
+                              struct bitstream_writer_t *writer_p)
+{
+    PyObject *packed_p;
+
+    packed_p = PyBytes_FromStringAndSize(NULL, (number_of_bits + 7) / 8);
+
+    if (packed_p == NULL) {
+        return (NULL);
+    }
+
+    bitstream_writer_init_window(writer_p,
+                                 (uint8_t *)PyBytes_AS_STRING(packed_p),
+                                 PyBytes_GET_SIZE(packed_p));
+
+    return (packed_p);
+}
+
+static PyObject *pack_finalize(PyObject *packed_p)
+{
+    if (PyErr_Occurred() != NULL) {
+        Py_DECREF(packed_p);
+        packed_p = NULL;
+    }
+
+    return (packed_p);
+}
+
+static PyObject *pack(struct info_t *info_p,
+                      PyObject *const *args_pp,
+                      Py_ssize_t number_of_args)
+{
+    struct bitstream_writer_t writer;
+    PyObject *packed_p;
+    long long number_of_bits;
+
+    if (number_of_args < info_p->number_of_non_padding_fields) {
+        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+
+        return (NULL);
+    }
+
+    number_of_bits = pack_size(info_p, args_pp, NULL, NULL);
+
+    if (number_of_bits == -1) {
+        return (NULL);
+    }
+
+    packed_p = pack_prepare(number_of_bits, &writer);
+
+    if (packed_p == NULL) {
+        return (NULL);
+    }
+
+    pack_pack(info_p, args_pp, &writer, true);
+
+    return (pack_finalize(packed_p));
+}
+
+static PyObject *m_pack(PyObject *module_p,
+                        PyObject *const *args_pp,
+                        Py_ssize_t number_of_args)
+{
+    PyObject *packed_p;
+    struct info_t *info_p;
+
+    if (number_of_args < 1) {
+        PyErr_SetString(PyExc_ValueError, "No format string.");
+
+        return (NULL);
+    }
+
+    info_p = format_cache_get(args_pp[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    packed_p = pack(info_p, &args_pp[1], number_of_args - 1);
+    format_cache_release(info_p);
+
+    return (packed_p);
+}
+
+/* Unpack given field of a format with variable length fields, which
+   sizes are not known before reading them. Returns 0 on success, 1 if
+   the data is short and truncation is allowed, and -1 on failure. */
+static int unpack_field_checked(struct bitstream_reader_t *reader_p,
+                                struct field_info_t *field_p,
+                                int allow_truncated,
+                                struct raw_memoryview_t *raw_p,
+                                PyObject **value_pp)
+{
+    if (bitstream_reader_check(reader_p, field_p->number_of_bits) == 0) {
+        *value_pp = unpack_field(reader_p, field_p, raw_p);
+
+        if (PyErr_Occurred() != NULL) {
+            return (-1);
+        }
+
+        if ((*value_pp != NULL) || (field_p->size == NULL)) {
+            return (0);
+        }
+    }
+
+    if (allow_truncated) {
+        return (1);
+    }
+
+    PyErr_SetString(PyExc_ValueError, "Short data.");
+
+    return (-1);
+}
+
+static PyObject *unpack_variable_length(struct info_t *info_p,
+                                        struct bitstream_reader_t *reader_p,
+                                        int allow_truncated,
+                                        struct raw_memoryview_t *raw_p)
+{
+    PyObject *unpacked_p;
+    PyObject *truncated_p;
+    PyObject *value_p;
+    int produced_args;
+    int res;
+    int i;
+
+    unpacked_p = PyTuple_New(info_p->number_of_non_padding_fields);
+
+    if (unpacked_p == NULL) {
+        return (NULL);
+    }
+
+    produced_args = 0;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        res = unpack_field_checked(reader_p,
+                                   &info_p->fields[i],
+                                   allow_truncated,
+                                   raw_p,
+                                   &value_p);
+
+        if (res == 1) {
+            break;
+        }
+
+        if (res == -1) {
+            Py_DECREF(unpacked_p);
+
+            return (NULL);
+        }
+
+        if (value_p != NULL) {
+            PyTuple_SET_ITEM(unpacked_p, produced_args, value_p);
+            produced_args++;
+        }
+    }
+
+    if (produced_args == info_p->number_of_non_padding_fields) {
+        return (unpacked_p);
+    }
+
+    truncated_p = PyTuple_GetSlice(unpacked_p, 0, produced_args);
+    Py_DECREF(unpacked_p);
+
+    return (truncated_p);
+}
+
+static PyObject *unpack(struct info_t *info_p,
+                        PyObject *data_p,
+                        long long offset,
+                        PyObject *allow_truncated_p)
+{
+    struct bitstream_reader_t reader;
+    struct raw_memoryview_t raw;
+    struct raw_memoryview_t *raw_p;
+    PyObject *unpacked_p = NULL;
+    PyObject *value_p;
+    Py_buffer view = {NULL, NULL};
+    int i;
+    long long remaining;
+    int produced_args;
+    int res;
+    int allow_truncated;
+    int num_result_fields;
+
+    res = PyObject_GetBuffer(data_p, &view, PyBUF_C_CONTIGUOUS);
+    if (res == -1) {
+        return (NULL);
+    }
+
+    raw_p = raw_memoryview_init(&raw, info_p, data_p, &view);
+    bitstream_reader_init_window(&reader,
+                                 (uint8_t *)view.buf,
+                                 view.len);
+    allow_truncated = PyObject_IsTrue(allow_truncated_p);
+
+    if (bitstream_reader_seek_checked(&reader, offset) != 0) {
+        if (!allow_truncated) {
+            PyErr_SetString(PyExc_ValueError, "Short data.");
+            goto exit;
+        }
+
+        remaining = -1;
+    } else {
+        remaining = bitstream_reader_remaining_bits(&reader);
+    }
+
+    if ((info_p->number_of_variable_length_fields > 0) && (remaining != -1)) {
+        unpacked_p = unpack_variable_length(info_p,
+                                            &reader,
+                                            allow_truncated,
+                                            raw_p);
+        goto exit;
+    }
+
+    if (allow_truncated) {
+        num_result_fields = 0;
+
+        for (i = 0; i < info_p->number_of_fields; i++) {
+            if (remaining < info_p->fields[i].number_of_bits) {
+                break;
+            }
+
+            remaining -= info_p->fields[i].number_of_bits;
+
+            if (!info_p->fields[i].is_padding) {
+                ++num_result_fields;
+            }
+        }
+    }
+    else {
+        num_result_fields = info_p->number_of_non_padding_fields;
+
+        if (bitstream_reader_check(&reader, info_p->number_of_bits) != 0) {
+            PyErr_SetString(PyExc_ValueError, "Short data.");
+            goto exit;
+        }
+    }
+
+    unpacked_p = PyTuple_New(num_result_fields);
+
+    if (unpacked_p == NULL) {
+        goto exit;
+    }
+
+    produced_args = 0;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        if (produced_args == num_result_fields) {
+            break;
+        }
+
+        value_p = unpack_field(&reader, &info_p->fields[i], raw_p);
+
+        if (value_p != NULL) {
+            PyTuple_SET_ITEM(unpacked_p, produced_args, value_p);
+            produced_args++;
+        } else if (PyErr_Occurred() != NULL) {
+            goto out1;
+        }
+    }
+
+    goto exit;
+
+ out1:
+    Py_DECREF(unpacked_p);
+    unpacked_p = NULL;
+
+exit:
+    raw_memoryview_destroy(raw_p);
+    PyBuffer_Release(&view);
+    return (unpacked_p);
+}
+
+static PyObject *m_unpack(PyObject *module_p,
+                          PyObject *const *args_pp,
+                          Py_ssize_t number_of_args,
+                          PyObject *kwnames_p)
+{
+    PyObject *unpacked_p;
+    struct info_t *info_p;
+    int res;
+    static const char *const keywords[] = {
+        "fmt",
+        "data",
+        "allow_truncated",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        py_zero_p
+    };
+
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    info_p = format_cache_get(values[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    unpacked_p = unpack(info_p, values[1], 0, values[2]);
+    format_cache_release(info_p);
+
+    return (unpacked_p);
+}
+
+static long long parse_offset(PyObject *offset_p)
+{
+    unsigned long long offset;
+
+    offset = PyLong_AsUnsignedLongLong(offset_p);
+
+    if (offset == (unsigned long long)-1) {
+        return (-1);
+    }
+
+    if (offset > OFFSET_MAX) {
+        PyErr_Format(PyExc_ValueError,
+                     "Offset must be less or equal to %lld bits.",
+                     OFFSET_MAX);
+
+        return (-1);
+    }
+
+    return ((long long)offset);
+}
+
+static int pack_into_prepare(struct info_t *info_p,
+                             long long number_of_bits,
+                             PyObject *buf_p,
+                             PyObject *offset_p,
+                             bool fill_padding,
+                             struct bitstream_writer_t *writer_p,
+                             struct bitstream_writer_bounds_t *bounds_p)
+{
+    uint8_t *packed_p;
+    Py_ssize_t size;
+    long long offset;
+
+    if (!fill_padding && (info_p->number_of_variable_length_fields > 0)) {
+        PyErr_SetString(PyExc_NotImplementedError,
+                        "fill_padding=False with variable length fields.");
+
+        return (-1);
+    }
+
+    offset = parse_offset(offset_p);
+
+    if (offset == -1) {
+        return (-1);
+    }
+
+    if (!PyByteArray_Check(buf_p)) {
+        PyErr_SetString(PyExc_TypeError, "Bytearray needed.");
+
+        return (-1);
+    }
+
+    packed_p = (uint8_t *)PyByteArray_AsString(buf_p);
+
+    if (packed_p == NULL) {
+        return (-1);
+    }
+
+    size = PyByteArray_GET_SIZE(buf_p);
+    bitstream_writer_init_window(writer_p, packed_p, size);
+
+    if (bitstream_writer_check(writer_p, number_of_bits + offset) != 0) {
+        PyErr_Format(PyExc_ValueError,
+                     "pack_into requires a buffer of at least %lld bits",
+                     number_of_bits + offset);
+
+        return (-1);
+    }
+
+    if (fill_padding) {
+        bitstream_writer_bounds_save(bounds_p,
+                                     writer_p,
+                                     offset,
+                                     number_of_bits);
+    }
+
+    bitstream_writer_seek(writer_p, offset);
+
+    return (0);
+}
+
+static PyObject *pack_into_finalize(struct bitstream_writer_bounds_t *bounds_p,
+                                    bool fill_padding)
+{
+    if (fill_padding) {
+        bitstream_writer_bounds_restore(bounds_p);
+    }
+
+    if (PyErr_Occurred() != NULL) {
+        return (NULL);
+    }
+
+    Py_RETURN_NONE;
+}
+
+/* Parse the fill_padding keyword argument of given variable number
+   of arguments call. Other keyword arguments are ignored, as in the
+   pure Python implementation. Returns 1 or 0 on success and -1 on
+   failure. */
+static int parse_fill_padding(PyObject *const *args_pp,
+                              Py_ssize_t number_of_args,
+                              PyObject *kwnames_p)
+{
+    Py_ssize_t i;
+
+    if (kwnames_p == NULL) {
+        return (1);
+    }
+
+    for (i = 0; i < PyTuple_GET_SIZE(kwnames_p); i++) {
+        if (PyUnicode_CompareWithASCIIString(PyTuple_GET_ITEM(kwnames_p, i),
+                                             "fill_padding") == 0) {
+            return (PyObject_IsTrue(args_pp[number_of_args + i]));
+        }
+    }
+
+    return (1);
+}
+
+static PyObject *pack_into(struct info_t *info_p,
+                           PyObject *buf_p,
+                           PyObject *offset_p,
+                           PyObject *const *args_pp,
+                           Py_ssize_t number_of_args,
+                           PyObject *kwnames_p)
+{
+    struct bitstream_writer_t writer;
+    struct bitstream_writer_bounds_t bounds;
+    int fill_padding;
+    int res;
+    long long number_of_bits;
+
+    if (number_of_args < info_p->number_of_non_padding_fields) {
+        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+
+        return (NULL);
+    }
+
+    fill_padding = parse_fill_padding(args_pp, number_of_args, kwnames_p);
+
+    if (fill_padding == -1) {
+        return (NULL);
+    }
+
+    number_of_bits = pack_size(info_p, args_pp, NULL, NULL);
+
+    if (number_of_bits == -1) {
+        return (NULL);
+    }
+
+    res = pack_into_prepare(info_p,
+                            number_of_bits,
+                            buf_p,
+                            offset_p,
+                            fill_padding,
+                            &writer,
+                            &bounds);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    pack_pack(info_p, args_pp, &writer, fill_padding);
+
+    return (pack_into_finalize(&bounds, fill_padding));
+}
+
+static PyObject *m_pack_into(PyObject *module_p,
+                             PyObject *const *args_pp,
+                             Py_ssize_t number_of_args,
+                             PyObject *kwnames_p)
+{
+    PyObject *res_p;
+    struct info_t *info_p;
+
+    if (number_of_args < 3) {
+        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+
+        return (NULL);
+    }
+
+    info_p = format_cache_get(args_pp[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    res_p = pack_into(info_p,
+                      args_pp[1],
+                      args_pp[2],
+                      &args_pp[3],
+                      number_of_args - 3,
+                      kwnames_p);
+    format_cache_release(info_p);
+
+    return (res_p);
+}
+
+static PyObject *unpack_from(struct info_t *info_p,
+                             PyObject *data_p,
+                             PyObject *offset_p,
+                             PyObject *allow_truncated_p)
+{
+    long long offset;
+
+    offset = parse_offset(offset_p);
+
+    if (offset == -1) {
+        return (NULL);
+    }
+
+    return (unpack(info_p, data_p, offset, allow_truncated_p));
+}
+
+static PyObject *m_unpack_from(PyObject *module_p,
+                               PyObject *const *args_pp,
+                               Py_ssize_t number_of_args,
+                               PyObject *kwnames_p)
+{
+    PyObject *unpacked_p;
+    struct info_t *info_p;
+    int res;
+    static const char *const keywords[] = {
+        "fmt",
+        "data",
+        "offset",
+        "allow_truncated",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        py_zero_p,
+        py_zero_p
+    };
+
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    info_p = format_cache_get(values[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    unpacked_p = unpack_from(info_p, values[1], values[2], values[3]);
+    format_cache_release(info_p);
+
+    return (unpacked_p);
+}
+
+static void pack_dict_pack(struct info_t *info_p,
+                           PyObject *names_p,
+                           PyObject *data_p,
+                           struct bitstream_writer_t *writer_p,
+                           bool fill_padding)
+{
+    PyObject *value_p;
+    int i;
+    int consumed_args;
+    struct field_info_t *field_p;
+    struct bitstream_writer_bounds_t bounds;
+    bool in_run;
+
+    consumed_args = 0;
+    in_run = false;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        field_p = &info_p->fields[i];
+
+        if (!fill_padding
+            && pack_skip_padding(info_p, i, writer_p, &bounds, &in_run)) {
+            continue;
+        }
+
+        if (field_p->is_padding) {
+            value_p = NULL;
+        } else {
+            value_p = PyDict_GetItem(data_p,
+                                     PyList_GET_ITEM(names_p, consumed_args));
+            consumed_args++;
+
+            if (value_p == NULL) {
+                PyErr_SetString(PyExc_KeyError, "Missing value.");
+                break;
+            }
+        }
+
+        info_p->fields[i].pack(writer_p, value_p, field_p);
+    }
+
+    if (in_run) {
+        bitstream_writer_bounds_restore(&bounds);
+    }
+}
+
+static PyObject *pack_dict(struct info_t *info_p,
+                           PyObject *names_p,
+                           PyObject *data_p)
+{
+    struct bitstream_writer_t writer;
+    PyObject *packed_p;
+    long long number_of_bits;
+
+    if (PyList_GET_SIZE(names_p) < info_p->number_of_non_padding_fields) {
+        PyErr_SetString(PyExc_ValueError, "Too few names.");
+
+        return (NULL);
+    }
+
+    number_of_bits = pack_size(info_p, NULL, names_p, data_p);
+
+    if (number_of_bits == -1) {
+        return (NULL);
+    }
+
+    packed_p = pack_prepare(number_of_bits, &writer);
+
+    if (packed_p == NULL) {
+        return (NULL);
+    }
+
+    pack_dict_pack(info_p, names_p, data_p, &writer, true);
+
+    return (pack_finalize(packed_p));
+}
+
+PyDoc_STRVAR(pack_dict___doc__,
+             "pack_dict(fmt, names, data)\n"
+             "--\n"
+             "\n");
+
+static PyObject *m_pack_dict(PyObject *module_p,
+                             PyObject *const *args_pp,
+                             Py_ssize_t number_of_args,
+                             PyObject *kwnames_p)
+{
+    PyObject *packed_p;
+    struct info_t *info_p;
+    int res;
+    static const char *const keywords[] = {
+        "fmt",
+        "names",
+        "data",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL
+    };
+
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    if (!is_names_list(values[1])) {
+        return (NULL);
+    }
+
+    info_p = format_cache_get(values[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    packed_p = pack_dict(info_p, values[1], values[2]);
+    format_cache_release(info_p);
+
+    return (packed_p);
+}
+
+static PyObject *unpack_dict(struct info_t *info_p,
+                             PyObject *names_p,
+                             PyObject *data_p,
+                             long long offset,
+                             PyObject *allow_truncated_p)
+{
+    struct bitstream_reader_t reader;
+    struct raw_memoryview_t raw;
+    struct raw_memoryview_t *raw_p;
+    PyObject *unpacked_p;
+    PyObject *value_p;
+    Py_buffer view = {NULL, NULL};
+    int i;
+    int res;
+    int produced_args;
+    int allow_truncated;
+    bool is_variable_length;
+
+    if (PyList_GET_SIZE(names_p) < info_p->number_of_non_padding_fields) {
+        PyErr_SetString(PyExc_ValueError, "Too few names.");
+
+        return (NULL);
+    }
+
+    unpacked_p = PyDict_New();
+
+    if (unpacked_p == NULL) {
+        return (NULL);
+    }
+
+    raw_p = NULL;
+    res = PyObject_GetBuffer(data_p, &view, PyBUF_C_CONTIGUOUS);
+
+    if (res == -1) {
+        goto out1;
+    }
+
+    raw_p = raw_memoryview_init(&raw, info_p, data_p, &view);
+    allow_truncated = PyObject_IsTrue(allow_truncated_p);
+    bitstream_reader_init_window(&reader,
+                                 (uint8_t *)view.buf,
+                                 view.len);
+
+    if (bitstream_reader_seek_checked(&reader, offset) != 0) {
+        if (!allow_truncated) {
+            PyErr_SetString(PyExc_ValueError, "Short data.");
+        }
+
+        goto out1;
+    }
+
+    is_variable_length = (info_p->number_of_variable_length_fields > 0);
+
+    if (!allow_truncated
+        && !is_variable_length
+        && (bitstream_reader_check(&reader, info_p->number_of_bits) != 0)) {
+        PyErr_SetString(PyExc_ValueError, "Short data.");
+
+        goto out1;
+    }
+
+    produced_args = 0;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        if (is_variable_length) {
+            res = unpack_field_checked(&reader,
+                                       &info_p->fields[i],
+                                       allow_truncated,
+                                       raw_p,
+                                       &value_p);
+
+            if (res == 1) {
+                break;
+            }
+
+            if (res == -1) {
+                goto out1;
+            }
+        } else {
+            if (allow_truncated
+                && (bitstream_reader_check(&reader,
+                                           info_p->fields[i].number_of_bits) != 0)) {
+                break;
+            }
+
+            value_p = unpack_field(&reader, &info_p->fields[i], raw_p);
+        }
+
+        if (value_p != NULL) {
+            PyDict_SetItem(unpacked_p,
+                           PyList_GET_ITEM(names_p, produced_args),
+                           value_p);
+            Py_DECREF(value_p);
+            produced_args++;
+        }
+    }
+
+ out1:
+    if (PyErr_Occurred() != NULL) {
+        Py_DECREF(unpacked_p);
+        unpacked_p = NULL;
+    }
+
+    raw_memoryview_destroy(raw_p);
+
+    if (view.obj != NULL) {
+        PyBuffer_Release(&view);
+    }
+
+    return (unpacked_p);
+}
+
+PyDoc_STRVAR(unpack_dict___doc__,
+             "unpack_dict(fmt, names, data, allow_truncated=False)\n"
+             "--\n"
+             "\n");
+
+static PyObject *m_unpack_dict(PyObject *module_p,
+                               PyObject *const *args_pp,
+                               Py_ssize_t number_of_args,
+                               PyObject *kwnames_p)
+{
+    PyObject *unpacked_p;
+    struct info_t *info_p;
+    int res;
+    static const char *const keywords[] = {
+        "fmt",
+        "names",
+        "data",
+        "allow_truncated",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL,
+        py_zero_p
+    };
+
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    if (!is_names_list(values[1])) {
+        return (NULL);
+    }
+
+    info_p = format_cache_get(values[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    unpacked_p = unpack_dict(info_p, values[1], values[2], 0, values[3]);
+    format_cache_release(info_p);
+
+    return (unpacked_p);
+}
+
+static PyObject *unpack_from_dict(struct info_t *info_p,
+                                  PyObject *names_p,
+                                  PyObject *data_p,
+                                  PyObject *offset_p,
+                                  PyObject *allow_truncated_p)
+{
+    long long offset;
+
+    offset = parse_offset(offset_p);
+
+    if (offset == -1) {
+        return (NULL);
+    }
+
+    return (unpack_dict(info_p, names_p, data_p, offset, allow_truncated_p));
+}
+
+static PyObject *pack_into_dict(struct info_t *info_p,
+                                PyObject *names_p,
+                                PyObject *buf_p,
+                                PyObject *offset_p,
+                                PyObject *data_p,
+                                PyObject *fill_padding_p)
+{
+    struct bitstream_writer_t writer;
+    struct bitstream_writer_bounds_t bounds;
+    int fill_padding;
+    int res;
+    long long number_of_bits;
+
+    fill_padding = PyObject_IsTrue(fill_padding_p);
+
+    if (fill_padding == -1) {
+        return (NULL);
+    }
+
+    number_of_bits = pack_size(info_p, NULL, names_p, data_p);
+
+    if (number_of_bits == -1) {
+        return (NULL);
+    }
+
+    res = pack_into_prepare(info_p,
+                            number_of_bits,
+                            buf_p,
+                            offset_p,
+                            fill_padding,
+                            &writer,
+                            &bounds);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    pack_dict_pack(info_p, names_p, data_p, &writer, fill_padding);
+
+    return (pack_into_finalize(&bounds, fill_padding));
+}
+
+PyDoc_STRVAR(pack_into_dict___doc__,
+             "pack_into_dict(fmt, names, buf, offset, data, fill_padding=True)\n"
+             "--\n"
+             "\n");
+
+static PyObject *m_pack_into_dict(PyObject *module_p,
+                                  PyObject *const *args_pp,
+                                  Py_ssize_t number_of_args,
+                                  PyObject *kwnames_p)
+{
+    PyObject *res_p;
+    struct info_t *info_p;
+    int res;
+    static const char *const keywords[] = {
+        "fmt",
+        "names",
+        "buf",
+        "offset",
+        "data",
+        "fill_padding",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        Py_True
+    };
+
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    if (!is_names_list(values[1])) {
+        return (NULL);
+    }
+
+    info_p = format_cache_get(values[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    res_p = pack_into_dict(info_p,
+                           values[1],
+                           values[2],
+                           values[3],
+                           values[4],
+                           values[5]);
+    format_cache_release(info_p);
+
+    return (res_p);
+}
+
+PyDoc_STRVAR(unpack_from_dict___doc__,
+             "unpack_from_dict(fmt, names, data, offset=0, allow_truncated=False)\n"
+             "--\n"
+             "\n");
+
+static PyObject *m_unpack_from_dict(PyObject *module_p,
+                                    PyObject *const *args_pp,
+                                    Py_ssize_t number_of_args,
+                                    PyObject *kwnames_p)
+{
+    PyObject *unpacked_p;
+    struct info_t *info_p;
+    int res;
+    static const char *const keywords[] = {
+        "fmt",
+        "names",
+        "data",
+        "offset",
+        "allow_truncated",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL,
+        py_zero_p,
+        py_zero_p
+    };
+
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    if (!is_names_list(values[1])) {
+        return (NULL);
+    }
+
+    info_p = format_cache_get(values[0]);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    unpacked_p = unpack_from_dict(info_p,
+                                  values[1],
+                                  values[2],
+                                  values[3],
+                                  values[4]);
+    format_cache_release(info_p);
+
+    return (unpacked_p);
+}
+
+/* Unpack one record into a tuple, or into a dict if names are
+   given. */
+static PyObject *unpack_record(struct info_t *info_p,
+                               PyObject *names_p,
+                               struct bitstream_reader_t *reader_p,
+                               struct raw_memoryview_t *raw_p)
+{
+    PyObject *record_p;
+    PyObject *value_p;
+    struct field_info_t *field_p;
+    int i;
+    int res;
+    int produced_args;
+
+    if (names_p == NULL) {
+        record_p = PyTuple_New(info_p->number_of_non_padding_fields);
+    } else {
+        record_p = PyDict_New();
+    }
+
+    if (record_p == NULL) {
+        return (NULL);
+    }
+
+    produced_args = 0;
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        field_p = &info_p->fields[i];
+        value_p = unpack_field(reader_p, field_p, raw_p);
+
+        if (field_p->is_padding) {
+            continue;
+        }
+
+        if (value_p == NULL) {
+            goto out1;
+        }
+
+        if (names_p == NULL) {
+            PyTuple_SET_ITEM(record_p, produced_args, value_p);
+        } else {
+            res = PyDict_SetItem(record_p,
+                                 PyList_GET_ITEM(names_p, produced_args),
+                                 value_p);
+            Py_DECREF(value_p);
+
+            if (res != 0) {
+                goto out1;
+            }
+        }
+
+        produced_args++;
+    }
+
+    return (record_p);
+
+ out1:
+    Py_DECREF(record_p);
+
+    return (NULL);
+}
+
+/* Returns the distance in bits between records, or -1 on failure. */
+static long long parse_stride(struct info_t *info_p, PyObject *stride_p)
+{
+    long long stride;
+
+    if (info_p->number_of_variable_length_fields > 0) {
+        PyErr_SetString(PyExc_ValueError, "Variable length format.");
+
+        return (-1);
+    }
+
+    if (stride_p == Py_None) {
+        return (info_p->number_of_bits);
+    }
+
+    stride = PyLong_AsLongLong(stride_p);
+
+    if ((stride == -1) && PyErr_Occurred()) {
+        return (-1);
+    }
+
+    if ((stride < 0) || (stride > (LLONG_MAX / 16))) {
+        PyErr_SetString(PyExc_ValueError, "Bad stride.");
+
+        return (-1);
+    }
+
+    if ((8 * stride) < info_p->number_of_bits) {
+        PyErr_SetString(PyExc_ValueError, "Stride too small.");
+
+        return (-1);
+    }
+
+    return (8 * stride);
+}
+
+/* Returns the number of records to unpack, or -1 on failure. */
+static Py_ssize_t parse_count(struct info_t *info_p,
+                              PyObject *count_p,
+                              long long available_bits,
+                              long long record_bits)
+{
+    Py_ssize_t count;
+
+    if (count_p == Py_None) {
+        if (record_bits == 0) {
+            PyErr_SetString(PyExc_ValueError, "Count needed for empty records.");
+
+            return (-1);
+        }
+
+        if (available_bits < info_p->number_of_bits) {
+            return (0);
+        }
+
+        return ((available_bits - info_p->number_of_bits) / record_bits + 1);
+    }
+
+    count = PyLong_AsSsize_t(count_p);
+
+    if ((count == -1) && PyErr_Occurred()) {
+        return (-1);
+    }
+
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "Negative count.");
+
+        return (-1);
+    }
+
+    if (count == 0) {
+        return (0);
+    }
+
+    if ((available_bits < info_p->number_of_bits)
+        || ((record_bits > 0)
+            && ((count - 1) > ((available_bits - info_p->number_of_bits)
+                               / record_bits)))) {
+        PyErr_SetString(PyExc_ValueError, "Short data.");
+
+        return (-1);
+    }
+
+    return (count);
+}
+
+static PyObject *unpack_many(struct info_t *info_p,
+                             PyObject *names_p,
+                             PyObject *data_p,
+                             PyObject *count_p,
+                             PyObject *stride_p,
+                             PyObject *offset_p)
+{
+    struct bitstream_reader_t reader;
+    struct raw_memoryview_t raw;
+    struct raw_memoryview_t *raw_p;
+    Py_buffer view = {NULL, NULL};
+    PyObject *unpacked_p;
+    PyObject *record_p;
+    Py_ssize_t count;
+    Py_ssize_t i;
+    long long offset;
+    long long record_bits;
+    long long position;
+    int res;
+
+    if ((names_p != NULL)
+        && (PyList_GET_SIZE(names_p) < info_p->number_of_non_padding_fields)) {
+        PyErr_SetString(PyExc_ValueError, "Too few names.");
+
+        return (NULL);
+    }
+
+    offset = parse_offset(offset_p);
+
+    if (offset == -1) {
+        return (NULL);
+    }
+
+    record_bits = parse_stride(info_p, stride_p);
+
+    if (record_bits == -1) {
+        return (NULL);
+    }
+
+    res = PyObject_GetBuffer(data_p, &view, PyBUF_C_CONTIGUOUS);
+
+    if (res == -1) {
+        return (NULL);
+    }
+
+    unpacked_p = NULL;
+    raw_p = raw_memoryview_init(&raw, info_p, data_p, &view);
+    count = parse_count(info_p,
+                        count_p,
+                        8LL * view.len - offset,
+                        record_bits);
+
+    if (count == -1) {
+        goto out1;
+    }
+
+    unpacked_p = PyList_New(count);
+
+    if (unpacked_p == NULL) {
+        goto out1;
+    }
+
+    position = offset;
+
+    for (i = 0; i < count; i++) {
+        bitstream_reader_init_window(&reader,
+                                     (uint8_t *)view.buf + position / 8,
+                                     view.len - position / 8);
+        bitstream_reader_seek(&reader, position % 8);
+        record_p = unpack_record(info_p, names_p, &reader, raw_p);
+
+        if (record_p == NULL) {
+            Py_DECREF(unpacked_p);
+            unpacked_p = NULL;
+            break;
+        }
+
+        PyList_SET_ITEM(unpacked_p, i, record_p);
+        position += record_bits;
+    }
+
+ out1:
+    raw_memoryview_destroy(raw_p);
+    PyBuffer_Release(&view);
+
+    return (unpacked_p);
+}
+
+/* Pack one record from a tuple or list, or from a dict if names are
+   given. */
+static void pack_record(struct info_t *info_p,
+                        PyObject *names_p,
+                        PyObject *record_p,
+                        struct bitstream_writer_t *writer_p,
+                        bool fill_padding)
+{
+    PyObject *values_p;
+
+    if (names_p != NULL) {
+        pack_dict_pack(info_p, names_p, record_p, writer_p, fill_padding);
+
+        return;
+    }
+
+    values_p = PySequence_Fast(record_p, "Record is not a sequence.");
+
+    if (values_p == NULL) {
+        return;
+    }
+
+    if (PySequence_Fast_GET_SIZE(values_p) < info_p->number_of_non_padding_fields) {
+        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+    } else {
+        pack_pack(info_p,
+                  PySequence_Fast_ITEMS(values_p),
+                  writer_p,
+                  fill_padding);
+    }
+
+    Py_DECREF(values_p);
+}
+
+static PyObject *pack_many_prepare(struct info_t *info_p,
+                                   PyObject *names_p,
+                                   PyObject *records_p)
+{
+    if ((names_p != NULL)
+        && (PyList_GET_SIZE(names_p) < info_p->number_of_non_padding_fields)) {
+        PyErr_SetString(PyExc_ValueError, "Too few names.");
+
+        return (NULL);
+    }
+
+    return (PySequence_Fast(records_p, "Records are not iterable."));
+}
+
+/* Returns the number of bits needed by given number of records. */
+static long long pack_many_size(struct info_t *info_p,
+                                Py_ssize_t count,
+                                long long record_bits)
+{
+    if (count == 0) {
+        return (0);
+    }
+
+    return ((count - 1) * record_bits + info_p->number_of_bits);
+}
+
+static PyObject *pack_many(struct info_t *info_p,
+                           PyObject *names_p,
+                           PyObject *records_p,
+                           PyObject *stride_p)
+{
+    struct bitstream_writer_t writer;
+    PyObject *packed_p;
+    uint8_t *buf_p;
+    Py_ssize_t count;
+    Py_ssize_t i;
+    long long record_bits;
+    long long position;
+    long long size;
+
+    record_bits = parse_stride(info_p, stride_p);
+
+    if (record_bits == -1) {
+        return (NULL);
+    }
+
+    records_p = pack_many_prepare(info_p, names_p, records_p);
+
+    if (records_p == NULL) {
+        return (NULL);
+    }
+
+    count = PySequence_Fast_GET_SIZE(records_p);
+    size = ((pack_many_size(info_p, count, record_bits) + 7) / 8);
+
+    if (size > PY_SSIZE_T_MAX) {
+        Py_DECREF(records_p);
+
+        return (PyErr_NoMemory());
+    }
+
+    packed_p = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)size);
+
+    if (packed_p == NULL) {
+        Py_DECREF(records_p);
+
+        return (NULL);
+    }
+
+    buf_p = (uint8_t *)PyBytes_AS_STRING(packed_p);
+
+    /* Bytes between strided records are never written. */
+    if (record_bits != info_p->number_of_bits) {
+        memset(buf_p, 0, size);
+    }
+
+    position = 0;
+
+    for (i = 0; i < count; i++) {
+        bitstream_writer_init_window(&writer,
+                                     buf_p + position / 8,
+                                     size - position / 8);
+        bitstream_writer_seek(&writer, position % 8);
+        pack_record(info_p,
+                    names_p,
+                    PySequence_Fast_GET_ITEM(records_p, i),
+                    &writer,
+                    true);
+
+        if (PyErr_Occurred() != NULL) {
+            break;
+        }
+
+        position += record_bits;
+    }
+
+    Py_DECREF(records_p);
+
+    return (pack_finalize(packed_p));
+}
+
+static PyObject *pack_many_into(struct info_t *info_p,
+                                PyObject *names_p,
+                                PyObject *buf_p,
+                                PyObject *offset_p,
+                                PyObject *records_p,
+                                PyObject *stride_p,
+                                int fill_padding)
+{
+    struct bitstream_writer_t writer;
+    struct bitstream_writer_bounds_t bounds;
+    uint8_t *packed_p;
+    Py_ssize_t count;
+    Py_ssize_t i;
+    long long offset;
+    long long record_bits;
+    long long position;
+
+    offset = parse_offset(offset_p);
+
+    if (offset == -1) {
+        return (NULL);
+    }
+
+    record_bits = parse_stride(info_p, stride_p);
+
+    if (record_bits == -1) {
+        return (NULL);
+    }
+
+    if (!PyByteArray_Check(buf_p)) {
+        PyErr_SetString(PyExc_TypeError, "Bytearray needed.");
+
+        return (NULL);
+    }
+
+    records_p = pack_many_prepare(info_p, names_p, records_p);
+
+    if (records_p == NULL) {
+        return (NULL);
+    }
+
+    count = PySequence_Fast_GET_SIZE(records_p);
+
+    if ((8LL * PyByteArray_GET_SIZE(buf_p))
+        < (pack_many_size(info_p, count, record_bits) + offset)) {
+        PyErr_Format(PyExc_ValueError,
+                     "pack_many_into requires a buffer of at least %lld bits",
+                     pack_many_size(info_p, count, record_bits) + offset);
+        Py_DECREF(records_p);
+
+        return (NULL);
+    }
+
+    packed_p = (uint8_t *)PyByteArray_AS_STRING(buf_p);
+    position = offset;
+
+    for (i = 0; i < count; i++) {
+        bitstream_writer_init_window(
+            &writer,
+            packed_p + position / 8,
+            PyByteArray_GET_SIZE(buf_p) - position / 8);
+
+        if (fill_padding) {
+            bitstream_writer_bounds_save(&bounds,
+                                         &writer,
+                                         position % 8,
+                                         info_p->number_of_bits);
+        }
+
+        bitstream_writer_seek(&writer, position % 8);
+        pack_record(info_p,
+                    names_p,
+                    PySequence_Fast_GET_ITEM(records_p, i),
+                    &writer,
+                    fill_padding);
+
+        if (fill_padding) {
+            bitstream_writer_bounds_restore(&bounds);
+        }
+
+        if (PyErr_Occurred() != NULL) {
+            break;
+        }
+
+        position += record_bits;
     }
 
-    return (0);
+    Py_DECREF(records_p);
+
+    if (PyErr_Occurred() != NULL) {
+        return (NULL);
+    }
+
+    Py_RETURN_NONE;
 }
 
-static int field_info_init_text(struct field_info_t *self_p,
-                                int number_of_bits)
+/* Create an array.array of given type and length filled with
+   zeros. */
+static PyObject *column_new(char type_code, Py_ssize_t length)
 {
-    self_p->pack = pack_text;
-    self_p->unpack = unpack_text;
+    PyObject *array_module_p;
+    PyObject *zero_p;
+    PyObject *column_p;
+
+    array_module_p = PyImport_ImportModule("array");
+
+    if (array_module_p == NULL) {
+        return (NULL);
+    }
+
+    zero_p = PyObject_CallMethod(array_module_p, "array", "C[i]", type_code, 0);
+    Py_DECREF(array_module_p);
+
+    if (zero_p == NULL) {
+        return (NULL);
+    }
+
+    column_p = PySequence_Repeat(zero_p, length);
+    Py_DECREF(zero_p);
+
+    return (column_p);
+}
+
+static PyObject *unpack_columns(struct info_t *info_p,
+                                PyObject *names_p,
+                                PyObject *data_p,
+                                PyObject *count_p,
+                                PyObject *stride_p,
+                                PyObject *offset_p)
+{
+    struct bitstream_reader_t reader;
+    Py_buffer view = {NULL, NULL};
+    Py_buffer *columns_p;
+    PyObject *unpacked_p;
+    PyObject *column_p;
+    struct field_info_t *field_p;
+    Py_ssize_t count;
+    Py_ssize_t i;
+    long long offset;
+    long long record_bits;
+    long long position;
+    int j;
+    int produced_args;
+    int res;
+
+    if ((names_p != NULL)
+        && (PyList_GET_SIZE(names_p) < info_p->number_of_non_padding_fields)) {
+        PyErr_SetString(PyExc_ValueError, "Too few names.");
+
+        return (NULL);
+    }
+
+    if (info_p->number_of_variable_length_fields > 0) {
+        PyErr_SetString(PyExc_ValueError, "Variable length format.");
+
+        return (NULL);
+    }
+
+    for (j = 0; j < info_p->number_of_fields; j++) {
+        if (info_p->fields[j].unpack_column == NULL) {
+            PyErr_SetString(PyExc_NotImplementedError,
+                            "Text and raw cannot be unpacked into columns.");
+
+            return (NULL);
+        }
+    }
+
+    offset = parse_offset(offset_p);
+
+    if (offset == -1) {
+        return (NULL);
+    }
+
+    record_bits = parse_stride(info_p, stride_p);
+
+    if (record_bits == -1) {
+        return (NULL);
+    }
+
+    columns_p = PyMem_Calloc(info_p->number_of_fields + 1, sizeof(*columns_p));
+
+    if (columns_p == NULL) {
+        return (PyErr_NoMemory());
+    }
+
+    unpacked_p = NULL;
+    res = PyObject_GetBuffer(data_p, &view, PyBUF_C_CONTIGUOUS);
+
+    if (res == -1) {
+        goto out1;
+    }
+
+    count = parse_count(info_p,
+                        count_p,
+                        8LL * view.len - offset,
+                        record_bits);
+
+    if (count == -1) {
+        goto out2;
+    }
+
+    if (names_p == NULL) {
+        unpacked_p = PyTuple_New(info_p->number_of_non_padding_fields);
+    } else {
+        unpacked_p = PyDict_New();
+    }
+
+    if (unpacked_p == NULL) {
+        goto out2;
+    }
+
+    produced_args = 0;
+
+    for (j = 0; j < info_p->number_of_fields; j++) {
+        field_p = &info_p->fields[j];
+
+        if (field_p->is_padding) {
+            continue;
+        }
+
+        column_p = column_new(field_p->column_type_code, count);
+
+        if (column_p == NULL) {
+            goto out3;
+        }
+
+        if (names_p == NULL) {
+            PyTuple_SET_ITEM(unpacked_p, produced_args, column_p);
+        } else {
+            res = PyDict_SetItem(unpacked_p,
+                                 PyList_GET_ITEM(names_p, produced_args),
+                                 column_p);
+            Py_DECREF(column_p);
+
+            if (res != 0) {
+                goto out3;
+            }
+        }
+
+        produced_args++;
+        res = PyObject_GetBuffer(column_p, &columns_p[j], PyBUF_WRITABLE);
+
+        if (res == -1) {
+            goto out3;
+        }
+    }
+
+    position = offset;
+
+    for (i = 0; i < count; i++) {
+        bitstream_reader_init_window(&reader,
+                                     (uint8_t *)view.buf + position / 8,
+                                     view.len - position / 8);
+        bitstream_reader_seek(&reader, position % 8);
+
+        for (j = 0; j < info_p->number_of_fields; j++) {
+            field_p = &info_p->fields[j];
+            field_p->unpack_column(&reader, field_p, columns_p[j].buf, i);
+        }
+
+        position += record_bits;
+    }
+
+    goto out2;
+
+ out3:
+    Py_DECREF(unpacked_p);
+    unpacked_p = NULL;
+
+ out2:
+    for (j = 0; j < info_p->number_of_fields; j++) {
+        if (columns_p[j].obj != NULL) {
+            PyBuffer_Release(&columns_p[j]);
+        }
+    }
+
+    PyBuffer_Release(&view);
+
+ out1:
+    PyMem_Free(columns_p);
+
+    return (unpacked_p);
+}
+
+/* Get a buffer of native integers or floats, one dimension only. */
+static int column_init(struct column_t *self_p, PyObject *column_p)
+{
+    const char *format_p;
+    int res;
+
+    res = PyObject_GetBuffer(column_p,
+                             &self_p->view,
+                             PyBUF_C_CONTIGUOUS | PyBUF_FORMAT);
+
+    if (res == -1) {
+        return (-1);
+    }
+
+    format_p = self_p->view.format;
+
+    if (format_p == NULL) {
+        format_p = "B";
+    } else if (format_p[0] == '@') {
+        format_p++;
+    }
+
+    self_p->kind = '\0';
+
+    if ((self_p->view.ndim <= 1) && (format_p[0] != '\0') && (format_p[1] == '\0')) {
+        switch (format_p[0]) {
+
+        case 'b':
+        case 'h':
+        case 'i':
+        case 'l':
+        case 'q':
+        case 'n':
+            self_p->kind = 'i';
+            break;
+
+        case 'B':
+        case 'H':
+        case 'I':
+        case 'L':
+        case 'Q':
+        case 'N':
+        case '?':
+            self_p->kind = 'u';
+            break;
+
+        case 'f':
+        case 'd':
+            self_p->kind = 'f';
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    switch (self_p->view.itemsize) {
+
+    case 1:
+    case 2:
+        if (self_p->kind == 'f') {
+            self_p->kind = '\0';
+        }
+
+        break;
+
+    case 4:
+    case 8:
+        break;
+
+    default:
+        self_p->kind = '\0';
+        break;
+    }
+
+    if (self_p->kind == '\0') {
+        PyErr_Format(PyExc_ValueError,
+                     "Unsupported column format '%s'.",
+                     format_p);
+        PyBuffer_Release(&self_p->view);
 
-    if ((number_of_bits % 8) != 0) {
-        PyErr_SetString(PyExc_NotImplementedError,
-                        "Text not multiple of 8 bits.");
         return (-1);
     }
 
-    return (0);
+    return (0);
+}
+
+static PyObject *pack_columns(struct info_t *info_p,
+                              PyObject *columns_p,
+                              PyObject *stride_p)
+{
+    struct bitstream_writer_t writer;
+    struct column_t *fields_columns_p;
+    struct column_t *column_p;
+    struct field_info_t *field_p;
+    PyObject *packed_p;
+    uint8_t *buf_p;
+    Py_ssize_t count;
+    Py_ssize_t length;
+    Py_ssize_t i;
+    long long record_bits;
+    long long position;
+    long long size;
+    int j;
+    int consumed_args;
+    int res;
+
+    if (PyTuple_GET_SIZE(columns_p) < info_p->number_of_non_padding_fields) {
+        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+
+        return (NULL);
+    }
+
+    if (info_p->number_of_variable_length_fields > 0) {
+        PyErr_SetString(PyExc_ValueError, "Variable length format.");
+
+        return (NULL);
+    }
+
+    for (j = 0; j < info_p->number_of_fields; j++) {
+        if (info_p->fields[j].pack_column == NULL) {
+            PyErr_SetString(PyExc_NotImplementedError,
+                            "Text and raw cannot be packed from columns.");
+
+            return (NULL);
+        }
+    }
+
+    record_bits = parse_stride(info_p, stride_p);
+
+    if (record_bits == -1) {
+        return (NULL);
+    }
+
+    fields_columns_p = PyMem_Calloc(info_p->number_of_fields + 1,
+                                    sizeof(*fields_columns_p));
+
+    if (fields_columns_p == NULL) {
+        return (PyErr_NoMemory());
+    }
+
+    packed_p = NULL;
+    count = 0;
+    consumed_args = 0;
+
+    for (j = 0; j < info_p->number_of_fields; j++) {
+        field_p = &info_p->fields[j];
+
+        if (field_p->is_padding) {
+            continue;
+        }
+
+        column_p = &fields_columns_p[j];
+        res = column_init(column_p, PyTuple_GET_ITEM(columns_p, consumed_args));
+
+        if (res == -1) {
+            goto out1;
+        }
+
+        if ((column_p->kind == 'f') && (field_p->column_type_code != 'd')) {
+            PyErr_SetString(PyExc_TypeError, "Integer column needed.");
+            goto out1;
+        }
+
+        length = (column_p->view.len / column_p->view.itemsize);
+
+        if (consumed_args == 0) {
+            count = length;
+        } else if (length != count) {
+            PyErr_SetString(PyExc_ValueError, "Columns of different lengths.");
+            goto out1;
+        }
+
+        consumed_args++;
+    }
+
+    size = ((pack_many_size(info_p, count, record_bits) + 7) / 8);
+
+    if (size > PY_SSIZE_T_MAX) {
+        PyErr_NoMemory();
+        goto out1;
+    }
+
+    packed_p = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)size);
+
+    if (packed_p == NULL) {
+        goto out1;
+    }
+
+    buf_p = (uint8_t *)PyBytes_AS_STRING(packed_p);
+
+    /* Bytes between strided records are never written. */
+    if (record_bits != info_p->number_of_bits) {
+        memset(buf_p, 0, size);
+    }
+
+    position = 0;
+
+    for (i = 0; i < count; i++) {
+        bitstream_writer_init_window(&writer,
+                                     buf_p + position / 8,
+                                     size - position / 8);
+        bitstream_writer_seek(&writer, position % 8);
+
+        for (j = 0; j < info_p->number_of_fields; j++) {
+            field_p = &info_p->fields[j];
+            res = field_p->pack_column(&writer,
+                                       field_p,
+                                       &fields_columns_p[j],
+                                       i);
+
+            if (res != 0) {
+                Py_DECREF(packed_p);
+                packed_p = NULL;
+                goto out1;
+            }
+        }
+
+        position += record_bits;
+    }
+
+ out1:
+    for (j = 0; j < info_p->number_of_fields; j++) {
+        if (fields_columns_p[j].view.obj != NULL) {
+            PyBuffer_Release(&fields_columns_p[j].view);
+        }
+    }
+
+    PyMem_Free(fields_columns_p);
+
+    return (packed_p);
+}
+
+static PyObject *calcsize(struct info_t *info_p)
+{
+    if (info_p->number_of_variable_length_fields > 0) {
+        PyErr_SetString(PyExc_ValueError, "Variable length format.");
+
+        return (NULL);
+    }
+
+    return (PyLong_FromLong(info_p->number_of_bits));
+}
+
+static PyObject *m_calcsize(PyObject *module_p, PyObject *format_p)
+{
+    PyObject *size_p;
+    struct info_t *info_p;
+
+    info_p = format_cache_get(format_p);
+
+    if (info_p == NULL) {
+        return (NULL);
+    }
+
+    size_p = calcsize(info_p);
+    format_cache_release(info_p);
+
+    return (size_p);
 }
 
-static int field_info_init_raw(struct field_info_t *self_p,
-                               int number_of_bits)
-{
-    self_p->pack = pack_raw;
-    self_p->unpack = unpack_raw;
+/* Runs of items of the same size in a byteswap format, so that for
+   example '2' * 1000 is swapped in one pass. */
+struct byteswap_run_t {
+    int item_size;
+    Py_ssize_t count;
+};
 
-    if ((number_of_bits % 8) != 0) {
-        PyErr_SetString(PyExc_NotImplementedError,
-                        "Raw not multiple of 8 bits.");
-        return (-1);
-    }
+#define BYTESWAP_BLOCK_SIZE 16384
 
-    return (0);
-}
+/* Up to BITSTREAM_BYTESWAP_RECORD_MAX_SIZE bytes of whole items in a
+   record, swapped in all records at once. */
+struct byteswap_chunk_t {
+    Py_ssize_t offset;
+    int size;
+    /* Source byte of each swapped byte. */
+    uint8_t mask[BITSTREAM_BYTESWAP_RECORD_MAX_SIZE];
+};
 
-static int field_info_init_zero_padding(struct field_info_t *self_p)
+struct byteswap_format_t {
+    /* Number of swapped bytes. */
+    Py_ssize_t size;
+    /* Only created by byteswap_format_compile_chunks(), or NULL. */
+    struct byteswap_chunk_t *chunks_p;
+    Py_ssize_t number_of_chunks;
+    Py_ssize_t number_of_runs;
+    struct byteswap_run_t runs[1];
+};
+
+/* Returns the index of the first character after the run starting at
+   given index. */
+static Py_ssize_t byteswap_format_run_end(const char *format_p,
+                                          Py_ssize_t length,
+                                          Py_ssize_t i)
 {
-    self_p->pack = pack_zero_padding;
-    self_p->unpack = unpack_padding;
+    char c;
 
-    return (0);
-}
+    c = format_p[i];
 
-static int field_info_init_one_padding(struct field_info_t *self_p)
-{
-    self_p->pack = pack_one_padding;
-    self_p->unpack = unpack_padding;
+    for (i++; i < length; i++) {
+        if (format_p[i] != c) {
+            break;
+        }
+    }
 
-    return (0);
+    return (i);
 }
 
-static int field_info_init(struct field_info_t *self_p,
-                           int kind,
-                           int number_of_bits)
+static struct byteswap_format_t *byteswap_format_parse(PyObject *format_p)
 {
-    int res;
-    bool is_padding;
+    struct byteswap_format_t *self_p;
+    struct byteswap_run_t *run_p;
+    const char *c_format_p;
+    Py_ssize_t length;
+    Py_ssize_t number_of_runs;
+    Py_ssize_t end;
+    Py_ssize_t i;
 
-    is_padding = false;
+    c_format_p = PyUnicode_AsUTF8AndSize(format_p, &length);
 
-    switch (kind) {
+    if (c_format_p == NULL) {
+        return (NULL);
+    }
 
-    case 's':
-        res = field_info_init_signed(self_p, number_of_bits);
-        break;
+    number_of_runs = 0;
 
-    case 'u':
-        res = field_info_init_unsigned(self_p, number_of_bits);
-        break;
+    for (i = 0; i < length; i = byteswap_format_run_end(c_format_p, length, i)) {
+        switch (c_format_p[i]) {
 
-    case 'f':
-        res = field_info_init_float(self_p, number_of_bits);
-        break;
+        case '1':
+        case '2':
+        case '4':
+        case '8':
+            number_of_runs++;
+            break;
 
-    case 'b':
-        res = field_info_init_bool(self_p, number_of_bits);
-        break;
+        default:
+            PyErr_Format(PyExc_ValueError,
+                         "Expected 1, 2, 4 or 8, but got %c.",
+                         c_format_p[i]);
 
-    case 't':
-        res = field_info_init_text(self_p, number_of_bits);
-        break;
+            return (NULL);
+        }
+    }
 
-    case 'r':
-        res = field_info_init_raw(self_p, number_of_bits);
-        break;
+    self_p = PyMem_RawMalloc(sizeof(*self_p)
+                             + (number_of_runs * sizeof(self_p->runs[0])));
 
-    case 'p':
-        is_padding = true;
-        res = field_info_init_zero_padding(self_p);
-        break;
+    if (self_p == NULL) {
+        PyErr_NoMemory();
 
-    case 'P':
-        is_padding = true;
-        res = field_info_init_one_padding(self_p);
-        break;
+        return (NULL);
+    }
 
-    default:
-        PyErr_Format(PyExc_ValueError, "Bad format field type '%c'.", kind);
-        res = -1;
-        break;
+    self_p->size = 0;
+    self_p->number_of_runs = number_of_runs;
+    run_p = &self_p->runs[0];
+
+    for (i = 0; i < length; i = end) {
+        end = byteswap_format_run_end(c_format_p, length, i);
+        run_p->item_size = (c_format_p[i] - '0');
+        run_p->count = (end - i);
+        self_p->size += (run_p->item_size * run_p->count);
+        run_p++;
     }
 
-    self_p->number_of_bits = number_of_bits;
-    self_p->is_padding = is_padding;
+    self_p->chunks_p = NULL;
+    self_p->number_of_chunks = 0;
 
-    return (res);
+    return (self_p);
 }
 
-static int count_number_of_fields(const char *format_p,
-                                  int *number_of_padding_fields_p)
+static void byteswap_format_free(struct byteswap_format_t *self_p)
 {
-    int count;
+    if (self_p != NULL) {
+        PyMem_RawFree(self_p->chunks_p);
+        PyMem_RawFree(self_p);
+    }
+}
 
-    count = 0;
-    *number_of_padding_fields_p = 0;
+/* Group items into chunks of at most BITSTREAM_BYTESWAP_RECORD_MAX_SIZE
+   bytes for swapping many records. Returns zero on success and -1 on
+   failure. */
+static int byteswap_format_compile_chunks(struct byteswap_format_t *self_p)
+{
+    struct byteswap_chunk_t *chunk_p;
+    struct byteswap_run_t *run_p;
+    Py_ssize_t offset;
+    Py_ssize_t i;
+    Py_ssize_t j;
+    int k;
 
-    while (*format_p != '\0') {
-        if ((*format_p >= 'A') && (*format_p <= 'z')) {
-            count++;
+    /* At most one chunk per item. */
+    self_p->chunks_p = PyMem_RawMalloc(self_p->size * sizeof(*chunk_p) + 1);
 
-            if ((*format_p == 'p') || (*format_p == 'P')) {
-                (*number_of_padding_fields_p)++;
+    if (self_p->chunks_p == NULL) {
+        PyErr_NoMemory();
+
+        return (-1);
+    }
+
+    chunk_p = NULL;
+    offset = 0;
+
+    for (i = 0; i < self_p->number_of_runs; i++) {
+        run_p = &self_p->runs[i];
+
+        for (j = 0; j < run_p->count; j++) {
+            if ((chunk_p == NULL)
+                || (chunk_p->size + run_p->item_size
+                    > BITSTREAM_BYTESWAP_RECORD_MAX_SIZE)) {
+                chunk_p = &self_p->chunks_p[self_p->number_of_chunks];
+                chunk_p->offset = offset;
+                chunk_p->size = 0;
+                self_p->number_of_chunks++;
             }
-        }
 
-        format_p++;
+            for (k = 0; k < run_p->item_size; k++) {
+                chunk_p->mask[chunk_p->size + k] =
+                    (uint8_t)(chunk_p->size + run_p->item_size - 1 - k);
+            }
+
+            chunk_p->size += run_p->item_size;
+            offset += run_p->item_size;
+        }
     }
 
-    return (count);
+    return (0);
 }
 
-const char *parse_field(const char *format_p,
-                        int *kind_p,
-                        int *number_of_bits_p)
+/* Swap given number of consecutive records from source to
+   destination, which may be the same buffer. */
+static void byteswap_format_swap(struct byteswap_format_t *self_p,
+                                 uint8_t *dst_p,
+                                 const uint8_t *src_p,
+                                 Py_ssize_t count)
 {
-    while (isspace(*format_p)) {
-        format_p++;
+    struct byteswap_chunk_t *chunk_p;
+    struct byteswap_run_t *run_p;
+    Py_ssize_t block_count;
+    Py_ssize_t offset;
+    Py_ssize_t i;
+
+    if ((count > 1)
+        && (self_p->number_of_runs > 1)
+        && (self_p->chunks_p != NULL)) {
+        /* Chunks of records larger than a shuffle are swapped in
+           place. */
+        if ((self_p->number_of_chunks > 1) && (dst_p != src_p)) {
+            memcpy(dst_p, src_p, (size_t)(self_p->size * count));
+            src_p = dst_p;
+        }
+
+        /* All chunks of a block of records while in the L1 cache. */
+        block_count = (BYTESWAP_BLOCK_SIZE / self_p->size + 1);
+
+        while (count > 0) {
+            if (block_count > count) {
+                block_count = count;
+            }
+
+            for (i = 0; i < self_p->number_of_chunks; i++) {
+                chunk_p = &self_p->chunks_p[i];
+                bitstream_byteswap_records(&dst_p[chunk_p->offset],
+                                           &src_p[chunk_p->offset],
+                                           &chunk_p->mask[0],
+                                           chunk_p->size,
+                                           self_p->size,
+                                           block_count);
+            }
+
+            dst_p += (self_p->size * block_count);
+            src_p += (self_p->size * block_count);
+            count -= block_count;
+        }
+
+        return;
     }
 
-    *kind_p = *format_p;
-    *number_of_bits_p = 0;
-    format_p++;
+    if (self_p->number_of_runs == 1) {
+        run_p = &self_p->runs[0];
+        bitstream_byteswap(dst_p,
+                           src_p,
+                           run_p->item_size,
+                           run_p->count * count);
 
-    while (isdigit(*format_p)) {
-        if (*number_of_bits_p > (INT_MAX / 100)) {
-            PyErr_SetString(PyExc_ValueError, "Field too long.");
+        return;
+    }
 
-            return (NULL);
+    offset = 0;
+
+    while (count > 0) {
+        for (i = 0; i < self_p->number_of_runs; i++) {
+            run_p = &self_p->runs[i];
+            bitstream_byteswap(&dst_p[offset],
+                               &src_p[offset],
+                               run_p->item_size,
+                               run_p->count);
+            offset += (run_p->item_size * run_p->count);
         }
 
-        *number_of_bits_p *= 10;
-        *number_of_bits_p += (*format_p - '0');
-        format_p++;
+        count--;
     }
+}
 
-    if (*number_of_bits_p == 0) {
-        PyErr_SetString(PyExc_ValueError, "Field of size 0.");
-        format_p = NULL;
+/* Returns the offset in bytes, or -1 on failure. */
+static Py_ssize_t parse_byteswap_offset(PyObject *offset_p)
+{
+    Py_ssize_t offset;
+
+    offset = PyLong_AsSsize_t(offset_p);
+
+    if ((offset == -1) && PyErr_Occurred()) {
+        return (-1);
     }
 
-    return (format_p);
+    if (offset < 0) {
+        PyErr_SetString(PyExc_ValueError, "Negative offset.");
+
+        return (-1);
+    }
+
+    return (offset);
 }
 
-static struct info_t *parse_format(PyObject *format_obj_p)
+/* Swap given number of records in given data starting at given
+   offset. Returns the swapped bytes, or None if swapped in place. */
+static PyObject *byteswap(struct byteswap_format_t *format_p,
+                          PyObject *data_p,
+                          Py_ssize_t count,
+                          PyObject *offset_p,
+                          PyObject *inplace_p)
 {
-    int number_of_fields;
-    struct info_t *info_p;
-    const char *format_p;
-    int i;
-    int kind;
-    int number_of_bits;
-    int number_of_padding_fields;
+    Py_buffer view;
+    PyObject *swapped_p;
+    Py_ssize_t offset;
+    Py_ssize_t size;
+    int inplace;
     int res;
 
-    format_p = PyUnicode_AsUTF8(format_obj_p);
+    if ((format_p->size > 0) && (count > PY_SSIZE_T_MAX / format_p->size)) {
+        PyErr_SetString(PyExc_ValueError, "Out of data to swap.");
 
-    if (format_p == NULL) {
         return (NULL);
     }
 
-    number_of_fields = count_number_of_fields(format_p,
-                                              &number_of_padding_fields);
+    size = (format_p->size * count);
+    offset = parse_byteswap_offset(offset_p);
 
-    info_p = PyMem_RawMalloc(
-        sizeof(*info_p) + number_of_fields * sizeof(info_p->fields[0]));
+    if (offset == -1) {
+        return (NULL);
+    }
 
-    if (info_p == NULL) {
+    inplace = PyObject_IsTrue(inplace_p);
+
+    if (inplace == -1) {
         return (NULL);
     }
 
-    info_p->number_of_bits = 0;
-    info_p->number_of_fields = number_of_fields;
-    info_p->number_of_non_padding_fields = (
-        number_of_fields - number_of_padding_fields);
+    res = PyObject_GetBuffer(data_p,
+                             &view,
+                             inplace ? PyBUF_WRITABLE : PyBUF_C_CONTIGUOUS);
 
-    for (i = 0; i < info_p->number_of_fields; i++) {
-        format_p = parse_field(format_p, &kind, &number_of_bits);
+    if (res == -1) {
+        return (NULL);
+    }
 
-        if (format_p == NULL) {
-            PyMem_RawFree(info_p);
+    if ((offset > view.len) || (size > (view.len - offset))) {
+        PyErr_SetString(PyExc_ValueError, "Out of data to swap.");
+        swapped_p = NULL;
+    } else if (inplace) {
+        byteswap_format_swap(format_p,
+                             (uint8_t *)view.buf + offset,
+                             (uint8_t *)view.buf + offset,
+                             count);
+        swapped_p = Py_None;
+        Py_INCREF(swapped_p);
+    } else {
+        swapped_p = PyBytes_FromStringAndSize(NULL, size);
 
-            return (NULL);
+        if (swapped_p != NULL) {
+            byteswap_format_swap(format_p,
+                                 (uint8_t *)PyBytes_AS_STRING(swapped_p),
+                                 (uint8_t *)view.buf + offset,
+                                 count);
         }
+    }
 
-        res = field_info_init(&info_p->fields[i], kind, number_of_bits);
+    PyBuffer_Release(&view);
 
-        if (res != 0) {
-            PyMem_RawFree(info_p);
+    return (swapped_p);
+}
 
-            return (NULL);
-        }
+PyDoc_STRVAR(byteswap___doc__,
+             "byteswap(fmt, data, offset=0, inplace=False)\n"
+             "--\n"
+             "\n"
+             "Swap bytes in any buffer data according to fmt, starting at\n"
+             "byte offset, and return the swapped bytes. If inplace is\n"
+             "True the writable buffer data is swapped and None returned.");
 
-        if (number_of_bits > (INT_MAX - info_p->number_of_bits)) {
-            PyErr_SetString(PyExc_ValueError, "Format too long.");
-            PyMem_RawFree(info_p);
+static PyObject *m_byteswap(PyObject *module_p,
+                            PyObject *const *args_pp,
+                            Py_ssize_t number_of_args,
+                            PyObject *kwnames_p)
+{
+    struct byteswap_format_t *format_p;
+    PyObject *swapped_p;
+    int res;
+    static const char *const keywords[] = {
+        "fmt",
+        "data",
+        "offset",
+        "inplace",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        py_zero_p,
+        Py_False
+    };
 
-            return (NULL);
-        }
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
-        info_p->number_of_bits += number_of_bits;
+    if (res != 0) {
+        return (NULL);
     }
 
-    return (info_p);
+    format_p = byteswap_format_parse(values[0]);
+
+    if (format_p == NULL) {
+        return (NULL);
+    }
+
+    swapped_p = byteswap(format_p, values[1], 1, values[2], values[3]);
+    byteswap_format_free(format_p);
+
+    return (swapped_p);
 }
 
-static void pack_pack(struct info_t *info_p,
-                      PyObject *args_p,
-                      int consumed_args,
-                      struct bitstream_writer_t *writer_p)
+static PyObject *compiled_byteswap_new(PyTypeObject *type_p,
+                                       PyObject *args_p,
+                                       PyObject *kwargs_p)
 {
-    PyObject *value_p;
-    int i;
-    struct field_info_t *field_p;
+    return (type_p->tp_alloc(type_p, 0));
+}
 
-    for (i = 0; i < info_p->number_of_fields; i++) {
-        field_p = &info_p->fields[i];
+static int compiled_byteswap_init(struct compiled_byteswap_t *self_p,
+                                  PyObject *args_p,
+                                  PyObject *kwargs_p)
+{
+    int res;
+    PyObject *pattern_p;
+    struct byteswap_format_t *format_p;
 
-        if (field_p->is_padding) {
-            value_p = NULL;
-        } else {
-            value_p = PyTuple_GET_ITEM(args_p, consumed_args);
-            consumed_args++;
-        }
+    static char *keywords[] = {
+        "pattern",
+        NULL
+    };
+
+    res = PyArg_ParseTupleAndKeywords(args_p,
+                                      kwargs_p,
+                                      "O",
+                                      &keywords[0],
+                                      &pattern_p);
 
-        info_p->fields[i].pack(writer_p, value_p, field_p);
+    if (res == 0) {
+        return (-1);
     }
-}
 
-static PyObject *pack_prepare(struct info_t *info_p,
-                              struct bitstream_writer_t *writer_p)
-{
-    PyObject *packed_p;
+    format_p = byteswap_format_parse(pattern_p);
 
-    packed_p = PyBytes_FromStringAndSize(NULL, (info_p->number_of_bits + 7) / 8);
+    if (format_p == NULL) {
+        return (-1);
+    }
 
-    if (packed_p == NULL) {
-        return (NULL);
+    if (byteswap_format_compile_chunks(format_p) != 0) {
+        byteswap_format_free(format_p);
+
+        return (-1);
     }
 
-    bitstream_writer_init(writer_p, (uint8_t *)PyBytes_AS_STRING(packed_p));
+    byteswap_format_free(self_p->format_p);
+    self_p->format_p = format_p;
+    Py_INCREF(pattern_p);
+    Py_XDECREF(self_p->pattern_p);
+    self_p->pattern_p = pattern_p;
+
+    return (0);
+}
 
-    return (packed_p);
+static void compiled_byteswap_dealloc(struct compiled_byteswap_t *self_p)
+{
+    byteswap_format_free(self_p->format_p);
+    Py_XDECREF(self_p->pattern_p);
+    Py_TYPE(self_p)->tp_free((PyObject *)self_p);
 }
 
-static PyObject *pack_finalize(PyObject *packed_p)
+/* Returns the parsed pattern, or NULL with an exception set if not
+   initialized. */
+static struct byteswap_format_t *compiled_byteswap_format(
+    struct compiled_byteswap_t *self_p)
 {
-    if (PyErr_Occurred() != NULL) {
-        Py_DECREF(packed_p);
-        packed_p = NULL;
+    if (self_p->format_p == NULL) {
+        PyErr_SetString(PyExc_ValueError, "Uninitialized byteswap.");
     }
 
-    return (packed_p);
+    return (self_p->format_p);
 }
 
-static PyObject *pack(struct info_t *info_p,
-                      PyObject *args_p,
-                      int consumed_args,
-                      Py_ssize_t number_of_args)
+static PyObject *m_compiled_byteswap_swap(struct compiled_byteswap_t *self_p,
+                                          PyObject *const *args_pp,
+                                          Py_ssize_t number_of_args,
+                                          PyObject *kwnames_p)
 {
-    struct bitstream_writer_t writer;
-    PyObject *packed_p;
+    struct byteswap_format_t *format_p;
+    int res;
+    static const char *const keywords[] = {
+        "data",
+        "offset",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        py_zero_p
+    };
 
-    if (number_of_args < info_p->number_of_non_padding_fields) {
-        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
+    if (res != 0) {
         return (NULL);
     }
 
-    packed_p = pack_prepare(info_p, &writer);
+    format_p = compiled_byteswap_format(self_p);
 
-    if (packed_p == NULL) {
+    if (format_p == NULL) {
         return (NULL);
     }
 
-    pack_pack(info_p, args_p, consumed_args, &writer);
-
-    return (pack_finalize(packed_p));
+    return (byteswap(format_p, values[0], 1, values[1], Py_False));
 }
 
-static PyObject *m_pack(PyObject *module_p, PyObject *args_p)
+static PyObject *m_compiled_byteswap_swap_into(
+    struct compiled_byteswap_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p)
 {
-    Py_ssize_t number_of_args;
-    PyObject *packed_p;
-    struct info_t *info_p;
-
-    number_of_args = PyTuple_GET_SIZE(args_p);
+    struct byteswap_format_t *format_p;
+    int res;
+    static const char *const keywords[] = {
+        "buf",
+        "offset",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        py_zero_p
+    };
 
-    if (number_of_args < 1) {
-        PyErr_SetString(PyExc_ValueError, "No format string.");
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
+    if (res != 0) {
         return (NULL);
     }
 
-    info_p = parse_format(PyTuple_GET_ITEM(args_p, 0));
+    format_p = compiled_byteswap_format(self_p);
 
-    if (info_p == NULL) {
+    if (format_p == NULL) {
         return (NULL);
     }
 
-    packed_p = pack(info_p, args_p, 1, number_of_args - 1);
-    PyMem_RawFree(info_p);
-
-    return (packed_p);
+    return (byteswap(format_p, values[0], 1, values[1], Py_True));
 }
 
-static PyObject *unpack(struct info_t *info_p,
-                        PyObject *data_p,
-                        long offset,
-                        PyObject *allow_truncated_p)
+static PyObject *m_compiled_byteswap_swap_many(
+    struct compiled_byteswap_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p)
 {
-    struct bitstream_reader_t reader;
-    PyObject *unpacked_p = NULL;
-    PyObject *value_p;
-    Py_buffer view = {NULL, NULL};
-    int i;
-    int tmp;
-    int produced_args;
+    struct byteswap_format_t *format_p;
+    Py_ssize_t count;
     int res;
-    int allow_truncated;
-    int num_result_fields;
+    static const char *const keywords[] = {
+        "data",
+        "count",
+        "offset",
+        "inplace",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        py_zero_p,
+        Py_False
+    };
 
-    res = PyObject_GetBuffer(data_p, &view, PyBUF_C_CONTIGUOUS);
-    if (res == -1) {
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
         return (NULL);
     }
 
-    allow_truncated = PyObject_IsTrue(allow_truncated_p);
-
-    if (allow_truncated) {
-        num_result_fields = 0;
-        tmp = 0;
-        for (i = 0; i < info_p->number_of_fields; i++) {
-            if (view.len*8 < tmp + info_p->fields[i].number_of_bits) {
-                break;
-            }
-
-            tmp += info_p->fields[i].number_of_bits;
-
-            if (!info_p->fields[i].is_padding) {
-                ++num_result_fields;
-            }
-        }
-    }
-    else {
-        num_result_fields = info_p->number_of_non_padding_fields;
+    format_p = compiled_byteswap_format(self_p);
 
-        if (view.len < ((info_p->number_of_bits + offset + 7) / 8)) {
-            PyErr_SetString(PyExc_ValueError, "Short data.");
-            goto exit;
-        }
+    if (format_p == NULL) {
+        return (NULL);
     }
 
-    unpacked_p = PyTuple_New(num_result_fields);
+    count = PyLong_AsSsize_t(values[1]);
 
-    if (unpacked_p == NULL) {
-        goto exit;
+    if ((count == -1) && PyErr_Occurred()) {
+        return (NULL);
     }
 
-    bitstream_reader_init(&reader, (uint8_t *)view.buf);
-    bitstream_reader_seek(&reader, offset);
-    produced_args = 0;
-
-    for (i = 0; i < info_p->number_of_fields; i++) {
-        if (produced_args == num_result_fields) {
-            break;
-        }
-
-        value_p = info_p->fields[i].unpack(&reader, &info_p->fields[i]);
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "Negative count.");
 
-        if (value_p != NULL) {
-            PyTuple_SET_ITEM(unpacked_p, produced_args, value_p);
-            produced_args++;
-        }
+        return (NULL);
     }
 
-    /*
- out1:
-    if (PyErr_Occurred() != NULL) {
-        Py_DECREF(unpacked_p);
-        unpacked_p = NULL;
-    }
-    */
-exit:
-    PyBuffer_Release(&view);
-    return (unpacked_p);
+    return (byteswap(format_p, values[0], count, values[2], values[3]));
 }
 
-static PyObject *m_unpack(PyObject *module_p,
-                          PyObject *args_p,
-                          PyObject *kwargs_p)
+static PyObject *m_compiled_byteswap_calcsize(struct compiled_byteswap_t *self_p)
 {
-    PyObject *format_p;
-    PyObject *data_p;
-    PyObject *unpacked_p;
-    PyObject *allow_truncated_p;
-    struct info_t *info_p;
-    int res;
-    static char *keywords[] = {
-        "fmt",
-        "data",
-        "allow_truncated",
-        NULL
-    };
+    struct byteswap_format_t *format_p;
 
-    allow_truncated_p = py_zero_p;
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "OO|O",
-                                      &keywords[0],
-                                      &format_p,
-                                      &data_p,
-                                      &allow_truncated_p);
+    format_p = compiled_byteswap_format(self_p);
 
-    if (res == 0) {
+    if (format_p == NULL) {
         return (NULL);
     }
 
-    info_p = parse_format(format_p);
+    return (PyLong_FromSsize_t(format_p->size));
+}
 
-    if (info_p == NULL) {
+static PyObject *m_compiled_byteswap_reduce(struct compiled_byteswap_t *self_p)
+{
+    if (compiled_byteswap_format(self_p) == NULL) {
         return (NULL);
     }
 
-    unpacked_p = unpack(info_p, data_p, 0, allow_truncated_p);
-    PyMem_RawFree(info_p);
+    return (Py_BuildValue("O(O)", Py_TYPE(self_p), self_p->pattern_p));
+}
 
-    return (unpacked_p);
+PyDoc_STRVAR(compile_byteswap___doc__,
+             "compile_byteswap(pattern)\n"
+             "--\n"
+             "\n"
+             "Compile given byteswap pattern, for example '2448', into an\n"
+             "object that swaps records without parsing it again.");
+
+static PyObject *m_compile_byteswap(PyObject *module_p, PyObject *pattern_p)
+{
+    return (PyObject_CallFunctionObjArgs((PyObject *)&compiled_byteswap_type,
+                                         pattern_p,
+                                         NULL));
 }
 
-static long parse_offset(PyObject *offset_p)
+static void prefix_code_free(struct prefix_code_t *self_p)
 {
-    unsigned long offset;
+    if (self_p == NULL) {
+        return;
+    }
 
-    offset = PyLong_AsUnsignedLong(offset_p);
+    Py_DECREF(self_p->codes_p);
+    PyMem_RawFree(self_p);
+}
 
-    if (offset == (unsigned long)-1) {
-        return (-1);
+/* Create a prefix code of given sequence of bit strings, with the
+   index of each string as its symbol. */
+static struct prefix_code_t *prefix_code_new(PyObject *codes_p)
+{
+    struct prefix_code_t *self_p;
+    struct bitstream_prefix_code_entry_t *entry_p;
+    PyObject *tuple_p;
+    const char *string_p;
+    Py_ssize_t length;
+    Py_ssize_t number_of_symbols;
+    Py_ssize_t i;
+    Py_ssize_t j;
+
+    tuple_p = PySequence_Tuple(codes_p);
+
+    if (tuple_p == NULL) {
+        return (NULL);
     }
 
-    if (offset > 0x7fffffff) {
-        PyErr_Format(PyExc_ValueError,
-                     "Offset must be less or equal to %d bits.",
-                     0x7fffffff);
+    number_of_symbols = PyTuple_GET_SIZE(tuple_p);
 
-        return (-1);
+    if ((number_of_symbols < 1) || (number_of_symbols > (1 << 24))) {
+        goto out1;
     }
 
-    return (offset);
-}
-
-static int pack_into_prepare(struct info_t *info_p,
-                             PyObject *buf_p,
-                             PyObject *offset_p,
-                             struct bitstream_writer_t *writer_p,
-                             struct bitstream_writer_bounds_t *bounds_p)
-{
-    uint8_t *packed_p;
-    Py_ssize_t size;
-    long offset;
+    self_p = PyMem_RawMalloc(sizeof(*self_p)
+                             + ((2 * number_of_symbols - 1)
+                                * sizeof(self_p->entries[0])));
 
-    offset = parse_offset(offset_p);
+    if (self_p == NULL) {
+        Py_DECREF(tuple_p);
+        PyErr_NoMemory();
 
-    if (offset == -1) {
-        return (-1);
+        return (NULL);
     }
 
-    if (!PyByteArray_Check(buf_p)) {
-        PyErr_SetString(PyExc_TypeError, "Bytearray needed.");
+    self_p->codes_p = tuple_p;
+    self_p->number_of_symbols = (int)number_of_symbols;
+    self_p->symbols_p = &self_p->entries[number_of_symbols];
 
-        return (-1);
-    }
+    for (i = 0; i < number_of_symbols; i++) {
+        string_p = PyUnicode_AsUTF8AndSize(PyTuple_GET_ITEM(tuple_p, i),
+                                           &length);
 
-    packed_p = (uint8_t *)PyByteArray_AsString(buf_p);
+        if (string_p == NULL) {
+            goto out2;
+        }
 
-    if (packed_p == NULL) {
-        return (-1);
-    }
+        if ((length < 1) || (length > 32)) {
+            goto out3;
+        }
 
-    size = PyByteArray_GET_SIZE(buf_p);
+        entry_p = &self_p->symbols_p[i];
+        entry_p->code = 0;
+        entry_p->length = (int)length;
+        entry_p->symbol = (uint32_t)i;
 
-    if (size < ((info_p->number_of_bits + offset + 7) / 8)) {
-        PyErr_Format(PyExc_ValueError,
-                     "pack_into requires a buffer of at least %ld bits",
-                     info_p->number_of_bits + offset);
+        for (j = 0; j < length; j++) {
+            if ((string_p[j] != '0') && (string_p[j] != '1')) {
+                goto out3;
+            }
 
-        return (-1);
+            entry_p->code <<= 1;
+            entry_p->code |= (uint32_t)(string_p[j] == '1');
+        }
+
+        self_p->entries[i] = *entry_p;
     }
 
-    bitstream_writer_init(writer_p, packed_p);
-    bitstream_writer_bounds_save(bounds_p,
-                                 writer_p,
-                                 offset,
-                                 info_p->number_of_bits);
-    bitstream_writer_seek(writer_p, offset);
+    if (bitstream_prefix_code_init(&self_p->decoder,
+                                   &self_p->entries[0],
+                                   self_p->number_of_symbols) != 0) {
+        goto out3;
+    }
 
-    return (0);
-}
+    return (self_p);
 
-static PyObject *pack_into_finalize(struct bitstream_writer_bounds_t *bounds_p)
-{
-    bitstream_writer_bounds_restore(bounds_p);
+ out3:
+    PyErr_SetString(PyExc_ValueError, "Bad prefix code table.");
 
-    if (PyErr_Occurred() != NULL) {
-        return (NULL);
-    }
+ out2:
+    prefix_code_free(self_p);
 
-    Py_RETURN_NONE;
+    return (NULL);
+
+ out1:
+    Py_DECREF(tuple_p);
+    PyErr_SetString(PyExc_ValueError, "Bad prefix code table.");
+
+    return (NULL);
 }
 
-static PyObject *pack_into(struct info_t *info_p,
-                           PyObject *buf_p,
-                           PyObject *offset_p,
-                           PyObject *args_p,
-                           Py_ssize_t consumed_args,
-                           Py_ssize_t number_of_args)
+/* Serializes setting prefix codes. */
+#ifdef Py_GIL_DISABLED
+static PyMutex prefix_code_mutex = { 0 };
+#    define PREFIX_CODE_LOCK() PyMutex_Lock(&prefix_code_mutex)
+#    define PREFIX_CODE_UNLOCK() PyMutex_Unlock(&prefix_code_mutex)
+#else
+#    define PREFIX_CODE_LOCK()
+#    define PREFIX_CODE_UNLOCK()
+#endif
+
+/* Set the prefix code of given format. It can only be set once, as
+   other threads may be packing or unpacking with it, and the largest
+   symbol must fit in all prefix code fields of the format. */
+static int set_prefix_code(struct info_t *info_p,
+                           struct prefix_code_t **prefix_code_pp,
+                           PyObject *codes_p)
 {
-    struct bitstream_writer_t writer;
-    struct bitstream_writer_bounds_t bounds;
-    int res;
+    struct prefix_code_t *prefix_code_p;
+    int i;
 
-    if ((number_of_args - consumed_args) < info_p->number_of_non_padding_fields) {
-        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+    prefix_code_p = prefix_code_new(codes_p);
 
-        return (NULL);
+    if (prefix_code_p == NULL) {
+        return (-1);
     }
 
-    res = pack_into_prepare(info_p, buf_p, offset_p, &writer, &bounds);
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        if ((info_p->fields[i].unpack == unpack_prefix_code)
+            && ((uint64_t)(prefix_code_p->number_of_symbols - 1)
+                > info_p->fields[i].limits.u.upper)) {
+            PyErr_SetString(PyExc_ValueError, "Too many prefix code symbols.");
+            prefix_code_free(prefix_code_p);
 
-    if (res != 0) {
-        return (NULL);
+            return (-1);
+        }
+    }
+
+    PREFIX_CODE_LOCK();
+
+    if (*prefix_code_pp != NULL) {
+        PREFIX_CODE_UNLOCK();
+        PyErr_SetString(PyExc_ValueError, "Prefix code already set.");
+        prefix_code_free(prefix_code_p);
+
+        return (-1);
+    }
+
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        if (info_p->fields[i].unpack == unpack_prefix_code) {
+            PREFIX_CODE_STORE(&info_p->fields[i].prefix_code_p,
+                              prefix_code_p);
+        }
     }
 
-    pack_pack(info_p, args_p, consumed_args, &writer);
+    PREFIX_CODE_STORE(prefix_code_pp, prefix_code_p);
+    PREFIX_CODE_UNLOCK();
 
-    return (pack_into_finalize(&bounds));
+    return (0);
 }
 
-static PyObject *m_pack_into(PyObject *module_p,
-                             PyObject *args_p,
-                             PyObject *kwargs_p)
+/* Give a copy of a compiled format its own prefix code, as the copied
+   fields refer to the original. */
+static int copy_prefix_code(struct info_t *info_p,
+                            struct prefix_code_t **prefix_code_pp,
+                            const struct prefix_code_t *original_p)
 {
-    PyObject *format_p;
-    PyObject *buf_p;
-    PyObject *offset_p;
-    PyObject *res_p;
-    Py_ssize_t number_of_args;
-    struct info_t *info_p;
-
-    number_of_args = PyTuple_GET_SIZE(args_p);
+    int i;
 
-    if (number_of_args < 3) {
-        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+    if (original_p == NULL) {
+        return (0);
+    }
 
-        return (NULL);
+    for (i = 0; i < info_p->number_of_fields; i++) {
+        info_p->fields[i].prefix_code_p = NULL;
     }
 
-    format_p = PyTuple_GET_ITEM(args_p, 0);
-    buf_p = PyTuple_GET_ITEM(args_p, 1);
-    offset_p = PyTuple_GET_ITEM(args_p, 2);
-    info_p = parse_format(format_p);
+    return (set_prefix_code(info_p, prefix_code_pp, original_p->codes_p));
+}
 
-    if (info_p == NULL) {
-        return (NULL);
+/* Add the prefix code to given pickle state, if set. */
+static PyObject *getstate_prefix_code(PyObject *state_p,
+                                      const struct prefix_code_t *prefix_code_p)
+{
+    if ((state_p == NULL) || (prefix_code_p == NULL)) {
+        return (state_p);
     }
 
-    res_p = pack_into(info_p,
-                      buf_p,
-                      offset_p,
-                      args_p,
-                      3,
-                      number_of_args);
-    PyMem_RawFree(info_p);
+    if (PyDict_SetItemString(state_p,
+                             "prefix_codes",
+                             prefix_code_p->codes_p) != 0) {
+        Py_DECREF(state_p);
+        state_p = NULL;
+    }
 
-    return (res_p);
+    return (state_p);
 }
 
-static PyObject *unpack_from(struct info_t *info_p,
-                             PyObject *data_p,
-                             PyObject *offset_p,
-                             PyObject *allow_truncated_p)
+static PyObject *setstate_prefix_code(struct info_t *info_p,
+                                      struct prefix_code_t **prefix_code_pp,
+                                      PyObject *state_p)
 {
-    long offset;
+    PyObject *codes_p;
 
-    offset = parse_offset(offset_p);
+    codes_p = PyDict_GetItemString(state_p, "prefix_codes");
 
-    if (offset == -1) {
-        return (NULL);
+    if (codes_p != NULL) {
+        if (set_prefix_code(info_p, prefix_code_pp, codes_p) != 0) {
+            return (NULL);
+        }
     }
 
-    return (unpack(info_p, data_p, offset, allow_truncated_p));
+    Py_RETURN_NONE;
 }
 
-static PyObject *m_unpack_from(PyObject *module_p,
-                               PyObject *args_p,
-                               PyObject *kwargs_p)
+static PyObject *unpack_symbols(const struct prefix_code_t *prefix_code_p,
+                                PyObject *const *args_pp,
+                                Py_ssize_t number_of_args,
+                                PyObject *kwnames_p)
 {
-    PyObject *format_p;
-    PyObject *data_p;
-    PyObject *offset_p;
-    PyObject *unpacked_p;
-    PyObject *allow_truncated_p;
-    struct info_t *info_p;
+    struct bitstream_reader_t reader;
+    Py_buffer view;
+    Py_buffer array_view;
+    PyObject *array_p;
+    Py_ssize_t count;
+    long long offset;
     int res;
-    static char *keywords[] = {
-        "fmt",
+    static const char *const keywords[] = {
         "data",
+        "count",
         "offset",
-        "allow_truncated",
         NULL
     };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        py_zero_p
+    };
 
-    offset_p = py_zero_p;
-    allow_truncated_p = py_zero_p;
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "OO|OO",
-                                      &keywords[0],
-                                      &format_p,
-                                      &data_p,
-                                      &offset_p,
-                                      &allow_truncated_p);
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
-    if (res == 0) {
+    if (res != 0) {
         return (NULL);
     }
 
-    info_p = parse_format(format_p);
+    if (prefix_code_p == NULL) {
+        PyErr_SetString(PyExc_ValueError, "No prefix code.");
 
-    if (info_p == NULL) {
         return (NULL);
     }
 
-    unpacked_p = unpack_from(info_p, data_p, offset_p, allow_truncated_p);
-    PyMem_RawFree(info_p);
+    count = PyLong_AsSsize_t(values[1]);
 
-    return (unpacked_p);
-}
+    if ((count == -1) && PyErr_Occurred()) {
+        return (NULL);
+    }
 
-static void pack_dict_pack(struct info_t *info_p,
-                           PyObject *names_p,
-                           PyObject *data_p,
-                           struct bitstream_writer_t *writer_p)
-{
-    PyObject *value_p;
-    int i;
-    int consumed_args;
-    struct field_info_t *field_p;
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "Negative count.");
 
-    consumed_args = 0;
+        return (NULL);
+    }
 
-    for (i = 0; i < info_p->number_of_fields; i++) {
-        field_p = &info_p->fields[i];
+    offset = parse_offset(values[2]);
 
-        if (field_p->is_padding) {
-            value_p = NULL;
-        } else {
-            value_p = PyDict_GetItem(data_p,
-                                     PyList_GET_ITEM(names_p, consumed_args));
-            consumed_args++;
+    if (offset == -1) {
+        return (NULL);
+    }
 
-            if (value_p == NULL) {
-                PyErr_SetString(PyExc_KeyError, "Missing value.");
-                break;
-            }
-        }
+    res = PyObject_GetBuffer(values[0], &view, PyBUF_C_CONTIGUOUS);
 
-        info_p->fields[i].pack(writer_p, value_p, field_p);
+    if (res == -1) {
+        return (NULL);
     }
-}
 
-static PyObject *pack_dict(struct info_t *info_p,
-                           PyObject *names_p,
-                           PyObject *data_p)
-{
-    struct bitstream_writer_t writer;
-    PyObject *packed_p;
+    array_p = NULL;
+    bitstream_reader_init_window(&reader, (uint8_t *)view.buf, view.len);
 
-    if (PyList_GET_SIZE(names_p) < info_p->number_of_non_padding_fields) {
-        PyErr_SetString(PyExc_ValueError, "Too few names.");
+    if (bitstream_reader_seek_checked(&reader, offset) != 0) {
+        PyErr_SetString(PyExc_ValueError, "Short data.");
+        goto out1;
+    }
 
-        return (NULL);
+    array_p = column_new(prefix_code_p->number_of_symbols <= 65536 ? 'H' : 'I',
+                         count);
+
+    if (array_p == NULL) {
+        goto out1;
     }
 
-    packed_p = pack_prepare(info_p, &writer);
+    res = PyObject_GetBuffer(array_p, &array_view, PyBUF_WRITABLE);
 
-    if (packed_p == NULL) {
-        return (NULL);
+    if (res == -1) {
+        goto out2;
     }
 
-    pack_dict_pack(info_p, names_p, data_p, &writer);
+    res = bitstream_reader_read_prefix_codes(&reader,
+                                             &prefix_code_p->decoder,
+                                             array_view.buf,
+                                             (int)array_view.itemsize,
+                                             count);
+    PyBuffer_Release(&array_view);
 
-    return (pack_finalize(packed_p));
-}
+    if (res == -1) {
+        PyErr_SetString(PyExc_ValueError, "Short data.");
+        goto out2;
+    }
 
-PyDoc_STRVAR(pack_dict___doc__,
-             "pack_dict(fmt, names, data)\n"
-             "--\n"
-             "\n");
+    if (res != 0) {
+        PyErr_SetString(PyExc_ValueError, "Bad prefix code.");
+        goto out2;
+    }
+
+    goto out1;
+
+ out2:
+    Py_DECREF(array_p);
+    array_p = NULL;
 
-static PyObject *m_pack_dict(PyObject *module_p, PyObject *args_p)
+ out1:
+    PyBuffer_Release(&view);
+
+    return (array_p);
+}
+
+/* Returns zero on success and -1 on failure. */
+static int set_raw_as_memoryview(struct info_t *info_p,
+                                 PyObject *raw_as_memoryview_p)
 {
-    PyObject *format_p;
-    PyObject *names_p;
-    PyObject *data_p;
-    PyObject *packed_p;
-    struct info_t *info_p;
-    int res;
+    int raw_as_memoryview;
 
-    res = PyArg_ParseTuple(args_p, "OOO", &format_p, &names_p, &data_p);
+    raw_as_memoryview = PyObject_IsTrue(raw_as_memoryview_p);
 
-    if (res == 0) {
-        return (NULL);
+    if (raw_as_memoryview == -1) {
+        return (-1);
     }
 
-    info_p = parse_format(format_p);
+    info_p->raw_as_memoryview = raw_as_memoryview;
 
-    if (info_p == NULL) {
-        return (NULL);
-    }
+    return (0);
+}
 
-    if (!is_names_list(names_p)) {
-        return (NULL);
-    }
+/* Optional in the state, as not in older pickles. */
+static int setstate_raw_as_memoryview(struct info_t *info_p,
+                                      PyObject *state_p)
+{
+    PyObject *raw_as_memoryview_p;
 
-    packed_p = pack_dict(info_p, names_p, data_p);
-    PyMem_RawFree(info_p);
+    raw_as_memoryview_p = PyDict_GetItemString(state_p, "raw_as_memoryview");
 
-    return (packed_p);
+    if (raw_as_memoryview_p == NULL) {
+        return (0);
+    }
+
+    return (set_raw_as_memoryview(info_p, raw_as_memoryview_p));
 }
 
-static PyObject *unpack_dict(struct info_t *info_p,
-                             PyObject *names_p,
-                             PyObject *data_p,
-                             long offset,
-                             PyObject *allow_truncated_p)
+static PyObject *compiled_format_create(PyTypeObject *type_p,
+                                        PyObject *format_p,
+                                        PyObject *raw_as_memoryview_p)
 {
-    struct bitstream_reader_t reader;
-    PyObject *unpacked_p;
-    PyObject *value_p;
-    Py_buffer view = {NULL, NULL};
-    int i;
-    int res;
-    int produced_args;
-    int allow_truncated;
+    PyObject *self_p;
 
-    if (PyList_GET_SIZE(names_p) < info_p->number_of_non_padding_fields) {
-        PyErr_SetString(PyExc_ValueError, "Too few names.");
+    self_p = compiled_format_new(type_p, NULL, NULL);
 
+    if (self_p == NULL) {
         return (NULL);
     }
 
-    unpacked_p = PyDict_New();
-
-    if (unpacked_p == NULL) {
+    if (compiled_format_init_inner((struct compiled_format_t *)self_p,
+                                   format_p) != 0) {
         return (NULL);
     }
 
-    res = PyObject_GetBuffer(data_p, &view, PyBUF_C_CONTIGUOUS);
+    if (set_raw_as_memoryview(((struct compiled_format_t *)self_p)->info_p,
+                              raw_as_memoryview_p) != 0) {
+        Py_DECREF(self_p);
 
-    if (res == -1) {
-        goto out1;
+        return (NULL);
     }
 
-    allow_truncated = PyObject_IsTrue(allow_truncated_p);
-
-    if (!allow_truncated && view.len < ((info_p->number_of_bits + offset + 7) / 8)) {
-        PyErr_SetString(PyExc_ValueError, "Short data.");
+    return (self_p);
+}
 
-        goto out1;
-    }
+static PyObject *compiled_format_new(PyTypeObject *type_p,
+                                     PyObject *args_p,
+                                     PyObject *kwargs_p)
+{
+    return (type_p->tp_alloc(type_p, 0));
+}
 
-    bitstream_reader_init(&reader, (uint8_t *)view.buf);
-    bitstream_reader_seek(&reader, offset);
-    produced_args = 0;
+static int compiled_format_init(struct compiled_format_t *self_p,
+                                PyObject *args_p,
+                                PyObject *kwargs_p)
+{
+    int res;
+    PyObject *format_p;
+    PyObject *raw_as_memoryview_p;
 
-    for (i = 0; i < info_p->number_of_fields; i++) {
-        if (view.len*8 < reader.bit_offset + info_p->fields[i].number_of_bits)
-            break;
+    static char *keywords[] = {
+        "fmt",
+        "raw_as_memoryview",
+        NULL
+    };
 
-        value_p = info_p->fields[i].unpack(&reader, &info_p->fields[i]);
+    raw_as_memoryview_p = Py_False;
+    res = PyArg_ParseTupleAndKeywords(args_p,
+                                      kwargs_p,
+                                      "O|O",
+                                      &keywords[0],
+                                      &format_p,
+                                      &raw_as_memoryview_p);
 
-        if (value_p != NULL) {
-            PyDict_SetItem(unpacked_p,
-                           PyList_GET_ITEM(names_p, produced_args),
-                           value_p);
-            Py_DECREF(value_p);
-            produced_args++;
-        }
+    if (res == 0) {
+        return (-1);
     }
 
- out1:
-    if (PyErr_Occurred() != NULL) {
-        Py_DECREF(unpacked_p);
-        unpacked_p = NULL;
+    if (compiled_format_init_inner(self_p, format_p) != 0) {
+        return (-1);
     }
 
-    if (view.obj != NULL) {
-        PyBuffer_Release(&view);
+    return (set_raw_as_memoryview(self_p->info_p, raw_as_memoryview_p));
+}
+
+static int compiled_format_init_inner(struct compiled_format_t *self_p,
+                                      PyObject *format_p)
+{
+    self_p->info_p = parse_format(format_p);
+
+    if (self_p->info_p == NULL) {
+        PyObject_Free(self_p);
+
+        return (-1);
     }
 
-    return (unpacked_p);
+    Py_INCREF(format_p);
+    self_p->format_p = format_p;
+
+    return (0);
 }
 
-PyDoc_STRVAR(unpack_dict___doc__,
-             "unpack_dict(fmt, names, data, allow_truncated=False)\n"
-             "--\n"
-             "\n");
+static void compiled_format_dealloc(struct compiled_format_t *self_p)
+{
+    prefix_code_free(self_p->prefix_code_p);
+    PyMem_RawFree(self_p->info_p);
+    Py_DECREF(self_p->format_p);
+    Py_TYPE(self_p)->tp_free((PyObject *)self_p);
+}
 
-static PyObject *m_unpack_dict(PyObject *module_p,
-                               PyObject *args_p,
-                               PyObject *kwargs_p)
+static PyObject *m_compiled_format_pack(struct compiled_format_t *self_p,
+                                        PyObject *const *args_pp,
+                                        Py_ssize_t number_of_args)
+{
+    return (pack(self_p->info_p, args_pp, number_of_args));
+}
+
+static PyObject *m_compiled_format_unpack(struct compiled_format_t *self_p,
+                                          PyObject *const *args_pp,
+                                          Py_ssize_t number_of_args,
+                                          PyObject *kwnames_p)
 {
-    PyObject *format_p;
-    PyObject *names_p;
-    PyObject *data_p;
-    PyObject *allow_truncated_p;
-    PyObject *unpacked_p;
-    struct info_t *info_p;
     int res;
-    static char *keywords[] = {
-        "fmt",
-        "names",
+    static const char *const keywords[] = {
         "data",
         "allow_truncated",
         NULL
     };
+    PyObject *values[] = {
+        NULL,
+        py_zero_p
+    };
 
-    allow_truncated_p = py_zero_p;
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "OOO|O",
-                                      &keywords[0],
-                                      &format_p,
-                                      &names_p,
-                                      &data_p,
-                                      &allow_truncated_p);
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
-    if (res == 0) {
+    if (res != 0) {
         return (NULL);
     }
 
-    info_p = parse_format(format_p);
+    return (unpack(self_p->info_p, values[0], 0, values[1]));
+}
 
-    if (info_p == NULL) {
-        return (NULL);
-    }
+static PyObject *m_compiled_format_pack_into(struct compiled_format_t *self_p,
+                                             PyObject *const *args_pp,
+                                             Py_ssize_t number_of_args,
+                                             PyObject *kwnames_p)
+{
+    if (number_of_args < 2) {
+        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
 
-    if (!is_names_list(names_p)) {
         return (NULL);
     }
 
-    unpacked_p = unpack_dict(info_p, names_p, data_p, 0, allow_truncated_p);
-    PyMem_RawFree(info_p);
-
-    return (unpacked_p);
+    return (pack_into(self_p->info_p,
+                      args_pp[0],
+                      args_pp[1],
+                      &args_pp[2],
+                      number_of_args - 2,
+                      kwnames_p));
 }
 
-static PyObject *unpack_from_dict(struct info_t *info_p,
-                                  PyObject *names_p,
-                                  PyObject *data_p,
-                                  PyObject *offset_p,
-                                  PyObject *allow_truncated_p)
+static PyObject *m_compiled_format_unpack_from(struct compiled_format_t *self_p,
+                                               PyObject *const *args_pp,
+                                               Py_ssize_t number_of_args,
+                                               PyObject *kwnames_p)
 {
-    long offset;
+    int res;
+    static const char *const keywords[] = {
+        "data",
+        "offset",
+        "allow_truncated",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        py_zero_p,
+        py_zero_p
+    };
 
-    offset = parse_offset(offset_p);
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
-    if (offset == -1) {
+    if (res != 0) {
         return (NULL);
     }
 
-    return (unpack_dict(info_p, names_p, data_p, offset, allow_truncated_p));
+    return (unpack_from(self_p->info_p, values[0], values[1], values[2]));
 }
 
-static PyObject *pack_into_dict(struct info_t *info_p,
-                                PyObject *names_p,
-                                PyObject *buf_p,
-                                PyObject *offset_p,
-                                PyObject *data_p)
+static PyObject *m_compiled_format_pack_many(struct compiled_format_t *self_p,
+                                             PyObject *args_p,
+                                             PyObject *kwargs_p)
 {
-    struct bitstream_writer_t writer;
-    struct bitstream_writer_bounds_t bounds;
+    PyObject *records_p;
+    PyObject *stride_p;
     int res;
+    static char *keywords[] = {
+        "records",
+        "stride",
+        NULL
+    };
 
-    res = pack_into_prepare(info_p, buf_p, offset_p, &writer, &bounds);
+    stride_p = Py_None;
+    res = PyArg_ParseTupleAndKeywords(args_p,
+                                      kwargs_p,
+                                      "O|O",
+                                      &keywords[0],
+                                      &records_p,
+                                      &stride_p);
 
-    if (res != 0) {
+    if (res == 0) {
         return (NULL);
     }
 
-    pack_dict_pack(info_p, names_p, data_p, &writer);
-
-    return (pack_into_finalize(&bounds));
+    return (pack_many(self_p->info_p, NULL, records_p, stride_p));
 }
 
-PyDoc_STRVAR(pack_into_dict___doc__,
-             "pack_into_dict(fmt, names, buf, offset, data, **kwargs)\n"
-             "--\n"
-             "\n");
-
-static PyObject *m_pack_into_dict(PyObject *module_p,
-                                  PyObject *args_p,
-                                  PyObject *kwargs_p)
+static PyObject *m_compiled_format_pack_many_into(struct compiled_format_t *self_p,
+                                                  PyObject *args_p,
+                                                  PyObject *kwargs_p)
 {
-    PyObject *format_p;
-    PyObject *names_p;
     PyObject *buf_p;
     PyObject *offset_p;
-    PyObject *data_p;
-    PyObject *res_p;
-    struct info_t *info_p;
+    PyObject *records_p;
+    PyObject *stride_p;
+    int fill_padding;
     int res;
     static char *keywords[] = {
-        "fmt",
-        "names",
         "buf",
         "offset",
-        "data",
+        "records",
+        "stride",
+        "fill_padding",
         NULL
     };
 
-    offset_p = py_zero_p;
+    stride_p = Py_None;
+    fill_padding = 1;
     res = PyArg_ParseTupleAndKeywords(args_p,
                                       kwargs_p,
-                                      "OOOOO",
+                                      "OOO|Op",
                                       &keywords[0],
-                                      &format_p,
-                                      &names_p,
                                       &buf_p,
                                       &offset_p,
-                                      &data_p);
+                                      &records_p,
+                                      &stride_p,
+                                      &fill_padding);
 
     if (res == 0) {
         return (NULL);
     }
 
-    info_p = parse_format(format_p);
+    return (pack_many_into(self_p->info_p,
+                           NULL,
+                           buf_p,
+                           offset_p,
+                           records_p,
+                           stride_p,
+                           fill_padding));
+}
 
-    if (info_p == NULL) {
-        return (NULL);
-    }
+static PyObject *m_compiled_format_unpack_many(struct compiled_format_t *self_p,
+                                               PyObject *args_p,
+                                               PyObject *kwargs_p)
+{
+    PyObject *data_p;
+    PyObject *count_p;
+    PyObject *stride_p;
+    PyObject *offset_p;
+    int res;
+    static char *keywords[] = {
+        "data",
+        "count",
+        "stride",
+        "offset",
+        NULL
+    };
 
-    if (!is_names_list(names_p)) {
+    count_p = Py_None;
+    stride_p = Py_None;
+    offset_p = py_zero_p;
+    res = PyArg_ParseTupleAndKeywords(args_p,
+                                      kwargs_p,
+                                      "O|OOO",
+                                      &keywords[0],
+                                      &data_p,
+                                      &count_p,
+                                      &stride_p,
+                                      &offset_p);
+
+    if (res == 0) {
         return (NULL);
     }
 
-    res_p = pack_into_dict(info_p, names_p, buf_p, offset_p, data_p);
-    PyMem_RawFree(info_p);
-
-    return (res_p);
+    return (unpack_many(self_p->info_p,
+                        NULL,
+                        data_p,
+                        count_p,
+                        stride_p,
+                        offset_p));
 }
 
-PyDoc_STRVAR(unpack_from_dict___doc__,
-             "unpack_from_dict(fmt, names, data, offset=0, allow_truncated=False)\n"
-             "--\n"
-             "\n");
-
-static PyObject *m_unpack_from_dict(PyObject *module_p,
-                                    PyObject *args_p,
-                                    PyObject *kwargs_p)
+static PyObject *m_compiled_format_unpack_columns(struct compiled_format_t *self_p,
+                                                  PyObject *args_p,
+                                                  PyObject *kwargs_p)
 {
-    PyObject *format_p;
-    PyObject *names_p;
     PyObject *data_p;
+    PyObject *count_p;
+    PyObject *stride_p;
     PyObject *offset_p;
-    PyObject *allow_truncated_p;
-    PyObject *unpacked_p;
-    struct info_t *info_p;
     int res;
     static char *keywords[] = {
-        "fmt",
-        "names",
         "data",
+        "count",
+        "stride",
         "offset",
-        "allow_truncated",
         NULL
     };
 
+    count_p = Py_None;
+    stride_p = Py_None;
     offset_p = py_zero_p;
-    allow_truncated_p = py_zero_p;
     res = PyArg_ParseTupleAndKeywords(args_p,
                                       kwargs_p,
-                                      "OOO|OO",
+                                      "O|OOO",
                                       &keywords[0],
-                                      &format_p,
-                                      &names_p,
                                       &data_p,
-                                      &offset_p,
-                                      &allow_truncated_p);
+                                      &count_p,
+                                      &stride_p,
+                                      &offset_p);
 
     if (res == 0) {
         return (NULL);
     }
 
-    info_p = parse_format(format_p);
+    return (unpack_columns(self_p->info_p,
+                           NULL,
+                           data_p,
+                           count_p,
+                           stride_p,
+                           offset_p));
+}
 
-    if (info_p == NULL) {
+static PyObject *m_compiled_format_pack_columns(struct compiled_format_t *self_p,
+                                                PyObject *args_p,
+                                                PyObject *kwargs_p)
+{
+    PyObject *no_args_p;
+    PyObject *stride_p;
+    int res;
+    static char *keywords[] = {
+        "stride",
+        NULL
+    };
+
+    stride_p = Py_None;
+
+    if (kwargs_p != NULL) {
+        no_args_p = PyTuple_New(0);
+
+        if (no_args_p == NULL) {
+            return (NULL);
+        }
+
+        res = PyArg_ParseTupleAndKeywords(no_args_p,
+                                          kwargs_p,
+                                          "|$O",
+                                          &keywords[0],
+                                          &stride_p);
+        Py_DECREF(no_args_p);
+
+        if (res == 0) {
+            return (NULL);
+        }
+    }
+
+    return (pack_columns(self_p->info_p, args_p, stride_p));
+}
+
+static PyObject *m_compiled_format_calcsize(struct compiled_format_t *self_p)
+{
+    return (calcsize(self_p->info_p));
+}
+
+static PyObject *m_compiled_format_set_prefix_code(
+    struct compiled_format_t *self_p,
+    PyObject *codes_p)
+{
+    if (set_prefix_code(self_p->info_p, &self_p->prefix_code_p, codes_p) != 0) {
         return (NULL);
     }
 
-    if (!is_names_list(names_p)) {
+    Py_RETURN_NONE;
+}
+
+static PyObject *m_compiled_format_unpack_symbols(
+    struct compiled_format_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p)
+{
+    return (unpack_symbols(PREFIX_CODE_LOAD(&self_p->prefix_code_p),
+                           args_pp,
+                           number_of_args,
+                           kwnames_p));
+}
+
+static PyObject *m_compiled_format_copy(struct compiled_format_t *self_p)
+{
+    struct compiled_format_t *new_p;
+    size_t info_size;
+
+    new_p = (struct compiled_format_t *)compiled_format_new(
+        &compiled_format_type,
+        NULL,
+        NULL);
+
+    if (new_p == NULL) {
         return (NULL);
     }
 
-    unpacked_p = unpack_from_dict(info_p, names_p, data_p, offset_p, allow_truncated_p);
-    PyMem_RawFree(info_p);
+    info_size = sizeof(*self_p->info_p);
+    info_size += (sizeof(self_p->info_p->fields[0])
+                  * (self_p->info_p->number_of_fields - 1));
+
+    new_p->info_p = PyMem_RawMalloc(info_size);
 
-    return (unpacked_p);
+    if (new_p->info_p == NULL) {
+        /* ToDo: Free new_p. */
+        return (NULL);
+    }
+
+    memcpy(new_p->info_p, self_p->info_p, info_size);
+    Py_INCREF(self_p->format_p);
+    new_p->format_p = self_p->format_p;
+
+    if (copy_prefix_code(new_p->info_p,
+                         &new_p->prefix_code_p,
+                         PREFIX_CODE_LOAD(&self_p->prefix_code_p)) != 0) {
+        Py_DECREF(new_p);
+
+        return (NULL);
+    }
+
+    return ((PyObject *)new_p);
 }
 
-static PyObject *calcsize(struct info_t *info_p)
+static PyObject *m_compiled_format_deepcopy(struct compiled_format_t *self_p,
+                                            PyObject *args_p)
 {
-    return (PyLong_FromLong(info_p->number_of_bits));
+    return (m_compiled_format_copy(self_p));
 }
 
-static PyObject *m_calcsize(PyObject *module_p, PyObject *format_p)
+static PyObject *m_compiled_format_getstate(struct compiled_format_t *self_p,
+                                            PyObject *args_p)
 {
-    PyObject *size_p;
-    struct info_t *info_p;
+    return (getstate_prefix_code(Py_BuildValue("{sOsNsi}",
+                                               "format",
+                                               self_p->format_p,
+                                               "raw_as_memoryview",
+                                               PyBool_FromLong(
+                                                   self_p->info_p->raw_as_memoryview),
+                                               pickle_version_key,
+                                               pickle_version),
+                                 PREFIX_CODE_LOAD(&self_p->prefix_code_p)));
+}
 
-    info_p = parse_format(format_p);
+static PyObject *m_compiled_format_setstate(struct compiled_format_t *self_p,
+                                            PyObject *state_p)
+{
+    PyObject *version_p;
+    int version;
+    PyObject *format_p;
+
+    if (!PyDict_CheckExact(state_p)) {
+        PyErr_SetString(PyExc_ValueError, "Pickled object is not a dict.");
+
+        return (NULL);
+    }
+
+    version_p = PyDict_GetItemString(state_p, pickle_version_key);
+
+    if (version_p == NULL) {
+        PyErr_Format(PyExc_KeyError,
+                     "No \"%s\" in pickled dict.",
+                     pickle_version_key);
+
+        return (NULL);
+    }
+
+    version = (int)PyLong_AsLong(version_p);
+
+    if (version != pickle_version) {
+        PyErr_Format(PyExc_ValueError,
+                     "Pickle version mismatch. Got version %d but expected version %d.",
+                     version, pickle_version);
+
+        return (NULL);
+    }
+
+    format_p = PyDict_GetItemString(state_p, "format");
+
+    if (format_p == NULL) {
+        PyErr_SetString(PyExc_KeyError, "No \"format\" in pickled dict.");
+
+        return (NULL);
+    }
+
+    if (compiled_format_init_inner(self_p, format_p) != 0) {
+        return (NULL);
+    }
+
+    if (setstate_raw_as_memoryview(self_p->info_p, state_p) != 0) {
+        return (NULL);
+    }
+
+    return (setstate_prefix_code(self_p->info_p,
+                                 &self_p->prefix_code_p,
+                                 state_p));
+}
+
+static PyObject *compiled_format_dict_create(PyTypeObject *type_p,
+                                             PyObject *format_p,
+                                             PyObject *names_p,
+                                             PyObject *raw_as_memoryview_p)
+{
+    PyObject *self_p;
+
+    self_p = compiled_format_dict_new(type_p, NULL, NULL);
+
+    if (self_p == NULL) {
+        return (NULL);
+    }
 
-    if (info_p == NULL) {
+    if (compiled_format_dict_init_inner((struct compiled_format_dict_t *)self_p,
+                                        format_p,
+                                        names_p) != 0) {
         return (NULL);
     }
 
-    size_p = calcsize(info_p);
-    PyMem_RawFree(info_p);
+    if (set_raw_as_memoryview(((struct compiled_format_dict_t *)self_p)->info_p,
+                              raw_as_memoryview_p) != 0) {
+        Py_DECREF(self_p);
 
-    return (size_p);
+        return (NULL);
+    }
+
+    return (self_p);
 }
 
-PyDoc_STRVAR(byteswap___doc__,
-             "byteswap(fmt, data, offset=0)\n"
-             "--\n"
-             "\n");
+static PyObject *compiled_format_dict_new(PyTypeObject *type_p,
+                                          PyObject *args_p,
+                                          PyObject *kwargs_p)
+{
+    return (type_p->tp_alloc(type_p, 0));
+}
 
-static PyObject *m_byteswap(PyObject *module_p,
-                            PyObject *args_p,
-                            PyObject *kwargs_p)
+static int compiled_format_dict_init(struct compiled_format_dict_t *self_p,
+                                     PyObject *args_p,
+                                     PyObject *kwargs_p)
 {
-    PyObject *format_p;
-    PyObject *data_p;
-    PyObject *swapped_p;
-    const char *c_format_p;
-    uint8_t *src_p;
-    uint8_t *dst_p;
-    Py_ssize_t size;
     int res;
-    int offset;
-
+    PyObject *format_p;
+    PyObject *names_p;
+    PyObject *raw_as_memoryview_p;
     static char *keywords[] = {
         "fmt",
-        "data",
+        "names",
+        "raw_as_memoryview",
         NULL
     };
 
+    raw_as_memoryview_p = Py_False;
     res = PyArg_ParseTupleAndKeywords(args_p,
                                       kwargs_p,
-                                      "OO",
+                                      "OO|O",
                                       &keywords[0],
                                       &format_p,
-                                      &data_p);
+                                      &names_p,
+                                      &raw_as_memoryview_p);
 
     if (res == 0) {
-        return (NULL);
+        return (-1);
     }
 
-    c_format_p = PyUnicode_AsUTF8(format_p);
-
-    if (c_format_p == NULL) {
-        return (NULL);
+    if (compiled_format_dict_init_inner(self_p, format_p, names_p) != 0) {
+        return (-1);
     }
 
-    res = PyBytes_AsStringAndSize(data_p, (char **)&src_p, &size);
+    return (set_raw_as_memoryview(self_p->info_p, raw_as_memoryview_p));
+}
 
-    if (res == -1) {
-        return (NULL);
+static int compiled_format_dict_init_inner(struct compiled_format_dict_t *self_p,
+                                           PyObject *format_p,
+                                           PyObject *names_p)
+{
+    if (!is_names_list(names_p)) {
+        return (-1);
     }
 
-    swapped_p = PyBytes_FromStringAndSize(NULL, size);
+    self_p->info_p = parse_format(format_p);
 
-    if (swapped_p == NULL) {
-        return (NULL);
-    }
+    if (self_p->info_p == NULL) {
+        PyObject_Free(self_p);
 
-    dst_p = (uint8_t *)PyBytes_AS_STRING(swapped_p);
-    offset = 0;
+        return (-1);
+    }
 
-    while (*c_format_p != '\0') {
-        switch (*c_format_p) {
+    Py_INCREF(format_p);
+    self_p->format_p = format_p;
+    Py_INCREF(names_p);
+    self_p->names_p = names_p;
 
-        case '1':
-            if ((size - offset) < 1) {
-                goto out1;
-            }
+    return (0);
+}
 
-            dst_p[offset] = src_p[offset];
-            offset += 1;
-            break;
+static void compiled_format_dict_dealloc(struct compiled_format_dict_t *self_p)
+{
+    prefix_code_free(self_p->prefix_code_p);
+    PyMem_RawFree(self_p->info_p);
+    Py_DECREF(self_p->names_p);
+    Py_DECREF(self_p->format_p);
+    Py_TYPE(self_p)->tp_free((PyObject *)self_p);
+}
 
-        case '2':
-            if ((size - offset) < 2) {
-                goto out1;
-            }
+static PyObject *m_compiled_format_dict_pack(struct compiled_format_dict_t *self_p,
+                                             PyObject *data_p)
+{
+    return (pack_dict(self_p->info_p, self_p->names_p, data_p));
+}
 
-            dst_p[offset + 0] = src_p[offset + 1];
-            dst_p[offset + 1] = src_p[offset + 0];
-            offset += 2;
-            break;
+static PyObject *m_compiled_format_dict_unpack(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p)
+{
+    int res;
+    static const char *const keywords[] = {
+        "data",
+        "allow_truncated",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        py_zero_p
+    };
 
-        case '4':
-            if ((size - offset) < 4) {
-                goto out1;
-            }
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
-            dst_p[offset + 0] = src_p[offset + 3];
-            dst_p[offset + 1] = src_p[offset + 2];
-            dst_p[offset + 2] = src_p[offset + 1];
-            dst_p[offset + 3] = src_p[offset + 0];
-            offset += 4;
-            break;
+    if (res != 0) {
+        return (NULL);
+    }
 
-        case '8':
-            if ((size - offset) < 8) {
-                goto out1;
-            }
+    return (unpack_dict(self_p->info_p, self_p->names_p, values[0], 0, values[1]));
+}
 
-            dst_p[offset + 0] = src_p[offset + 7];
-            dst_p[offset + 1] = src_p[offset + 6];
-            dst_p[offset + 2] = src_p[offset + 5];
-            dst_p[offset + 3] = src_p[offset + 4];
-            dst_p[offset + 4] = src_p[offset + 3];
-            dst_p[offset + 5] = src_p[offset + 2];
-            dst_p[offset + 6] = src_p[offset + 1];
-            dst_p[offset + 7] = src_p[offset + 0];
-            offset += 8;
-            break;
+static PyObject *m_compiled_format_dict_pack_into(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p)
+{
+    int res;
+    static const char *const keywords[] = {
+        "buf",
+        "offset",
+        "data",
+        "fill_padding",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL,
+        Py_True
+    };
 
-        default:
-            PyErr_Format(PyExc_ValueError,
-                         "Expected 1, 2, 4 or 8, but got %c.",
-                         (char)*c_format_p);
-            goto out2;
-        }
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
-        c_format_p++;
+    if (res != 0) {
+        return (NULL);
     }
 
-    return (swapped_p);
-
- out1:
-    PyErr_SetString(PyExc_ValueError, "Out of data to swap.");
-
- out2:
-
-    return (NULL);
+    return (pack_into_dict(self_p->info_p,
+                           self_p->names_p,
+                           values[0],
+                           values[1],
+                           values[2],
+                           values[3]));
 }
 
-static PyObject *compiled_format_create(PyTypeObject *type_p,
-                                        PyObject *format_p)
+static PyObject *m_compiled_format_dict_unpack_from(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p)
 {
-    PyObject *self_p;
-
-    self_p = compiled_format_new(type_p, NULL, NULL);
+    int res;
+    static const char *const keywords[] = {
+        "data",
+        "offset",
+        "allow_truncated",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        py_zero_p,
+        py_zero_p
+    };
 
-    if (self_p == NULL) {
-        return (NULL);
-    }
+    res = parse_args(args_pp, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
-    if (compiled_format_init_inner((struct compiled_format_t *)self_p,
-                                   format_p) != 0) {
+    if (res != 0) {
         return (NULL);
     }
 
-    return (self_p);
+    return (unpack_from_dict(self_p->info_p,
+                             self_p->names_p,
+                             values[0],
+                             values[1],
+                             values[2]));
 }
 
-static PyObject *compiled_format_new(PyTypeObject *type_p,
-                                     PyObject *args_p,
-                                     PyObject *kwargs_p)
+static PyObject *m_compiled_format_dict_pack_many(
+    struct compiled_format_dict_t *self_p,
+    PyObject *args_p,
+    PyObject *kwargs_p)
 {
-    return (type_p->tp_alloc(type_p, 0));
+    PyObject *records_p;
+    PyObject *stride_p;
+    int res;
+    static char *keywords[] = {
+        "records",
+        "stride",
+        NULL
+    };
+
+    stride_p = Py_None;
+    res = PyArg_ParseTupleAndKeywords(args_p,
+                                      kwargs_p,
+                                      "O|O",
+                                      &keywords[0],
+                                      &records_p,
+                                      &stride_p);
+
+    if (res == 0) {
+        return (NULL);
+    }
+
+    return (pack_many(self_p->info_p, self_p->names_p, records_p, stride_p));
 }
 
-static int compiled_format_init(struct compiled_format_t *self_p,
-                                PyObject *args_p,
-                                PyObject *kwargs_p)
+static PyObject *m_compiled_format_dict_pack_many_into(
+    struct compiled_format_dict_t *self_p,
+    PyObject *args_p,
+    PyObject *kwargs_p)
 {
+    PyObject *buf_p;
+    PyObject *offset_p;
+    PyObject *records_p;
+    PyObject *stride_p;
+    int fill_padding;
     int res;
-    PyObject *format_p;
-
     static char *keywords[] = {
-        "fmt",
+        "buf",
+        "offset",
+        "records",
+        "stride",
+        "fill_padding",
         NULL
     };
 
+    stride_p = Py_None;
+    fill_padding = 1;
     res = PyArg_ParseTupleAndKeywords(args_p,
                                       kwargs_p,
-                                      "O",
+                                      "OOO|Op",
                                       &keywords[0],
-                                      &format_p);
+                                      &buf_p,
+                                      &offset_p,
+                                      &records_p,
+                                      &stride_p,
+                                      &fill_padding);
 
     if (res == 0) {
-        return (-1);
+        return (NULL);
     }
 
-    return (compiled_format_init_inner(self_p, format_p));
+    return (pack_many_into(self_p->info_p,
+                           self_p->names_p,
+                           buf_p,
+                           offset_p,
+                           records_p,
+                           stride_p,
+                           fill_padding));
 }
 
-static int compiled_format_init_inner(struct compiled_format_t *self_p,
-                                      PyObject *format_p)
+static PyObject *m_compiled_format_dict_unpack_many(
+    struct compiled_format_dict_t *self_p,
+    PyObject *args_p,
+    PyObject *kwargs_p)
 {
-    self_p->info_p = parse_format(format_p);
+    PyObject *data_p;
+    PyObject *count_p;
+    PyObject *stride_p;
+    PyObject *offset_p;
+    int res;
+    static char *keywords[] = {
+        "data",
+        "count",
+        "stride",
+        "offset",
+        NULL
+    };
 
-    if (self_p->info_p == NULL) {
-        PyObject_Free(self_p);
+    count_p = Py_None;
+    stride_p = Py_None;
+    offset_p = py_zero_p;
+    res = PyArg_ParseTupleAndKeywords(args_p,
+                                      kwargs_p,
+                                      "O|OOO",
+                                      &keywords[0],
+                                      &data_p,
+                                      &count_p,
+                                      &stride_p,
+                                      &offset_p);
 
-        return (-1);
+    if (res == 0) {
+        return (NULL);
     }
 
-    Py_INCREF(format_p);
-    self_p->format_p = format_p;
-
-    return (0);
+    return (unpack_many(self_p->info_p,
+                        self_p->names_p,
+                        data_p,
+                        count_p,
+                        stride_p,
+                        offset_p));
 }
 
-static void compiled_format_dealloc(struct compiled_format_t *self_p)
+static PyObject *m_compiled_format_dict_unpack_columns(
+    struct compiled_format_dict_t *self_p,
+    PyObject *args_p,
+    PyObject *kwargs_p)
 {
-    PyMem_RawFree(self_p->info_p);
-    Py_DECREF(self_p->format_p);
-    Py_TYPE(self_p)->tp_free((PyObject *)self_p);
-}
+    PyObject *data_p;
+    PyObject *count_p;
+    PyObject *stride_p;
+    PyObject *offset_p;
+    int res;
+    static char *keywords[] = {
+        "data",
+        "count",
+        "stride",
+        "offset",
+        NULL
+    };
+
+    count_p = Py_None;
+    stride_p = Py_None;
+    offset_p = py_zero_p;
+    res = PyArg_ParseTupleAndKeywords(args_p,
+                                      kwargs_p,
+                                      "O|OOO",
+                                      &keywords[0],
+                                      &data_p,
+                                      &count_p,
+                                      &stride_p,
+                                      &offset_p);
+
+    if (res == 0) {
+        return (NULL);
+    }
 
-static PyObject *m_compiled_format_pack(struct compiled_format_t *self_p,
-                                        PyObject *args_p)
-{
-    return (pack(self_p->info_p, args_p, 0, PyTuple_GET_SIZE(args_p)));
+    return (unpack_columns(self_p->info_p,
+                           self_p->names_p,
+                           data_p,
+                           count_p,
+                           stride_p,
+                           offset_p));
 }
 
-static PyObject *m_compiled_format_unpack(struct compiled_format_t *self_p,
-                                          PyObject *args_p,
-                                          PyObject *kwargs_p)
+static PyObject *m_compiled_format_dict_pack_columns(
+    struct compiled_format_dict_t *self_p,
+    PyObject *args_p,
+    PyObject *kwargs_p)
 {
-    PyObject *data_p;
-    PyObject *allow_truncated_p;
+    PyObject *columns_p;
+    PyObject *stride_p;
+    PyObject *ordered_columns_p;
+    PyObject *column_p;
+    PyObject *packed_p;
+    int i;
     int res;
     static char *keywords[] = {
-        "data",
-        "allow_truncated",
+        "columns",
+        "stride",
         NULL
     };
 
-    allow_truncated_p = py_zero_p;
+    stride_p = Py_None;
     res = PyArg_ParseTupleAndKeywords(args_p,
                                       kwargs_p,
                                       "O|O",
                                       &keywords[0],
-                                      &data_p,
-                                      &allow_truncated_p);
+                                      &columns_p,
+                                      &stride_p);
 
     if (res == 0) {
         return (NULL);
     }
 
-    return (unpack(self_p->info_p, data_p, 0, allow_truncated_p));
-}
+    if (!PyDict_Check(columns_p)) {
+        PyErr_SetString(PyExc_TypeError, "Columns is not a dict.");
 
-static PyObject *m_compiled_format_pack_into(struct compiled_format_t *self_p,
-                                             PyObject *args_p,
-                                             PyObject *kwargs_p)
-{
-    PyObject *buf_p;
-    PyObject *offset_p;
-    Py_ssize_t number_of_args;
+        return (NULL);
+    }
 
-    number_of_args = PyTuple_GET_SIZE(args_p);
+    if (PyList_GET_SIZE(self_p->names_p)
+        < self_p->info_p->number_of_non_padding_fields) {
+        PyErr_SetString(PyExc_ValueError, "Too few names.");
 
-    if (number_of_args < 2) {
-        PyErr_SetString(PyExc_ValueError, "Too few arguments.");
+        return (NULL);
+    }
 
+    ordered_columns_p = PyTuple_New(self_p->info_p->number_of_non_padding_fields);
+
+    if (ordered_columns_p == NULL) {
         return (NULL);
     }
 
-    buf_p = PyTuple_GET_ITEM(args_p, 0);
-    offset_p = PyTuple_GET_ITEM(args_p, 1);
+    for (i = 0; i < self_p->info_p->number_of_non_padding_fields; i++) {
+        column_p = PyDict_GetItem(columns_p,
+                                  PyList_GET_ITEM(self_p->names_p, i));
 
-    return (pack_into(self_p->info_p,
-                      buf_p,
-                      offset_p,
-                      args_p,
-                      2,
-                      number_of_args));
+        if (column_p == NULL) {
+            PyErr_SetString(PyExc_KeyError, "Missing value.");
+            Py_DECREF(ordered_columns_p);
+
+            return (NULL);
+        }
+
+        Py_INCREF(column_p);
+        PyTuple_SET_ITEM(ordered_columns_p, i, column_p);
+    }
+
+    packed_p = pack_columns(self_p->info_p, ordered_columns_p, stride_p);
+    Py_DECREF(ordered_columns_p);
+
+    return (packed_p);
 }
 
-static PyObject *m_compiled_format_unpack_from(struct compiled_format_t *self_p,
-                                               PyObject *args_p,
-                                               PyObject *kwargs_p)
+static PyObject *m_compiled_format_dict_calcsize(
+    struct compiled_format_dict_t *self_p)
 {
-    PyObject *data_p;
-    PyObject *offset_p;
-    PyObject *allow_truncated_p;
-    int res;
-    static char *keywords[] = {
-        "data",
-        "offset",
-        "allow_truncated",
-        NULL
-    };
-
-    offset_p = py_zero_p;
-    allow_truncated_p = py_zero_p;
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "O|OO",
-                                      &keywords[0],
-                                      &data_p,
-                                      &offset_p,
-                                      &allow_truncated_p);
+    return (calcsize(self_p->info_p));
+}
 
-    if (res == 0) {
+static PyObject *m_compiled_format_dict_set_prefix_code(
+    struct compiled_format_dict_t *self_p,
+    PyObject *codes_p)
+{
+    if (set_prefix_code(self_p->info_p, &self_p->prefix_code_p, codes_p) != 0) {
         return (NULL);
     }
 
-    return (unpack_from(self_p->info_p, data_p, offset_p, allow_truncated_p));
+    Py_RETURN_NONE;
 }
 
-static PyObject *m_compiled_format_calcsize(struct compiled_format_t *self_p)
+static PyObject *m_compiled_format_dict_unpack_symbols(
+    struct compiled_format_dict_t *self_p,
+    PyObject *const *args_pp,
+    Py_ssize_t number_of_args,
+    PyObject *kwnames_p)
 {
-    return (calcsize(self_p->info_p));
+    return (unpack_symbols(PREFIX_CODE_LOAD(&self_p->prefix_code_p),
+                           args_pp,
+                           number_of_args,
+                           kwnames_p));
 }
 
-static PyObject *m_compiled_format_copy(struct compiled_format_t *self_p)
+static PyObject *m_compiled_format_dict_copy(struct compiled_format_dict_t *self_p)
 {
-    struct compiled_format_t *new_p;
+    struct compiled_format_dict_t *new_p;
     size_t info_size;
 
-    new_p = (struct compiled_format_t *)compiled_format_new(
-        &compiled_format_type,
+    new_p = (struct compiled_format_dict_t *)compiled_format_dict_new(
+        &compiled_format_dict_type,
         NULL,
         NULL);
 
@@ -2091,330 +6752,555 @@ static PyObject *m_compiled_format_copy(struct compiled_format_t *self_p)
     }
 
     memcpy(new_p->info_p, self_p->info_p, info_size);
+    Py_INCREF(self_p->names_p);
+    new_p->names_p = self_p->names_p;
     Py_INCREF(self_p->format_p);
     new_p->format_p = self_p->format_p;
 
+    if (copy_prefix_code(new_p->info_p,
+                         &new_p->prefix_code_p,
+                         PREFIX_CODE_LOAD(&self_p->prefix_code_p)) != 0) {
+        Py_DECREF(new_p);
+
+        return (NULL);
+    }
+
     return ((PyObject *)new_p);
 }
 
-static PyObject *m_compiled_format_deepcopy(struct compiled_format_t *self_p,
-                                            PyObject *args_p)
+static PyObject *m_compiled_format_dict_deepcopy(struct compiled_format_dict_t *self_p,
+                                                 PyObject *args_p)
 {
-    return (m_compiled_format_copy(self_p));
+    return (m_compiled_format_dict_copy(self_p));
 }
 
-static PyObject *m_compiled_format_getstate(struct compiled_format_t *self_p,
-                                            PyObject *args_p)
+/* Array type code for integers of given width. */
+static char array_type_code(int number_of_bits, int is_signed)
 {
-    return (Py_BuildValue("{sOsi}",
-                          "format",
-                          self_p->format_p,
-                          pickle_version_key,
-                          pickle_version));
+    char type_code;
+
+    if (number_of_bits <= 16) {
+        type_code = 'h';
+    } else if (number_of_bits <= 32) {
+        type_code = 'i';
+    } else {
+        type_code = 'q';
+    }
+
+    if (!is_signed) {
+        type_code = (char)Py_TOUPPER(type_code);
+    }
+
+    return (type_code);
 }
 
-static PyObject *m_compiled_format_setstate(struct compiled_format_t *self_p,
-                                            PyObject *state_p)
+static int parse_array_width(PyObject *width_p)
 {
-    PyObject *version_p;
-    int version;
-    PyObject *format_p;
+    long width;
 
-    if (!PyDict_CheckExact(state_p)) {
-        PyErr_SetString(PyExc_ValueError, "Pickled object is not a dict.");
+    width = PyLong_AsLong(width_p);
+
+    if ((width == -1) && PyErr_Occurred()) {
+        return (-1);
+    }
+
+    if ((width < 1) || (width > 64)) {
+        PyErr_SetString(PyExc_ValueError, "Width must be 1 to 64 bits.");
+
+        return (-1);
+    }
+
+    return ((int)width);
+}
+
+PyDoc_STRVAR(unpack_array___doc__,
+             "unpack_array(width, signed, data, count, offset=0)\n"
+             "--\n"
+             "\n"
+             "Unpack count integers of given width in bits from data as\n"
+             "an array.array of 16, 32 or 64 bits integers.");
+
+static PyObject *m_unpack_array(PyObject *module_p,
+                                PyObject *const *args_p,
+                                Py_ssize_t number_of_args,
+                                PyObject *kwnames_p)
+{
+    struct bitstream_reader_t reader;
+    Py_buffer view;
+    Py_buffer array_view;
+    PyObject *array_p;
+    Py_ssize_t count;
+    long long offset;
+    int width;
+    int is_signed;
+    int res;
+    static const char *const keywords[] = {
+        "width",
+        "signed",
+        "data",
+        "count",
+        "offset",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        py_zero_p
+    };
+
+    res = parse_args(args_p, number_of_args, kwnames_p, &keywords[0], &values[0]);
 
+    if (res != 0) {
         return (NULL);
     }
 
-    version_p = PyDict_GetItemString(state_p, pickle_version_key);
+    width = parse_array_width(values[0]);
 
-    if (version_p == NULL) {
-        PyErr_Format(PyExc_KeyError,
-                     "No \"%s\" in pickled dict.",
-                     pickle_version_key);
+    if (width == -1) {
+        return (NULL);
+    }
 
+    is_signed = PyObject_IsTrue(values[1]);
+
+    if (is_signed == -1) {
         return (NULL);
     }
 
-    version = (int)PyLong_AsLong(version_p);
+    count = PyLong_AsSsize_t(values[3]);
 
-    if (version != pickle_version) {
-        PyErr_Format(PyExc_ValueError,
-                     "Pickle version mismatch. Got version %d but expected version %d.",
-                     version, pickle_version);
+    if ((count == -1) && PyErr_Occurred()) {
+        return (NULL);
+    }
+
+    if (count < 0) {
+        PyErr_SetString(PyExc_ValueError, "Negative count.");
+
+        return (NULL);
+    }
+
+    offset = parse_offset(values[4]);
+
+    if (offset == -1) {
+        return (NULL);
+    }
+
+    res = PyObject_GetBuffer(values[2], &view, PyBUF_C_CONTIGUOUS);
+
+    if (res == -1) {
+        return (NULL);
+    }
+
+    array_p = NULL;
+    bitstream_reader_init_window(&reader, (uint8_t *)view.buf, view.len);
+
+    if ((bitstream_reader_seek_checked(&reader, offset) != 0)
+        || (bitstream_reader_remaining_bits(&reader) / width < count)) {
+        PyErr_SetString(PyExc_ValueError, "Short data.");
+        goto out1;
+    }
+
+    array_p = column_new(array_type_code(width, is_signed), count);
+
+    if (array_p == NULL) {
+        goto out1;
+    }
+
+    res = PyObject_GetBuffer(array_p, &array_view, PyBUF_WRITABLE);
+
+    if (res == -1) {
+        goto out2;
+    }
+
+    bitstream_reader_read_array_bits(&reader,
+                                     array_view.buf,
+                                     (int)array_view.itemsize,
+                                     width,
+                                     is_signed,
+                                     count);
+    PyBuffer_Release(&array_view);
+
+    goto out1;
+
+ out2:
+    Py_DECREF(array_p);
+    array_p = NULL;
+
+ out1:
+    PyBuffer_Release(&view);
+
+    return (array_p);
+}
+
+PyDoc_STRVAR(pack_array___doc__,
+             "pack_array(width, signed, array)\n"
+             "--\n"
+             "\n"
+             "Pack all integers in given buffer, for example an\n"
+             "array.array, as fields of given width in bits.");
+
+static PyObject *m_pack_array(PyObject *module_p,
+                              PyObject *const *args_p,
+                              Py_ssize_t number_of_args,
+                              PyObject *kwnames_p)
+{
+    struct bitstream_writer_t writer;
+    struct column_t column;
+    PyObject *packed_p;
+    Py_ssize_t count;
+    int64_t index;
+    int width;
+    int is_signed;
+    int res;
+    static const char *const keywords[] = {
+        "width",
+        "signed",
+        "array",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL
+    };
+
+    res = parse_args(args_p, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    width = parse_array_width(values[0]);
+
+    if (width == -1) {
+        return (NULL);
+    }
+
+    is_signed = PyObject_IsTrue(values[1]);
+
+    if (is_signed == -1) {
+        return (NULL);
+    }
+
+    res = column_init(&column, values[2]);
+
+    if (res != 0) {
+        return (NULL);
+    }
+
+    packed_p = NULL;
+
+    if (column.kind == 'f') {
+        PyErr_SetString(PyExc_TypeError, "Integer column needed.");
+        goto out1;
+    }
+
+    count = (column.view.len / column.view.itemsize);
+
+    if (count > (PY_SSIZE_T_MAX - 7) / width) {
+        PyErr_NoMemory();
+        goto out1;
+    }
+
+    packed_p = PyBytes_FromStringAndSize(NULL, (width * count + 7) / 8);
+
+    if (packed_p == NULL) {
+        goto out1;
+    }
+
+    bitstream_writer_init_window(&writer,
+                                 (uint8_t *)PyBytes_AS_STRING(packed_p),
+                                 PyBytes_GET_SIZE(packed_p));
+    index = bitstream_writer_write_array_bits(&writer,
+                                              column.view.buf,
+                                              (int)column.view.itemsize,
+                                              column.kind == 'i',
+                                              width,
+                                              is_signed,
+                                              count);
+
+    if (index != -1) {
+        if (column.kind == 'i') {
+            PyErr_Format(PyExc_OverflowError,
+                         "%s integer value %lld out of range.",
+                         is_signed ? "Signed" : "Unsigned",
+                         (long long)column_get_signed(&column, index));
+        } else {
+            PyErr_Format(PyExc_OverflowError,
+                         "%s integer value %llu out of range.",
+                         is_signed ? "Signed" : "Unsigned",
+                         (unsigned long long)column_get_unsigned(&column,
+                                                                 index));
+        }
+
+        Py_DECREF(packed_p);
+        packed_p = NULL;
+    }
+
+ out1:
+    PyBuffer_Release(&column.view);
+
+    return (packed_p);
+}
+
+PyDoc_STRVAR(copy_bits___doc__,
+             "copy_bits(dst, dst_offset, src, src_offset, number_of_bits)\n"
+             "--\n"
+             "\n"
+             "Copy given number of bits from src at bit offset src_offset\n"
+             "to the writable buffer dst at bit offset dst_offset. Other\n"
+             "bits in dst are left unmodified.");
+
+static PyObject *m_copy_bits(PyObject *module_p,
+                             PyObject *const *args_p,
+                             Py_ssize_t number_of_args,
+                             PyObject *kwnames_p)
+{
+    Py_buffer dst_view;
+    Py_buffer src_view;
+    long long dst_offset;
+    long long src_offset;
+    long long number_of_bits;
+    const uint8_t *dst_begin_p;
+    const uint8_t *dst_end_p;
+    const uint8_t *src_begin_p;
+    const uint8_t *src_end_p;
+    PyObject *res_p;
+    int res;
+    static const char *const keywords[] = {
+        "dst",
+        "dst_offset",
+        "src",
+        "src_offset",
+        "number_of_bits",
+        NULL
+    };
+    PyObject *values[] = {
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL
+    };
 
+    res = parse_args(args_p, number_of_args, kwnames_p, &keywords[0], &values[0]);
+
+    if (res != 0) {
         return (NULL);
     }
 
-    format_p = PyDict_GetItemString(state_p, "format");
-
-    if (format_p == NULL) {
-        PyErr_SetString(PyExc_KeyError, "No \"format\" in pickled dict.");
+    dst_offset = parse_offset(values[1]);
 
+    if (dst_offset == -1) {
         return (NULL);
     }
 
-    if (compiled_format_init_inner(self_p, format_p) != 0) {
+    src_offset = parse_offset(values[3]);
+
+    if (src_offset == -1) {
         return (NULL);
     }
 
-    Py_RETURN_NONE;
-}
-
-static PyObject *compiled_format_dict_create(PyTypeObject *type_p,
-                                             PyObject *format_p,
-                                             PyObject *names_p)
-{
-    PyObject *self_p;
-
-    self_p = compiled_format_dict_new(type_p, NULL, NULL);
+    number_of_bits = PyLong_AsLongLong(values[4]);
 
-    if (self_p == NULL) {
+    if ((number_of_bits == -1) && PyErr_Occurred()) {
         return (NULL);
     }
 
-    if (compiled_format_dict_init_inner((struct compiled_format_dict_t *)self_p,
-                                        format_p,
-                                        names_p) != 0) {
+    if (number_of_bits < 0) {
+        PyErr_SetString(PyExc_ValueError, "Negative number of bits.");
+
         return (NULL);
     }
 
-    return (self_p);
-}
-
-static PyObject *compiled_format_dict_new(PyTypeObject *type_p,
-                                          PyObject *args_p,
-                                          PyObject *kwargs_p)
-{
-    return (type_p->tp_alloc(type_p, 0));
-}
+    res = PyObject_GetBuffer(values[0], &dst_view, PyBUF_WRITABLE);
 
-static int compiled_format_dict_init(struct compiled_format_dict_t *self_p,
-                                     PyObject *args_p,
-                                     PyObject *kwargs_p)
-{
-    int res;
-    PyObject *format_p;
-    PyObject *names_p;
-    static char *keywords[] = {
-        "fmt",
-        "names",
-        NULL
-    };
+    if (res == -1) {
+        return (NULL);
+    }
 
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "OO",
-                                      &keywords[0],
-                                      &format_p,
-                                      &names_p);
+    res_p = NULL;
+    res = PyObject_GetBuffer(values[2], &src_view, PyBUF_C_CONTIGUOUS);
 
-    if (res == 0) {
-        return (-1);
+    if (res == -1) {
+        goto out1;
     }
 
-    return (compiled_format_dict_init_inner(self_p, format_p, names_p));
-}
+    if (number_of_bits > 8LL * dst_view.len - dst_offset) {
+        PyErr_Format(PyExc_ValueError,
+                     "copy_bits requires a buffer of at least %lld bits",
+                     dst_offset + number_of_bits);
+        goto out2;
+    }
 
-static int compiled_format_dict_init_inner(struct compiled_format_dict_t *self_p,
-                                           PyObject *format_p,
-                                           PyObject *names_p)
-{
-    if (!is_names_list(names_p)) {
-        return (-1);
+    if (number_of_bits > 8LL * src_view.len - src_offset) {
+        PyErr_SetString(PyExc_ValueError, "Short data.");
+        goto out2;
     }
 
-    self_p->info_p = parse_format(format_p);
+    if (number_of_bits > 0) {
+        dst_begin_p = ((uint8_t *)dst_view.buf + dst_offset / 8);
+        dst_end_p = ((uint8_t *)dst_view.buf
+                     + (dst_offset + number_of_bits + 7) / 8);
+        src_begin_p = ((uint8_t *)src_view.buf + src_offset / 8);
+        src_end_p = ((uint8_t *)src_view.buf
+                     + (src_offset + number_of_bits + 7) / 8);
 
-    if (self_p->info_p == NULL) {
-        PyObject_Free(self_p);
+        if ((dst_begin_p < src_end_p) && (src_begin_p < dst_end_p)) {
+            PyErr_SetString(PyExc_ValueError, "Overlapping buffers.");
+            goto out2;
+        }
 
-        return (-1);
+        bitstream_copy_bits((uint8_t *)dst_view.buf,
+                            dst_offset,
+                            (uint8_t *)src_view.buf,
+                            src_offset,
+                            number_of_bits);
     }
 
-    Py_INCREF(format_p);
-    self_p->format_p = format_p;
-    Py_INCREF(names_p);
-    self_p->names_p = names_p;
+    res_p = Py_None;
+    Py_INCREF(res_p);
 
-    return (0);
-}
+ out2:
+    PyBuffer_Release(&src_view);
 
-static void compiled_format_dict_dealloc(struct compiled_format_dict_t *self_p)
-{
-    PyMem_RawFree(self_p->info_p);
-    Py_DECREF(self_p->names_p);
-    Py_DECREF(self_p->format_p);
-    Py_TYPE(self_p)->tp_free((PyObject *)self_p);
-}
+ out1:
+    PyBuffer_Release(&dst_view);
 
-static PyObject *m_compiled_format_dict_pack(struct compiled_format_dict_t *self_p,
-                                             PyObject *data_p)
-{
-    return (pack_dict(self_p->info_p, self_p->names_p, data_p));
+    return (res_p);
 }
 
-static PyObject *m_compiled_format_dict_unpack(
-    struct compiled_format_dict_t *self_p,
-    PyObject *args_p,
-    PyObject *kwargs_p)
+PyDoc_STRVAR(cache_info___doc__,
+             "cache_info()\n"
+             "--\n"
+             "\n"
+             "Return a tuple of hits, misses, maximum size and current size\n"
+             "of the format cache used by the module level functions.");
+
+static PyObject *m_cache_info(PyObject *module_p, PyObject *args_p)
 {
-    PyObject *data_p;
-    PyObject *allow_truncated_p;
-    int res;
-    static char *keywords[] = {
-        "data",
-        "allow_truncated",
-        NULL
-    };
+    return (format_cache_info());
+}
 
-    allow_truncated_p = py_zero_p;
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "O|O",
-                                      &keywords[0],
-                                      &data_p,
-                                      &allow_truncated_p);
+PyDoc_STRVAR(cache_clear___doc__,
+             "cache_clear()\n"
+             "--\n"
+             "\n"
+             "Clear the format cache and its statistics.");
 
-    if (res == 0) {
-        return (NULL);
-    }
+static PyObject *m_cache_clear(PyObject *module_p, PyObject *args_p)
+{
+    format_cache_clear();
 
-    return (unpack_dict(self_p->info_p, self_p->names_p, data_p, 0, allow_truncated_p));
+    Py_RETURN_NONE;
 }
 
-static PyObject *m_compiled_format_dict_pack_into(
-    struct compiled_format_dict_t *self_p,
-    PyObject *args_p,
-    PyObject *kwargs_p)
-{
-    PyObject *buf_p;
-    PyObject *data_p;
-    PyObject *offset_p;
-    int res;
-    static char *keywords[] = {
-        "buf",
-        "data",
-        "offset",
-        NULL
-    };
+/* Indexed by BITSTREAM_ISA_*. */
+static const char *const isa_names[] = {
+    "scalar",
+    "sse2",
+    "avx2",
+    "avx512"
+};
 
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "OOO",
-                                      &keywords[0],
-                                      &buf_p,
-                                      &data_p,
-                                      &offset_p);
+/* Returns the instruction set with given name, or -1 if unknown. */
+static int isa_from_name(const char *name_p)
+{
+    int i;
 
-    if (res == 0) {
-        return (NULL);
+    for (i = 0; i < (int)(sizeof(isa_names) / sizeof(isa_names[0])); i++) {
+        if (strcmp(name_p, isa_names[i]) == 0) {
+            return (i);
+        }
     }
 
-    return (pack_into_dict(self_p->info_p,
-                           self_p->names_p,
-                           buf_p,
-                           data_p,
-                           offset_p));
+    return (-1);
 }
 
-static PyObject *m_compiled_format_dict_unpack_from(
-    struct compiled_format_dict_t *self_p,
-    PyObject *args_p,
-    PyObject *kwargs_p)
+/* Select the best supported instruction set, unless overridden by the
+   BITSTRUCT_ISA environment variable. */
+static int isa_init(void)
 {
-    PyObject *data_p;
-    PyObject *offset_p;
-    PyObject *allow_truncated_p;
-    int res;
-    static char *keywords[] = {
-        "data",
-        "offset",
-        NULL
-    };
+    const char *name_p;
 
-    offset_p = py_zero_p;
-    allow_truncated_p = py_zero_p;
-    res = PyArg_ParseTupleAndKeywords(args_p,
-                                      kwargs_p,
-                                      "O|OO",
-                                      &keywords[0],
-                                      &data_p,
-                                      &offset_p,
-                                      &allow_truncated_p);
+    name_p = getenv("BITSTRUCT_ISA");
 
-    if (res == 0) {
-        return (NULL);
+    if (name_p != NULL) {
+        if (bitstream_isa_set(isa_from_name(name_p)) == 0) {
+            return (0);
+        }
+
+        if (PyErr_WarnFormat(PyExc_RuntimeWarning,
+                             1,
+                             "Unsupported ISA '%s' in BITSTRUCT_ISA.",
+                             name_p) != 0) {
+            return (-1);
+        }
     }
 
-    return (unpack_from_dict(self_p->info_p,
-                             self_p->names_p,
-                             data_p,
-                             offset_p,
-                             allow_truncated_p));
-}
+    bitstream_isa_set(bitstream_isa_detect());
 
-static PyObject *m_compiled_format_dict_calcsize(
-    struct compiled_format_dict_t *self_p)
-{
-    return (calcsize(self_p->info_p));
+    return (0);
 }
 
-static PyObject *m_compiled_format_dict_copy(struct compiled_format_dict_t *self_p)
+PyDoc_STRVAR(set_isa___doc__,
+             "set_isa(isa)\n"
+             "--\n"
+             "\n"
+             "Select the instruction set of the vectorized kernels, one of\n"
+             "'scalar', 'sse2', 'avx2' and 'avx512'. The best one supported\n"
+             "by the CPU is selected by default.");
+
+static PyObject *m_set_isa(PyObject *module_p, PyObject *isa_p)
 {
-    struct compiled_format_dict_t *new_p;
-    size_t info_size;
+    const char *name_p;
 
-    new_p = (struct compiled_format_dict_t *)compiled_format_dict_new(
-        &compiled_format_dict_type,
-        NULL,
-        NULL);
+    name_p = PyUnicode_AsUTF8(isa_p);
 
-    if (new_p == NULL) {
+    if (name_p == NULL) {
         return (NULL);
     }
 
-    info_size = sizeof(*self_p->info_p);
-    info_size += (sizeof(self_p->info_p->fields[0])
-                  * (self_p->info_p->number_of_fields - 1));
-
-    new_p->info_p = PyMem_RawMalloc(info_size);
+    if (bitstream_isa_set(isa_from_name(name_p)) != 0) {
+        PyErr_Format(PyExc_ValueError, "ISA '%s' not supported.", name_p);
 
-    if (new_p->info_p == NULL) {
-        /* ToDo: Free new_p. */
         return (NULL);
     }
 
-    memcpy(new_p->info_p, self_p->info_p, info_size);
-    Py_INCREF(self_p->names_p);
-    new_p->names_p = self_p->names_p;
-    Py_INCREF(self_p->format_p);
-    new_p->format_p = self_p->format_p;
-
-    return ((PyObject *)new_p);
+    Py_RETURN_NONE;
 }
 
-static PyObject *m_compiled_format_dict_deepcopy(struct compiled_format_dict_t *self_p,
-                                                 PyObject *args_p)
+PyDoc_STRVAR(get_isa___doc__,
+             "get_isa()\n"
+             "--\n"
+             "\n"
+             "Return the instruction set of the vectorized kernels.");
+
+static PyObject *m_get_isa(PyObject *module_p, PyObject *args_p)
 {
-    return (m_compiled_format_dict_copy(self_p));
+    return (PyUnicode_FromString(isa_names[bitstream_isa_get()]));
 }
 
 PyDoc_STRVAR(compile___doc__,
-             "compile(fmt, names=None)\n"
+             "compile(fmt, names=None, raw_as_memoryview=False)\n"
              "--\n"
              "\n");
 
 static PyObject *m_compiled_format_dict_getstate(struct compiled_format_dict_t *self_p,
                                                  PyObject *args_p)
 {
-    return (Py_BuildValue("{sOsOsi}",
-                          "format",
-                          self_p->format_p,
-                          "names",
-                          self_p->names_p,
-                          pickle_version_key,
-                          pickle_version));
+    return (getstate_prefix_code(Py_BuildValue("{sOsOsNsi}",
+                                               "format",
+                                               self_p->format_p,
+                                               "names",
+                                               self_p->names_p,
+                                               "raw_as_memoryview",
+                                               PyBool_FromLong(
+                                                   self_p->info_p->raw_as_memoryview),
+                                               pickle_version_key,
+                                               pickle_version),
+                                 PREFIX_CODE_LOAD(&self_p->prefix_code_p)));
 }
 
 static PyObject *m_compiled_format_dict_setstate(struct compiled_format_dict_t *self_p,
@@ -2471,7 +7357,13 @@ static PyObject *m_compiled_format_dict_setstate(struct compiled_format_dict_t *
         return (NULL);
     }
 
-    Py_RETURN_NONE;
+    if (setstate_raw_as_memoryview(self_p->info_p, state_p) != 0) {
+        return (NULL);
+    }
+
+    return (setstate_prefix_code(self_p->info_p,
+                                 &self_p->prefix_code_p,
+                                 state_p));
 }
 
 static PyObject *m_compile(PyObject *module_p,
@@ -2480,81 +7372,88 @@ static PyObject *m_compile(PyObject *module_p,
 {
     PyObject *format_p;
     PyObject *names_p;
+    PyObject *raw_as_memoryview_p;
     int res;
     static char *keywords[] = {
         "fmt",
         "names",
+        "raw_as_memoryview",
         NULL
     };
 
     names_p = Py_None;
+    raw_as_memoryview_p = Py_False;
     res = PyArg_ParseTupleAndKeywords(args_p,
                                       kwargs_p,
-                                      "O|O",
+                                      "O|OO",
                                       &keywords[0],
                                       &format_p,
-                                      &names_p);
+                                      &names_p,
+                                      &raw_as_memoryview_p);
 
     if (res == 0) {
         return (NULL);
     }
 
     if (names_p == Py_None) {
-        return (compiled_format_create(&compiled_format_type, format_p));
+        return (compiled_format_create(&compiled_format_type,
+                                       format_p,
+                                       raw_as_memoryview_p));
     } else {
         return (compiled_format_dict_create(&compiled_format_dict_type,
                                             format_p,
-                                            names_p));
+                                            names_p,
+                                            raw_as_memoryview_p));
     }
 }
 
 static struct PyMethodDef methods[] = {
     {
         "pack",
-        m_pack,
-        METH_VARARGS,
+        (PyCFunction)m_pack,
+        METH_FASTCALL,
         pack___doc__
     },
     {
         "unpack",
         (PyCFunction)m_unpack,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         unpack___doc__
     },
     {
         "pack_into",
         (PyCFunction)m_pack_into,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         pack_into___doc__
     },
     {
         "unpack_from",
         (PyCFunction)m_unpack_from,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         unpack_from___doc__
     },
     {
         "pack_dict",
-        m_pack_dict,
-        METH_VARARGS,
+        (PyCFunction)m_pack_dict,
+        METH_FASTCALL | METH_KEYWORDS,
         pack_dict___doc__
     },
     {
         "unpack_dict",
         (PyCFunction)m_unpack_dict,
-        METH_VARARGS  | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         unpack_dict___doc__
     },
     {
         "pack_into_dict",
         (PyCFunction)m_pack_into_dict,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         pack_into_dict___doc__
     },
     {
         "unpack_from_dict",
         (PyCFunction)m_unpack_from_dict,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         unpack_from_dict___doc__
     },
     {
@@ -2566,9 +7465,57 @@ static struct PyMethodDef methods[] = {
     {
         "byteswap",
         (PyCFunction)m_byteswap,
-        METH_VARARGS | METH_KEYWORDS,
+        METH_FASTCALL | METH_KEYWORDS,
         byteswap___doc__
     },
+    {
+        "compile_byteswap",
+        m_compile_byteswap,
+        METH_O,
+        compile_byteswap___doc__
+    },
+    {
+        "unpack_array",
+        (PyCFunction)m_unpack_array,
+        METH_FASTCALL | METH_KEYWORDS,
+        unpack_array___doc__
+    },
+    {
+        "pack_array",
+        (PyCFunction)m_pack_array,
+        METH_FASTCALL | METH_KEYWORDS,
+        pack_array___doc__
+    },
+    {
+        "copy_bits",
+        (PyCFunction)m_copy_bits,
+        METH_FASTCALL | METH_KEYWORDS,
+        copy_bits___doc__
+    },
+    {
+        "cache_info",
+        m_cache_info,
+        METH_NOARGS,
+        cache_info___doc__
+    },
+    {
+        "cache_clear",
+        m_cache_clear,
+        METH_NOARGS,
+        cache_clear___doc__
+    },
+    {
+        "set_isa",
+        m_set_isa,
+        METH_O,
+        set_isa___doc__
+    },
+    {
+        "get_isa",
+        m_get_isa,
+        METH_NOARGS,
+        get_isa___doc__
+    },
     {
         "compile",
         (PyCFunction)m_compile,
@@ -2598,6 +7545,14 @@ PyMODINIT_FUNC PyInit_c(void)
         return (NULL);
     }
 
+    if (PyType_Ready(&compiled_byteswap_type) < 0) {
+        return (NULL);
+    }
+
+    if (isa_init() != 0) {
+        return (NULL);
+    }
+
     py_zero_p = PyLong_FromLong(0);
     module_p = PyModule_Create(&module);
 
@@ -2635,5 +7590,16 @@ PyMODINIT_FUNC PyInit_c(void)
         return (NULL);
     }
 
+    Py_INCREF(&compiled_byteswap_type);
+
+    if (PyModule_AddObject(module_p,
+                           "CompiledByteswap",
+                           (PyObject *)&compiled_byteswap_type) < 0) {
+        Py_DECREF(&compiled_byteswap_type);
+        Py_DECREF(module_p);
+
+        return (NULL);
+    }
+
     return (module_p);
 }
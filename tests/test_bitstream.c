@@ -0,0 +1,980 @@
+/**
+ * Unit tests of the bitstream library. Build and run with
+ *
+ *   make test-c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitstream.h"
+
+#define BUFFER_SIZE 256
+
+#define ASSERT(condition)                                               \
+    if (!(condition)) {                                                 \
+        printf("%s:%d: %s: Assertion '%s' failed.\n",                   \
+               __FILE__,                                                \
+               __LINE__,                                                \
+               __func__,                                                \
+               #condition);                                             \
+        exit(1);                                                        \
+    }
+
+static uint64_t random_u64(void)
+{
+    uint64_t value;
+    int i;
+
+    value = 0;
+
+    for (i = 0; i < 4; i++) {
+        value <<= 16;
+        value |= (rand() & 0xffff);
+    }
+
+    return (value);
+}
+
+static void random_fill(uint8_t *buf_p, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++) {
+        buf_p[i] = (uint8_t)rand();
+    }
+}
+
+static int get_bit(const uint8_t *buf_p, int64_t position)
+{
+    return ((buf_p[position / 8] >> (7 - position % 8)) & 1);
+}
+
+static uint64_t mask(int number_of_bits)
+{
+    if (number_of_bits == 64) {
+        return (UINT64_MAX);
+    }
+
+    return ((1ull << number_of_bits) - 1);
+}
+
+/* Compare written bits with the values, most significant bit first,
+   starting at given bit position. */
+static void assert_bits(const uint8_t *buf_p,
+                        int64_t position,
+                        const uint64_t *values_p,
+                        int number_of_values,
+                        int number_of_bits)
+{
+    int i;
+    int j;
+
+    for (i = 0; i < number_of_values; i++) {
+        for (j = number_of_bits - 1; j >= 0; j--) {
+            ASSERT(get_bit(buf_p, position) == (int)((values_p[i] >> j) & 1));
+            position++;
+        }
+    }
+}
+
+static void test_u64_bits(void)
+{
+    uint8_t buf[3][BUFFER_SIZE];
+    uint64_t values[16];
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    int number_of_bits;
+    int offset;
+    int i;
+    int j;
+
+    for (number_of_bits = 1; number_of_bits <= 64; number_of_bits++) {
+        for (offset = 0; offset < 8; offset++) {
+            for (i = 0; i < 16; i++) {
+                values[i] = (random_u64() & mask(number_of_bits));
+            }
+
+            /* Plain, window and inline window writes. */
+            for (j = 0; j < 3; j++) {
+                memset(&buf[j][0], 0, BUFFER_SIZE);
+
+                if (j == 0) {
+                    bitstream_writer_init(&writer, &buf[j][0]);
+                } else {
+                    bitstream_writer_init_window(&writer,
+                                                 &buf[j][0],
+                                                 (offset + 16 * 64 + 7) / 8);
+                }
+
+                bitstream_writer_seek(&writer, offset);
+
+                for (i = 0; i < 16; i++) {
+                    if (j == 2) {
+                        bitstream_writer_write_u64_bits_inline(&writer,
+                                                               values[i],
+                                                               number_of_bits);
+                    } else {
+                        bitstream_writer_write_u64_bits(&writer,
+                                                        values[i],
+                                                        number_of_bits);
+                    }
+                }
+
+                ASSERT(bitstream_writer_size_in_bits(&writer)
+                       == (offset + 16 * number_of_bits));
+                assert_bits(&buf[j][0], offset, &values[0], 16, number_of_bits);
+            }
+
+            ASSERT(memcmp(&buf[0][0], &buf[1][0], BUFFER_SIZE) == 0);
+            ASSERT(memcmp(&buf[0][0], &buf[2][0], BUFFER_SIZE) == 0);
+
+            for (j = 0; j < 3; j++) {
+                if (j == 0) {
+                    bitstream_reader_init(&reader, &buf[0][0]);
+                } else {
+                    bitstream_reader_init_window(&reader,
+                                                 &buf[0][0],
+                                                 (offset + 16 * 64 + 7) / 8);
+                }
+
+                bitstream_reader_seek(&reader, offset);
+
+                for (i = 0; i < 16; i++) {
+                    if (j == 2) {
+                        ASSERT(bitstream_reader_read_u64_bits_inline(
+                                   &reader,
+                                   number_of_bits) == values[i]);
+                    } else {
+                        ASSERT(bitstream_reader_read_u64_bits(
+                                   &reader,
+                                   number_of_bits) == values[i]);
+                    }
+                }
+
+                ASSERT(bitstream_reader_tell(&reader)
+                       == (offset + 16 * number_of_bits));
+            }
+        }
+    }
+}
+
+static void test_u64_bits_le(void)
+{
+    uint8_t buf[2][BUFFER_SIZE];
+    uint64_t values[16];
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    int number_of_bits;
+    int offset;
+    int i;
+    int j;
+
+    for (number_of_bits = 1; number_of_bits <= 64; number_of_bits++) {
+        for (offset = 0; offset < 8; offset++) {
+            for (i = 0; i < 16; i++) {
+                values[i] = (random_u64() & mask(number_of_bits));
+            }
+
+            /* Reversed values written most significant bit first, and
+               window writes with least significant bit first. */
+            memset(&buf[0][0], 0, BUFFER_SIZE);
+            memset(&buf[1][0], 0xff, BUFFER_SIZE);
+            bitstream_writer_init(&writer, &buf[0][0]);
+            bitstream_writer_write_u64_bits(&writer, 0x5a, offset);
+
+            for (i = 0; i < 16; i++) {
+                bitstream_writer_write_u64_bits(
+                    &writer,
+                    bitstream_reverse_u64_bits(values[i], number_of_bits),
+                    number_of_bits);
+            }
+
+            bitstream_writer_init_window(&writer,
+                                         &buf[1][0],
+                                         (offset + 16 * 64 + 7) / 8);
+            bitstream_writer_write_u64_bits(&writer, 0x5a, offset);
+
+            for (i = 0; i < 16; i++) {
+                bitstream_writer_write_u64_bits_le(&writer,
+                                                   values[i],
+                                                   number_of_bits);
+            }
+
+            ASSERT(bitstream_writer_size_in_bits(&writer)
+                   == (offset + 16 * number_of_bits));
+            ASSERT(memcmp(&buf[0][0],
+                          &buf[1][0],
+                          bitstream_writer_size_in_bytes(&writer)) == 0);
+
+            for (j = 0; j < 2; j++) {
+                if (j == 0) {
+                    bitstream_reader_init(&reader, &buf[0][0]);
+                } else {
+                    bitstream_reader_init_window(&reader,
+                                                 &buf[0][0],
+                                                 (offset + 16 * 64 + 7) / 8);
+                }
+
+                bitstream_reader_seek(&reader, offset);
+
+                for (i = 0; i < 16; i++) {
+                    ASSERT(bitstream_reader_read_u64_bits_le(
+                               &reader,
+                               number_of_bits) == values[i]);
+                }
+
+                ASSERT(bitstream_reader_tell(&reader)
+                       == (offset + 16 * number_of_bits));
+            }
+        }
+    }
+}
+
+static void test_bytes(void)
+{
+    uint8_t src[BUFFER_SIZE];
+    uint8_t buf[BUFFER_SIZE];
+    uint8_t dst[BUFFER_SIZE];
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    int isa;
+    int length;
+    int offset;
+    int i;
+
+    random_fill(&src[0], BUFFER_SIZE);
+
+    for (isa = 0; isa <= bitstream_isa_detect(); isa++) {
+        ASSERT(bitstream_isa_set(isa) == 0);
+
+        for (length = 0; length < 200; length++) {
+            for (offset = 0; offset < 8; offset++) {
+                memset(&buf[0], 0, BUFFER_SIZE);
+                bitstream_writer_init(&writer, &buf[0]);
+                bitstream_writer_write_u64_bits(&writer, 0, offset);
+                bitstream_writer_write_bytes(&writer, &src[0], length);
+                bitstream_writer_write_u64_bits(&writer, 1, 1);
+
+                for (i = 0; i < 8 * length; i++) {
+                    ASSERT(get_bit(&buf[0], offset + i) == get_bit(&src[0], i));
+                }
+
+                ASSERT(get_bit(&buf[0], offset + 8 * length) == 1);
+
+                bitstream_reader_init(&reader, &buf[0]);
+                bitstream_reader_seek(&reader, offset);
+                bitstream_reader_read_bytes(&reader, &dst[0], length);
+                ASSERT(memcmp(&dst[0], &src[0], length) == 0);
+                ASSERT(bitstream_reader_read_bit(&reader) == 1);
+            }
+        }
+    }
+
+    ASSERT(bitstream_isa_set(bitstream_isa_detect() + 1) == -1);
+    ASSERT(bitstream_isa_set(bitstream_isa_detect()) == 0);
+}
+
+static void test_repeated_bit(void)
+{
+    uint8_t buf[BUFFER_SIZE];
+    struct bitstream_writer_t writer;
+    int value;
+    int length;
+    int offset;
+    int i;
+
+    for (value = 0; value < 2; value++) {
+        for (length = 0; length < 100; length++) {
+            for (offset = 0; offset < 8; offset++) {
+                memset(&buf[0], 0, BUFFER_SIZE);
+                bitstream_writer_init(&writer, &buf[0]);
+                bitstream_writer_write_repeated_bit(&writer, 1, offset);
+                bitstream_writer_write_repeated_bit(&writer, value, length);
+                bitstream_writer_write_bit(&writer, !value);
+                ASSERT(bitstream_writer_size_in_bits(&writer)
+                       == (offset + length + 1));
+
+                for (i = 0; i < offset; i++) {
+                    ASSERT(get_bit(&buf[0], i) == 1);
+                }
+
+                for (i = 0; i < length; i++) {
+                    ASSERT(get_bit(&buf[0], offset + i) == value);
+                }
+
+                ASSERT(get_bit(&buf[0], offset + length) == !value);
+            }
+        }
+    }
+}
+
+static void test_insert(void)
+{
+    uint8_t buf[4];
+    struct bitstream_writer_t writer;
+
+    memset(&buf[0], 0xff, sizeof(buf));
+    bitstream_writer_init(&writer, &buf[0]);
+    bitstream_writer_seek(&writer, 3);
+    bitstream_writer_insert_u64_bits(&writer, 0, 18);
+    ASSERT(buf[0] == 0xe0);
+    ASSERT(buf[1] == 0x00);
+    ASSERT(buf[2] == 0x07);
+    ASSERT(buf[3] == 0xff);
+}
+
+static void test_array_bits(void)
+{
+    uint8_t buf[BUFFER_SIZE];
+    uint8_t *end_p;
+    int64_t values[100];
+    int64_t read_values[100];
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    int number_of_bits;
+    int is_signed;
+    int isa;
+    int i;
+
+    for (number_of_bits = 1; number_of_bits <= 16; number_of_bits++) {
+        for (is_signed = 0; is_signed < 2; is_signed++) {
+            for (i = 0; i < 100; i++) {
+                values[i] = (int64_t)(random_u64() & mask(number_of_bits));
+
+                if (is_signed) {
+                    values[i] -= (1ll << (number_of_bits - 1));
+                }
+            }
+
+            memset(&buf[0], 0, BUFFER_SIZE);
+            bitstream_writer_init_window(&writer, &buf[0], BUFFER_SIZE);
+            bitstream_writer_seek(&writer, 5);
+            ASSERT(bitstream_writer_write_array_bits(&writer,
+                                                     &values[0],
+                                                     8,
+                                                     1,
+                                                     number_of_bits,
+                                                     is_signed,
+                                                     100) == -1);
+
+            for (isa = 0; isa <= bitstream_isa_detect(); isa++) {
+                ASSERT(bitstream_isa_set(isa) == 0);
+                bitstream_reader_init_window(&reader, &buf[0], BUFFER_SIZE);
+                bitstream_reader_seek(&reader, 5);
+                bitstream_reader_read_array_bits(&reader,
+                                                 &read_values[0],
+                                                 8,
+                                                 number_of_bits,
+                                                 is_signed,
+                                                 100);
+                ASSERT(memcmp(&read_values[0], &values[0], sizeof(values)) == 0);
+                ASSERT(bitstream_reader_tell(&reader)
+                       == (5 + 100 * number_of_bits));
+            }
+        }
+    }
+
+    ASSERT(bitstream_isa_set(bitstream_isa_detect()) == 0);
+
+    /* Out of range. */
+    values[0] = 1;
+    values[1] = 8;
+    bitstream_writer_init(&writer, &buf[0]);
+    ASSERT(bitstream_writer_write_array_bits(&writer,
+                                             &values[0],
+                                             8,
+                                             1,
+                                             3,
+                                             0,
+                                             2) == 1);
+
+    /* Nothing at the end of an exact size buffer. */
+    end_p = malloc(2);
+    ASSERT(end_p != NULL);
+    values[0] = 0x12;
+    values[1] = 0x34;
+    bitstream_writer_init_window(&writer, end_p, 2);
+    ASSERT(bitstream_writer_write_array_bits(&writer,
+                                             &values[0],
+                                             8,
+                                             1,
+                                             8,
+                                             0,
+                                             2) == -1);
+    ASSERT(bitstream_writer_write_array_bits(&writer,
+                                             &values[0],
+                                             8,
+                                             1,
+                                             8,
+                                             0,
+                                             0) == -1);
+    ASSERT(end_p[0] == 0x12);
+    ASSERT(end_p[1] == 0x34);
+    free(end_p);
+}
+
+static void test_reverse(void)
+{
+    uint8_t buf[3] = { 0x01, 0x02, 0x80 };
+
+    ASSERT(bitstream_reverse_u64_bits(0x1, 1) == 0x1);
+    ASSERT(bitstream_reverse_u64_bits(0x1, 4) == 0x8);
+    ASSERT(bitstream_reverse_u64_bits(0x1, 64) == 0x8000000000000000ull);
+    ASSERT(bitstream_reverse_u64_bits(0x123, 12) == 0xc48);
+
+    bitstream_reverse_bytes_bits(&buf[0], 3);
+    ASSERT(buf[0] == 0x01);
+    ASSERT(buf[1] == 0x40);
+    ASSERT(buf[2] == 0x80);
+}
+
+static void test_copy_bits(void)
+{
+    uint8_t src[BUFFER_SIZE];
+    uint8_t dst[BUFFER_SIZE];
+    uint8_t expected[BUFFER_SIZE];
+    int number_of_bits;
+    int src_offset;
+    int dst_offset;
+    int i;
+
+    random_fill(&src[0], BUFFER_SIZE);
+
+    for (number_of_bits = 0; number_of_bits < 8 * 150; number_of_bits += 13) {
+        for (src_offset = 0; src_offset < 16; src_offset += 3) {
+            for (dst_offset = 0; dst_offset < 16; dst_offset += 5) {
+                random_fill(&dst[0], BUFFER_SIZE);
+                memcpy(&expected[0], &dst[0], BUFFER_SIZE);
+
+                for (i = 0; i < number_of_bits; i++) {
+                    expected[(dst_offset + i) / 8] &=
+                        (uint8_t)~(0x80 >> ((dst_offset + i) % 8));
+                    expected[(dst_offset + i) / 8] |=
+                        (uint8_t)(get_bit(&src[0], src_offset + i)
+                                  << (7 - (dst_offset + i) % 8));
+                }
+
+                bitstream_copy_bits(&dst[0],
+                                    dst_offset,
+                                    &src[0],
+                                    src_offset,
+                                    number_of_bits);
+                ASSERT(memcmp(&dst[0], &expected[0], BUFFER_SIZE) == 0);
+            }
+        }
+    }
+}
+
+static void test_byteswap(void)
+{
+    uint8_t src[BUFFER_SIZE];
+    uint8_t dst[BUFFER_SIZE];
+    uint8_t expected[BUFFER_SIZE];
+    int item_size;
+    int count;
+    int isa;
+    int i;
+    int j;
+
+    random_fill(&src[0], BUFFER_SIZE);
+
+    for (isa = 0; isa <= bitstream_isa_detect(); isa++) {
+        ASSERT(bitstream_isa_set(isa) == 0);
+
+        for (item_size = 1; item_size <= 8; item_size *= 2) {
+            for (count = 0; count <= BUFFER_SIZE / item_size; count += 3) {
+                memset(&expected[0], 0xa5, BUFFER_SIZE);
+
+                for (i = 0; i < count; i++) {
+                    for (j = 0; j < item_size; j++) {
+                        expected[item_size * i + j] =
+                            src[item_size * i + item_size - 1 - j];
+                    }
+                }
+
+                memset(&dst[0], 0xa5, BUFFER_SIZE);
+                bitstream_byteswap(&dst[0], &src[0], item_size, count);
+                ASSERT(memcmp(&dst[0], &expected[0], BUFFER_SIZE) == 0);
+
+                /* In place. */
+                memcpy(&dst[0], &src[0], item_size * count);
+                bitstream_byteswap(&dst[0], &dst[0], item_size, count);
+                ASSERT(memcmp(&dst[0], &expected[0], item_size * count) == 0);
+            }
+        }
+    }
+
+    ASSERT(bitstream_isa_set(bitstream_isa_detect()) == 0);
+}
+
+static void test_byteswap_records(void)
+{
+    uint8_t src[BUFFER_SIZE];
+    uint8_t dst[BUFFER_SIZE];
+    uint8_t expected[BUFFER_SIZE];
+    uint8_t mask[BITSTREAM_BYTESWAP_RECORD_MAX_SIZE];
+    int size;
+    int count;
+    int isa;
+    int i;
+    int j;
+
+    random_fill(&src[0], BUFFER_SIZE);
+
+    for (isa = 0; isa <= bitstream_isa_detect(); isa++) {
+        ASSERT(bitstream_isa_set(isa) == 0);
+
+        for (size = 1; size <= BITSTREAM_BYTESWAP_RECORD_MAX_SIZE; size++) {
+            /* Swap the halves of each record and reverse the first. */
+            for (j = 0; j < size; j++) {
+                mask[j] = (uint8_t)((j + size / 2) % size);
+            }
+
+            mask[0] = (uint8_t)(size - 1 - mask[0]);
+
+            for (count = 0; count <= BUFFER_SIZE / size; count += 5) {
+                memset(&expected[0], 0xa5, BUFFER_SIZE);
+
+                for (i = 0; i < count; i++) {
+                    for (j = 0; j < size; j++) {
+                        expected[size * i + j] = src[size * i + mask[j]];
+                    }
+                }
+
+                memset(&dst[0], 0xa5, BUFFER_SIZE);
+                bitstream_byteswap_records(&dst[0],
+                                           &src[0],
+                                           &mask[0],
+                                           size,
+                                           size,
+                                           count);
+                ASSERT(memcmp(&dst[0], &expected[0], BUFFER_SIZE) == 0);
+
+                /* In place. */
+                memcpy(&dst[0], &src[0], size * count);
+                bitstream_byteswap_records(&dst[0],
+                                           &dst[0],
+                                           &mask[0],
+                                           size,
+                                           size,
+                                           count);
+                ASSERT(memcmp(&dst[0], &expected[0], size * count) == 0);
+            }
+
+            /* Every third of records of three times the size, with
+               other bytes left as is. */
+            for (count = 0; count <= BUFFER_SIZE / (3 * size); count += 5) {
+                memcpy(&expected[0], &src[0], BUFFER_SIZE);
+
+                for (i = 0; i < count; i++) {
+                    for (j = 0; j < size; j++) {
+                        expected[3 * size * i + j] = src[3 * size * i + mask[j]];
+                    }
+                }
+
+                memcpy(&dst[0], &src[0], BUFFER_SIZE);
+                bitstream_byteswap_records(&dst[0],
+                                           &dst[0],
+                                           &mask[0],
+                                           size,
+                                           3 * size,
+                                           count);
+                ASSERT(memcmp(&dst[0], &expected[0], BUFFER_SIZE) == 0);
+
+                memcpy(&dst[0], &src[0], BUFFER_SIZE);
+                bitstream_byteswap_records(&dst[0],
+                                           &src[0],
+                                           &mask[0],
+                                           size,
+                                           3 * size,
+                                           count);
+                ASSERT(memcmp(&dst[0], &expected[0], BUFFER_SIZE) == 0);
+            }
+        }
+    }
+
+    ASSERT(bitstream_isa_set(bitstream_isa_detect()) == 0);
+}
+
+static void test_exp_golomb(void)
+{
+    uint8_t buf[BUFFER_SIZE];
+    uint64_t values[] = {
+        0, 1, 2, 3, 6, 7, 255, 0xffffffffull, 0x100000000ull,
+        0x7fffffffffffffffull, UINT64_MAX - 1
+    };
+    int64_t signed_values[] = {
+        0, 1, -1, 2, -2, 1000, -1000, INT64_MAX, -INT64_MAX
+    };
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    uint64_t value;
+    int64_t signed_value;
+    int64_t size;
+    int offset;
+    int i;
+    int j;
+
+    /* Known codes. */
+    memset(&buf[0], 0, sizeof(buf));
+    bitstream_writer_init(&writer, &buf[0]);
+    bitstream_writer_write_exp_golomb(&writer, 0);
+    bitstream_writer_write_exp_golomb(&writer, 1);
+    bitstream_writer_write_exp_golomb(&writer, 7);
+    bitstream_writer_write_exp_golomb_signed(&writer, -2);
+    ASSERT(bitstream_writer_size_in_bits(&writer) == 16);
+    ASSERT(buf[0] == 0xa1);
+    ASSERT(buf[1] == 0x05);
+
+    for (offset = 0; offset < 8; offset++) {
+        for (j = 0; j < 2; j++) {
+            memset(&buf[0], 0xff, sizeof(buf));
+            bitstream_writer_init(&writer, &buf[0]);
+            bitstream_writer_write_u64_bits(&writer, 0, offset);
+            size = offset;
+
+            for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+                bitstream_writer_write_exp_golomb(&writer, values[i]);
+                size += bitstream_exp_golomb_size(values[i]);
+            }
+
+            for (i = 0;
+                 i < (int)(sizeof(signed_values) / sizeof(signed_values[0]));
+                 i++) {
+                bitstream_writer_write_exp_golomb_signed(&writer,
+                                                         signed_values[i]);
+                size += bitstream_exp_golomb_signed_size(signed_values[i]);
+            }
+
+            ASSERT(bitstream_writer_size_in_bits(&writer) == size);
+
+            /* Plain, and window mode of exact size. */
+            if (j == 0) {
+                bitstream_reader_init(&reader, &buf[0]);
+            } else {
+                bitstream_reader_init_window(&reader, &buf[0], (size + 7) / 8);
+            }
+
+            bitstream_reader_seek(&reader, offset);
+
+            for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+                ASSERT(bitstream_reader_read_exp_golomb(&reader, &value) == 0);
+                ASSERT(value == values[i]);
+            }
+
+            for (i = 0;
+                 i < (int)(sizeof(signed_values) / sizeof(signed_values[0]));
+                 i++) {
+                ASSERT(bitstream_reader_read_exp_golomb_signed(
+                           &reader,
+                           &signed_value) == 0);
+                ASSERT(signed_value == signed_values[i]);
+            }
+
+            ASSERT(bitstream_reader_tell(&reader) == size);
+        }
+    }
+
+    /* Short and bad codes leave the position unmodified. */
+    memset(&buf[0], 0, sizeof(buf));
+    buf[2] = 0x01;
+    bitstream_reader_init_window(&reader, &buf[0], 3);
+    bitstream_reader_seek(&reader, 3);
+    ASSERT(bitstream_reader_read_exp_golomb(&reader, &value) == -1);
+    ASSERT(bitstream_reader_tell(&reader) == 3);
+    bitstream_reader_init_window(&reader, &buf[0], 5);
+    bitstream_reader_seek(&reader, 3);
+    ASSERT(bitstream_reader_read_exp_golomb(&reader, &value) == -1);
+    ASSERT(bitstream_reader_tell(&reader) == 3);
+    bitstream_reader_init_window(&reader, &buf[0], 6);
+    bitstream_reader_seek(&reader, 3);
+    ASSERT(bitstream_reader_read_exp_golomb(&reader, &value) == 0);
+    ASSERT(value == 0x100000 - 1);
+    bitstream_reader_init_window(&reader, &buf[0], BUFFER_SIZE);
+    bitstream_reader_seek(&reader, 24);
+    ASSERT(bitstream_reader_read_exp_golomb(&reader, &value) == -2);
+    ASSERT(bitstream_reader_tell(&reader) == 24);
+}
+
+static void test_leb128(void)
+{
+    uint8_t buf[BUFFER_SIZE];
+    uint64_t values[] = {
+        0, 1, 127, 128, 300, 0xffffffffull, 0x00ffffffffffffffull,
+        0x0100000000000000ull, UINT64_MAX
+    };
+    int64_t signed_values[] = {
+        0, 1, -1, 63, 64, -64, -65, 1000, -1000, INT64_MAX, INT64_MIN
+    };
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    uint64_t value;
+    int64_t signed_value;
+    int64_t size;
+    int offset;
+    int i;
+
+    /* Known codes. */
+    memset(&buf[0], 0, sizeof(buf));
+    bitstream_writer_init(&writer, &buf[0]);
+    bitstream_writer_write_leb128(&writer, 624485);
+    bitstream_writer_write_sleb128(&writer, -123456);
+    ASSERT(bitstream_writer_size_in_bits(&writer) == 48);
+    ASSERT(memcmp(&buf[0], "\xe5\x8e\x26\xc0\xbb\x78", 6) == 0);
+
+    for (offset = 0; offset < 8; offset++) {
+        memset(&buf[0], 0xff, sizeof(buf));
+        bitstream_writer_init(&writer, &buf[0]);
+        bitstream_writer_write_u64_bits(&writer, 0, offset);
+        size = offset;
+
+        for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+            bitstream_writer_write_leb128(&writer, values[i]);
+            size += bitstream_leb128_size(values[i]);
+        }
+
+        for (i = 0;
+             i < (int)(sizeof(signed_values) / sizeof(signed_values[0]));
+             i++) {
+            bitstream_writer_write_sleb128(&writer, signed_values[i]);
+            size += bitstream_sleb128_size(signed_values[i]);
+        }
+
+        ASSERT(bitstream_writer_size_in_bits(&writer) == size);
+        bitstream_reader_init_window(&reader, &buf[0], (size + 7) / 8);
+        bitstream_reader_seek(&reader, offset);
+
+        for (i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++) {
+            ASSERT(bitstream_reader_read_leb128(&reader, &value) == 0);
+            ASSERT(value == values[i]);
+        }
+
+        for (i = 0;
+             i < (int)(sizeof(signed_values) / sizeof(signed_values[0]));
+             i++) {
+            ASSERT(bitstream_reader_read_sleb128(&reader, &signed_value) == 0);
+            ASSERT(signed_value == signed_values[i]);
+        }
+
+        ASSERT(bitstream_reader_tell(&reader) == size);
+    }
+
+    /* Short and too long codes leave the position unmodified. */
+    memset(&buf[0], 0x80, sizeof(buf));
+    bitstream_reader_init_window(&reader, &buf[0], 3);
+    ASSERT(bitstream_reader_read_leb128(&reader, &value) == -1);
+    ASSERT(bitstream_reader_tell(&reader) == 0);
+    bitstream_reader_init_window(&reader, &buf[0], BUFFER_SIZE);
+    ASSERT(bitstream_reader_read_leb128(&reader, &value) == -2);
+    ASSERT(bitstream_reader_tell(&reader) == 0);
+    buf[9] = 0x02;
+    ASSERT(bitstream_reader_read_leb128(&reader, &value) == -2);
+    ASSERT(bitstream_reader_read_sleb128(&reader, &signed_value) == -2);
+    buf[9] = 0x7f;
+    ASSERT(bitstream_reader_read_sleb128(&reader, &signed_value) == 0);
+    ASSERT(signed_value == INT64_MIN);
+}
+
+static void test_prefix_code(void)
+{
+    uint8_t buf[BUFFER_SIZE];
+    struct bitstream_prefix_code_entry_t entries[15];
+    struct bitstream_prefix_code_entry_t bad_entries[3];
+    struct bitstream_prefix_code_t code;
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+    uint32_t symbols[128];
+    uint32_t symbols_32[128];
+    uint16_t symbols_16[128];
+    uint32_t symbol;
+    int64_t size;
+    int offset;
+    int i;
+
+    /* Symbol i is i ones and a zero, and the last is 14 ones, longer
+       than the lookup table. */
+    for (i = 0; i < 15; i++) {
+        entries[i].length = (i < 14 ? i + 1 : 14);
+        entries[i].code = (((1u << entries[i].length) - 1)
+                           & (i < 14 ? ~1u : ~0u));
+        entries[i].symbol = (uint32_t)i;
+    }
+
+    ASSERT(bitstream_prefix_code_init(&code, &entries[0], 15) == 0);
+    ASSERT(code.max_length == 14);
+
+    for (offset = 0; offset < 8; offset++) {
+        memset(&buf[0], 0xa5, sizeof(buf));
+        bitstream_writer_init(&writer, &buf[0]);
+        bitstream_writer_write_u64_bits(&writer, 0, offset);
+        size = offset;
+
+        for (i = 0; i < 128; i++) {
+            symbols[i] = (uint32_t)(rand() % 15);
+
+            if (i % 3 != 0) {
+                symbols[i] %= 4;
+            }
+
+            if (symbols[i] < 14) {
+                bitstream_writer_write_u64_bits(&writer,
+                                                (1u << (symbols[i] + 1)) - 2,
+                                                (int)symbols[i] + 1);
+                size += (symbols[i] + 1);
+            } else {
+                bitstream_writer_write_u64_bits(&writer, 0x3fff, 14);
+                size += 14;
+            }
+        }
+
+        bitstream_reader_init_window(&reader, &buf[0], (size + 7) / 8);
+        bitstream_reader_seek(&reader, offset);
+
+        for (i = 0; i < 128; i++) {
+            ASSERT(bitstream_reader_read_prefix_code(&reader,
+                                                     &code,
+                                                     &symbol) == 0);
+            ASSERT(symbol == symbols[i]);
+        }
+
+        ASSERT(bitstream_reader_tell(&reader) == size);
+
+        bitstream_reader_init_window(&reader, &buf[0], (size + 7) / 8);
+        bitstream_reader_seek(&reader, offset);
+        ASSERT(bitstream_reader_read_prefix_codes(&reader,
+                                                  &code,
+                                                  &symbols_16[0],
+                                                  2,
+                                                  128) == 0);
+        ASSERT(bitstream_reader_tell(&reader) == size);
+
+        bitstream_reader_init(&reader, &buf[0]);
+        bitstream_reader_seek(&reader, offset);
+        ASSERT(bitstream_reader_read_prefix_codes(&reader,
+                                                  &code,
+                                                  &symbols_32[0],
+                                                  4,
+                                                  128) == 0);
+        ASSERT(bitstream_reader_tell(&reader) == size);
+
+        for (i = 0; i < 128; i++) {
+            ASSERT(symbols_16[i] == symbols[i]);
+            ASSERT(symbols_32[i] == symbols[i]);
+        }
+    }
+
+    /* Short data leaves the position unmodified. */
+    buf[0] = 0xff;
+    bitstream_reader_init_window(&reader, &buf[0], 1);
+    ASSERT(bitstream_reader_read_prefix_code(&reader, &code, &symbol) == -1);
+    ASSERT(bitstream_reader_tell(&reader) == 0);
+    ASSERT(bitstream_reader_read_prefix_codes(&reader,
+                                              &code,
+                                              &symbols_32[0],
+                                              4,
+                                              1) == -1);
+
+    /* Bits that are not a code. */
+    bad_entries[0].code = 0;
+    bad_entries[0].length = 2;
+    bad_entries[0].symbol = 0;
+    bad_entries[1].code = 1;
+    bad_entries[1].length = 2;
+    bad_entries[1].symbol = 1;
+    bad_entries[2].code = 2;
+    bad_entries[2].length = 2;
+    bad_entries[2].symbol = 2;
+    ASSERT(bitstream_prefix_code_init(&code, &bad_entries[0], 3) == 0);
+    memset(&buf[0], 0, sizeof(buf));
+    buf[2] = 0x30;
+    bitstream_reader_init_window(&reader, &buf[0], BUFFER_SIZE);
+    ASSERT(bitstream_reader_read_prefix_codes(&reader,
+                                              &code,
+                                              &symbols_32[0],
+                                              4,
+                                              20) == -2);
+    ASSERT(bitstream_reader_tell(&reader) == 18);
+    ASSERT(bitstream_reader_read_prefix_code(&reader, &code, &symbol) == -2);
+
+    /* Invalid codes. */
+    bad_entries[2].code = 0;
+    bad_entries[2].length = 1;
+    ASSERT(bitstream_prefix_code_init(&code, &bad_entries[0], 3) == -1);
+    bad_entries[2].code = 2;
+    bad_entries[2].length = 1;
+    ASSERT(bitstream_prefix_code_init(&code, &bad_entries[0], 3) == -1);
+    bad_entries[2].length = 33;
+    ASSERT(bitstream_prefix_code_init(&code, &bad_entries[0], 3) == -1);
+    ASSERT(bitstream_prefix_code_init(&code, &bad_entries[0], 0) == -1);
+}
+
+static void test_checked(void)
+{
+    uint8_t buf[4];
+    uint8_t bytes[4];
+    uint64_t value;
+    struct bitstream_writer_t writer;
+    struct bitstream_reader_t reader;
+
+    memset(&buf[0], 0, sizeof(buf));
+    bitstream_writer_init_window(&writer, &buf[0], sizeof(buf));
+    ASSERT(bitstream_writer_remaining_bits(&writer) == 32);
+    ASSERT(bitstream_writer_check(&writer, 32) == 0);
+    ASSERT(bitstream_writer_check(&writer, 33) == -1);
+    ASSERT(bitstream_writer_check(&writer, -1) == -1);
+    ASSERT(bitstream_writer_write_u64_bits_checked(&writer, 0x5, 3) == 0);
+    ASSERT(bitstream_writer_write_bytes_checked(&writer,
+                                                (const uint8_t *)"\xff\xff\xff\xff",
+                                                4) == -1);
+    ASSERT(bitstream_writer_write_bytes_checked(&writer,
+                                                (const uint8_t *)"\xff\xff\xff",
+                                                3) == 0);
+    ASSERT(bitstream_writer_remaining_bits(&writer) == 5);
+    ASSERT(bitstream_writer_write_u64_bits_checked(&writer, 0, 6) == -1);
+    ASSERT(bitstream_writer_write_u64_bits_checked(&writer, 0x3, 5) == 0);
+    ASSERT(bitstream_writer_remaining_bits(&writer) == 0);
+    ASSERT(buf[0] == 0xbf);
+    ASSERT(buf[1] == 0xff);
+    ASSERT(buf[2] == 0xff);
+    ASSERT(buf[3] == 0xe3);
+
+    bitstream_reader_init_window(&reader, &buf[0], sizeof(buf));
+    ASSERT(bitstream_reader_seek_checked(&reader, -1) == -1);
+    ASSERT(bitstream_reader_seek_checked(&reader, 33) == -1);
+    ASSERT(bitstream_reader_seek_checked(&reader, 3) == 0);
+    ASSERT(bitstream_reader_read_bytes_checked(&reader, &bytes[0], 4) == -1);
+    ASSERT(bitstream_reader_tell(&reader) == 3);
+    ASSERT(bitstream_reader_read_bytes_checked(&reader, &bytes[0], 3) == 0);
+    ASSERT(memcmp(&bytes[0], "\xff\xff\xff", 3) == 0);
+    ASSERT(bitstream_reader_read_u64_bits_checked(&reader, &value, 6) == -1);
+    ASSERT(bitstream_reader_tell(&reader) == 27);
+    ASSERT(bitstream_reader_read_u64_bits_checked(&reader, &value, 5) == 0);
+    ASSERT(value == 0x3);
+    ASSERT(bitstream_reader_remaining_bits(&reader) == 0);
+    ASSERT(bitstream_reader_check(&reader, 0) == 0);
+    ASSERT(bitstream_reader_seek_checked(&reader, -32) == 0);
+    ASSERT(bitstream_reader_check(&reader, 32) == 0);
+}
+
+int main()
+{
+    test_u64_bits();
+    test_u64_bits_le();
+    test_bytes();
+    test_repeated_bit();
+    test_insert();
+    test_array_bits();
+    test_reverse();
+    test_copy_bits();
+    test_byteswap();
+    test_byteswap_records();
+    test_exp_golomb();
+    test_leb128();
+    test_prefix_code();
+    test_checked();
+
+    printf("OK\n");
+
+    return (0);
+}
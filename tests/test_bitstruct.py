@@ -1,4 +1,5 @@
 from __future__ import print_function
+import array
 import sys
 import timeit
 import unittest
@@ -378,6 +379,12 @@ class BitStructTest(unittest.TestCase):
         unpacked = unpack('r24t24<', packed)
         self.assertEqual(unpacked, (b'123', 'abc'))
 
+        # Pack into and unpack from at a bit offset.
+        data = bytearray(b'\xff\xff\xff\xff')
+        pack_into('u3u17<', data, 5, 1, 0x234)
+        self.assertEqual(data, bytearray(b'\xf9\x34\x02\x7f'))
+        self.assertEqual(unpack_from('u3u17<', data, 5), (1, 0x234))
+
     def test_compile(self):
         cf = bitstruct.compile('u1u1s6u7u9')
 
@@ -387,6 +394,140 @@ class BitStructTest(unittest.TestCase):
         unpacked = cf.unpack(b'\x3e\x82\x16')
         self.assertEqual(unpacked, (0, 0, -2, 65, 22))
 
+    def test_unpack_many(self):
+        # Records packed back to back.
+        cf = bitstruct.compile('u4s4')
+        self.assertEqual(cf.unpack_many(b'\x1f\x2e\x30'),
+                         [(1, -1), (2, -2), (3, 0)])
+        self.assertEqual(cf.unpack_many(b'\x1f\x2e\x30', 2),
+                         [(1, -1), (2, -2)])
+        self.assertEqual(cf.unpack_many(b'\x1f\x2e\x30', 0), [])
+
+        cf = bitstruct.compile('u3b1')
+        self.assertEqual(cf.unpack_many(b'\x3d\x70', offset=2),
+                         [(7, True), (2, True), (6, False)])
+
+        # Records placed at a byte stride.
+        cf = bitstruct.compile('u8u4', ['a', 'b'])
+        self.assertEqual(cf.unpack_many(b'\x01\x20\x00\x03\x40', stride=3),
+                         [{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+        self.assertEqual(cf.unpack_many(b'\xff\x01\x20\x00\x03\x40',
+                                        count=1,
+                                        stride=3,
+                                        offset=8),
+                         [{'a': 1, 'b': 2}])
+
+        # Short data.
+        cf = bitstruct.compile('u8u4')
+
+        with self.assertRaises(Error):
+            cf.unpack_many(b'\x01\x20\x00\x03', count=2, stride=3)
+
+        # Stride too small.
+        with self.assertRaises(Error):
+            cf.unpack_many(b'\x01\x20\x00\x03', stride=1)
+
+    def test_unpack_columns(self):
+        cf = bitstruct.compile('u8s4p4f32b1<u7')
+        data = (cf.pack(200, -3, 1.5, True, 5)
+                + cf.pack(1, 2, -2.0, False, 3))
+        columns = cf.unpack_columns(data)
+        self.assertEqual(columns, (array.array('Q', [200, 1]),
+                                   array.array('q', [-3, 2]),
+                                   array.array('d', [1.5, -2.0]),
+                                   array.array('B', [1, 0]),
+                                   array.array('Q', [5, 3])))
+        self.assertEqual(cf.unpack_columns(data, count=1),
+                         (array.array('Q', [200]),
+                          array.array('q', [-3]),
+                          array.array('d', [1.5]),
+                          array.array('B', [1]),
+                          array.array('Q', [5])))
+
+        cf = bitstruct.compile('u4s4', ['a', 'b'])
+        self.assertEqual(cf.unpack_columns(b'\x1f\x00\x2e', stride=2),
+                         {'a': array.array('Q', [1, 2]),
+                           'b': array.array('q', [-1, -2])})
+
+        # Text and raw are not supported.
+        with self.assertRaises(Error):
+            bitstruct.compile('u8r8').unpack_columns(b'\x00\x00')
+
+    def test_pack_many(self):
+        cf = bitstruct.compile('u3s5<u4')
+        records = [(1, -1, 3), (2, 2, 4), [7, 0, 1]]
+        packed = cf.pack_many(records)
+        self.assertEqual(packed, b'\x3f\xc4\x22\xe0\x80')
+        self.assertEqual(cf.unpack_many(packed), [(1, -1, 3), (2, 2, 4), (7, 0, 1)])
+        self.assertEqual(cf.pack_many([]), b'')
+
+        # Records placed at a byte stride.
+        packed = cf.pack_many(records[:2], stride=3)
+        self.assertEqual(packed, b'\x3f\xc0\x00\x42\x20')
+        self.assertEqual(cf.unpack_many(packed, stride=3), [(1, -1, 3), (2, 2, 4)])
+
+        # Pack into a buffer, leaving surrounding bits unmodified.
+        buf = bytearray(6 * b'\xff')
+        cf.pack_many_into(buf, 3, records[:2])
+        self.assertEqual(buf, bytearray(b'\xe7\xf8\x84\x5f\xff\xff'))
+
+        buf = bytearray(6 * b'\xff')
+        cf.pack_many_into(buf, 3, records[:2], stride=2)
+        self.assertEqual(buf, bytearray(b'\xe7\xf9\xe8\x45\xff\xff'))
+
+        with self.assertRaises(Error):
+            cf.pack_many_into(bytearray(2), 0, records[:2])
+
+        # Too few values.
+        with self.assertRaises(Error):
+            cf.pack_many([(1, 2)])
+
+        # Dictionaries.
+        cf = bitstruct.compile('u3p5u4', ['a', 'b'])
+        packed = cf.pack_many([{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+        self.assertEqual(packed, b'\x20\x26\x04')
+        self.assertEqual(cf.unpack_many(packed),
+                         [{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+
+        buf = bytearray(3)
+        cf.pack_many_into(buf, 0, [{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+        self.assertEqual(buf, bytearray(b'\x20\x26\x04'))
+
+    def test_pack_columns(self):
+        cf = bitstruct.compile('u3s5<u4')
+        columns = (array.array('Q', [1, 2, 7]),
+                   array.array('q', [-1, 2, 0]),
+                   [3, 4, 1])
+        self.assertEqual(cf.pack_columns(*columns), b'\x3f\xc4\x22\xe0\x80')
+        self.assertEqual(cf.pack_columns(*columns[:2], columns[2], stride=3),
+                         b'\x3f\xc0\x00\x42\x20\x00\xe0\x80')
+        self.assertEqual(cf.pack_columns([], [], []), b'')
+
+        # Out of range.
+        with self.assertRaises(Error):
+            cf.pack_columns([8], [0], [0])
+
+        # Too few columns.
+        with self.assertRaises(Error):
+            cf.pack_columns([1], [2])
+
+        # Columns of different lengths.
+        with self.assertRaises(Error):
+            cf.pack_columns([1, 2], [2], [3])
+
+        # Text and raw are not supported.
+        with self.assertRaises(Error):
+            bitstruct.compile('u8r8').pack_columns([1], [b'a'])
+
+        # Dictionaries.
+        cf = bitstruct.compile('u3p5f16', ['a', 'b'])
+        packed = cf.pack_columns({'a': array.array('B', [1, 3]),
+                                  'b': array.array('d', [1.5, -2.0])})
+        self.assertEqual(packed, b'\x20\x3e\x00\x60\xc0\x00')
+
+        with self.assertRaises(Error):
+            cf.pack_columns({'a': [1]})
+
     def test_signed_integer(self):
         """Pack and unpack signed integer values.
 
@@ -1,10 +1,12 @@
 from __future__ import print_function
+import array
 import sys
 import timeit
 import pickle
 import unittest
 import platform
 import copy
+import mmap
 
 
 def is_cpython_3():
@@ -293,6 +295,111 @@ class CTest(unittest.TestCase):
         ref = b'\x08\x07\x06\x05\x04\x03\x02\x01'
         self.assertEqual(byteswap('8', ref), res)
 
+        # Only swapped bytes are returned, starting at given offset.
+        self.assertEqual(byteswap('2', b'\x01\x02\x03\x04'), b'\x02\x01')
+        self.assertEqual(byteswap('24', b'\xff\x00\x11\x22\x33\x44\x55', 1),
+                         b'\x11\x00\x55\x44\x33\x22')
+
+        # Any buffer.
+        self.assertEqual(byteswap('4', bytearray(b'\x01\x02\x03\x04')),
+                         b'\x04\x03\x02\x01')
+        self.assertEqual(byteswap('4', memoryview(b'\x00\x01\x02\x03\x04'), 1),
+                         b'\x04\x03\x02\x01')
+        values = array.array('H', [0x0102, 0x0304])
+        self.assertEqual(byteswap('22', values), b'\x01\x02\x03\x04')
+
+        # In place.
+        data = bytearray(b'\xff\x01\x02\x03\x04\xff')
+        self.assertIsNone(byteswap('22', data, 1, inplace=True))
+        self.assertEqual(data, b'\xff\x02\x01\x04\x03\xff')
+        data = bytearray(b'\x01\x02\x03\x04\x05\x06\x07\x08')
+        byteswap('8', memoryview(data), inplace=True)
+        self.assertEqual(data, b'\x08\x07\x06\x05\x04\x03\x02\x01')
+
+        # Long repeated patterns.
+        for size in [1, 2, 4, 8]:
+            data = bytes(range(256)) * 5
+            count = len(data) // size - 1
+            expected = b''.join([data[i:i + size][::-1]
+                                 for i in range(1, 1 + count * size, size)])
+            self.assertEqual(byteswap(str(size) * count, data, 1), expected)
+            swapped = bytearray(data)
+            byteswap(str(size) * count, swapped, 1, inplace=True)
+            self.assertEqual(swapped, data[:1] + expected + data[1 + len(expected):])
+
+        with self.assertRaises(ValueError) as cm:
+            byteswap('2', b'\x00\x00', 1)
+
+        self.assertEqual(str(cm.exception), 'Out of data to swap.')
+
+        with self.assertRaises(ValueError) as cm:
+            byteswap('2', b'\x00\x00', -1)
+
+        self.assertEqual(str(cm.exception), 'Negative offset.')
+
+        with self.assertRaises(BufferError):
+            byteswap('2', b'\x00\x00', inplace=True)
+
+    def test_compile_byteswap(self):
+        """Compiled byte swap.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        cb = bitstruct.c.compile_byteswap('2448')
+        self.assertEqual(cb.calcsize(), 18)
+        data = bytes(range(20))
+        record = (b'\x01\x00\x05\x04\x03\x02\x09\x08\x07\x06'
+                  b'\x11\x10\x0f\x0e\x0d\x0c\x0b\x0a')
+        self.assertEqual(cb.swap(data), record)
+        self.assertEqual(cb.swap(data, 2), byteswap('2448', data, 2))
+
+        buf = bytearray(data)
+        self.assertIsNone(cb.swap_into(buf))
+        self.assertEqual(buf, record + data[18:])
+
+        # Many records of patterns with one or more runs, shorter or
+        # longer than a shuffle.
+        for pattern in ['2448', '44', '8', '1', '242', '2448' * 4, '12' * 5, '']:
+            cb = bitstruct.c.compile_byteswap(pattern)
+            size = cb.calcsize()
+
+            for count in [0, 1, 2, 5, 2000]:
+                data = bytes(range(256)) * ((size * count + 2) // 256 + 1)
+                expected = b''.join([byteswap(pattern, data, 1 + size * i)
+                                     for i in range(count)])
+                self.assertEqual(cb.swap_many(data, count, 1), expected)
+                swapped = bytearray(data)
+                self.assertIsNone(
+                    cb.swap_many(swapped, count, offset=1, inplace=True))
+                self.assertEqual(swapped,
+                                 data[:1] + expected + data[1 + len(expected):])
+
+        cb = bitstruct.c.CompiledByteswap('24')
+        self.assertEqual(cb.swap(b'\x00\x01\x02\x03\x04\x05'),
+                         b'\x01\x00\x05\x04\x03\x02')
+        self.assertEqual(pickle.loads(pickle.dumps(cb)).calcsize(), 6)
+
+        with self.assertRaises(ValueError) as cm:
+            cb.swap_many(b'\x00' * 11, 2)
+
+        self.assertEqual(str(cm.exception), 'Out of data to swap.')
+
+        with self.assertRaises(ValueError) as cm:
+            cb.swap_many(b'', -1)
+
+        self.assertEqual(str(cm.exception), 'Negative count.')
+
+        with self.assertRaises(BufferError):
+            cb.swap_into(b'\x00' * 6)
+
+        with self.assertRaises(ValueError) as cm:
+            bitstruct.c.compile_byteswap('23')
+
+        self.assertEqual(str(cm.exception), 'Expected 1, 2, 4 or 8, but got 3.')
+
     def test_pack_into(self):
         """Pack values into a buffer.
 
@@ -317,15 +424,32 @@ class CTest(unittest.TestCase):
             pack_into('u1', packed, offset, 1)
             self.assertEqual(packed, expected)
 
-        with self.assertRaises(AssertionError):
-            packed = bytearray(b'\xff\xff\xff')
-            pack_into('p4u4p4u4p4u4', packed, 0, 1, 2, 3, fill_padding=False)
-            self.assertEqual(packed, b'\xf1\xf2\xf3')
+        packed = bytearray(b'\xff\xff\xff')
+        pack_into('p4u4p4u4p4u4', packed, 0, 1, 2, 3, fill_padding=False)
+        self.assertEqual(packed, b'\xf1\xf2\xf3')
 
         packed = bytearray(b'\xff\xff\xff')
         pack_into('p4u4p4u4p4u4', packed, 0, 1, 2, 3, fill_padding=True)
         self.assertEqual(packed, b'\x01\x02\x03')
 
+        # Long padding at an unaligned offset.
+        packed = bytearray(130 * b'\xff')
+        pack_into('u3p1024u5', packed, 1, 0, 0)
+        self.assertEqual(packed, b'\x80' + 128 * b'\x00' + b'\x7f')
+
+        packed = bytearray(130 * b'\xff')
+        pack_into('u3p1024u5', packed, 1, 0, 0, fill_padding=False)
+        self.assertEqual(packed, b'\x8f' + 127 * b'\xff' + b'\xf0\x7f')
+
+        packed = bytearray(3)
+        pack_into_dict('u4P12u8',
+                       ['a', 'b'],
+                       packed,
+                       0,
+                       {'a': 1, 'b': 2},
+                       fill_padding=False)
+        self.assertEqual(packed, b'\x10\x00\x02')
+
         packed = bytearray(2)
 
         with self.assertRaises(ValueError) as cm:
@@ -511,6 +635,299 @@ class CTest(unittest.TestCase):
         unpacked = cf.unpack(b'\x3e\x82\x16')
         self.assertEqual(unpacked, (0, 0, -2, 65, 22))
 
+    def test_raw_as_memoryview(self):
+        """Byte aligned raw fields unpacked as memoryviews of the data.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        data = b'\x01\x02\x03\x04\x05\x06\x07'
+        cf = bitstruct.c.compile('u8r16p4r8r16', raw_as_memoryview=True)
+        unpacked = cf.unpack(data)
+        self.assertEqual(unpacked[0], 1)
+        self.assertIsInstance(unpacked[1], memoryview)
+        self.assertIs(unpacked[1].obj, data)
+        self.assertEqual(unpacked[1], b'\x02\x03')
+
+        # Unaligned raw fields are copied.
+        self.assertEqual(unpacked[2:], (b'\x40', b'\x50\x60'))
+
+        unpacked = cf.unpack_from(bytearray(b'\x00' + data), 8)
+        self.assertIsInstance(unpacked[1], memoryview)
+        self.assertEqual(unpacked[1], b'\x02\x03')
+
+        self.assertEqual(cf.unpack(data[:3], allow_truncated=True)[1],
+                         b'\x02\x03')
+
+        unpacked = cf.unpack_many(data + data[:7], 2, stride=7)
+        self.assertEqual([bytes(record[1]) for record in unpacked],
+                         [b'\x02\x03', b'\x02\x03'])
+
+        cf = bitstruct.c.compile('u8r16', ['a', 'b'], raw_as_memoryview=True)
+        unpacked = cf.unpack(data)
+        self.assertIsInstance(unpacked['b'], memoryview)
+        self.assertEqual(unpacked['b'], b'\x02\x03')
+
+        # Any buffer, sliced as bytes.
+        cf = bitstruct.c.CompiledFormat('r16r32', raw_as_memoryview=True)
+        unpacked = cf.unpack(array.array('H', [1, 2, 3]))
+        self.assertEqual(unpacked[1], array.array('H', [2, 3]).tobytes())
+
+        cf = bitstruct.c.CompiledFormatDict('r8', ['a'], raw_as_memoryview=True)
+        self.assertIsInstance(cf.unpack(data)['a'], memoryview)
+
+        # Kept when copied and pickled.
+        cf = bitstruct.c.compile('r8', raw_as_memoryview=True)
+
+        for cf in [copy.copy(cf), pickle.loads(pickle.dumps(cf))]:
+            self.assertIsInstance(cf.unpack(data)[0], memoryview)
+
+        self.assertIsInstance(bitstruct.c.compile('r8').unpack(data)[0], bytes)
+
+        # Partially unpacked fields are released on errors.
+        for raw_as_memoryview in [False, True]:
+            cf = bitstruct.c.compile('r8t8',
+                                     raw_as_memoryview=raw_as_memoryview)
+
+            with self.assertRaises(UnicodeDecodeError):
+                cf.unpack(b'\x01\xff')
+
+    def test_unpack_many(self):
+        if not is_cpython_3():
+            return
+
+        # Records packed back to back.
+        cf = bitstruct.c.compile('u4s4')
+        self.assertEqual(cf.unpack_many(b'\x1f\x2e\x30'),
+                         [(1, -1), (2, -2), (3, 0)])
+        self.assertEqual(cf.unpack_many(b'\x1f\x2e\x30', 2),
+                         [(1, -1), (2, -2)])
+        self.assertEqual(cf.unpack_many(b'\x1f\x2e\x30', 0), [])
+
+        cf = bitstruct.c.compile('u3b1')
+        self.assertEqual(cf.unpack_many(b'\x3d\x70', offset=2),
+                         [(7, True), (2, True), (6, False)])
+
+        # Records placed at a byte stride.
+        cf = bitstruct.c.compile('u8u4', ['a', 'b'])
+        self.assertEqual(cf.unpack_many(b'\x01\x20\x00\x03\x40', stride=3),
+                         [{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+        self.assertEqual(cf.unpack_many(b'\xff\x01\x20\x00\x03\x40',
+                                        count=1,
+                                        stride=3,
+                                        offset=8),
+                         [{'a': 1, 'b': 2}])
+
+        # Short data.
+        cf = bitstruct.c.compile('u8u4')
+
+        with self.assertRaises(ValueError):
+            cf.unpack_many(b'\x01\x20\x00\x03', count=2, stride=3)
+
+        # Stride too small.
+        with self.assertRaises(ValueError):
+            cf.unpack_many(b'\x01\x20\x00\x03', stride=1)
+
+    def test_unpack_columns(self):
+        if not is_cpython_3():
+            return
+
+        cf = bitstruct.c.compile('u8s4p4f32b1<u7')
+        data = (cf.pack(200, -3, 1.5, True, 5)
+                + cf.pack(1, 2, -2.0, False, 3))
+        columns = cf.unpack_columns(data)
+        self.assertEqual(columns, (array.array('Q', [200, 1]),
+                                   array.array('q', [-3, 2]),
+                                   array.array('d', [1.5, -2.0]),
+                                   array.array('B', [1, 0]),
+                                   array.array('Q', [5, 3])))
+        self.assertEqual(cf.unpack_columns(data, count=1),
+                         (array.array('Q', [200]),
+                          array.array('q', [-3]),
+                          array.array('d', [1.5]),
+                          array.array('B', [1]),
+                          array.array('Q', [5])))
+
+        cf = bitstruct.c.compile('u4s4', ['a', 'b'])
+        self.assertEqual(cf.unpack_columns(b'\x1f\x00\x2e', stride=2),
+                         {'a': array.array('Q', [1, 2]),
+                           'b': array.array('q', [-1, -2])})
+
+        # Text and raw are not supported.
+        with self.assertRaises(NotImplementedError):
+            bitstruct.c.compile('u8r8').unpack_columns(b'\x00\x00')
+
+    def test_pack_many(self):
+        if not is_cpython_3():
+            return
+
+        cf = bitstruct.c.compile('u3s5<u4')
+        records = [(1, -1, 3), (2, 2, 4), [7, 0, 1]]
+        packed = cf.pack_many(records)
+        self.assertEqual(packed, b'\x3f\xc4\x22\xe0\x80')
+        self.assertEqual(cf.unpack_many(packed), [(1, -1, 3), (2, 2, 4), (7, 0, 1)])
+        self.assertEqual(cf.pack_many([]), b'')
+
+        # Records placed at a byte stride.
+        packed = cf.pack_many(records[:2], stride=3)
+        self.assertEqual(packed, b'\x3f\xc0\x00\x42\x20')
+        self.assertEqual(cf.unpack_many(packed, stride=3), [(1, -1, 3), (2, 2, 4)])
+
+        # Pack into a buffer, leaving surrounding bits unmodified.
+        buf = bytearray(6 * b'\xff')
+        cf.pack_many_into(buf, 3, records[:2])
+        self.assertEqual(buf, bytearray(b'\xe7\xf8\x84\x5f\xff\xff'))
+
+        buf = bytearray(6 * b'\xff')
+        cf.pack_many_into(buf, 3, records[:2], stride=2)
+        self.assertEqual(buf, bytearray(b'\xe7\xf9\xe8\x45\xff\xff'))
+
+        with self.assertRaises(ValueError):
+            cf.pack_many_into(bytearray(2), 0, records[:2])
+
+        # Too few values.
+        with self.assertRaises(ValueError):
+            cf.pack_many([(1, 2)])
+
+        # Dictionaries.
+        cf = bitstruct.c.compile('u3p5u4', ['a', 'b'])
+        packed = cf.pack_many([{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+        self.assertEqual(packed, b'\x20\x26\x04')
+        self.assertEqual(cf.unpack_many(packed),
+                         [{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+
+        buf = bytearray(3)
+        cf.pack_many_into(buf, 0, [{'a': 1, 'b': 2}, {'a': 3, 'b': 4}])
+        self.assertEqual(buf, bytearray(b'\x20\x26\x04'))
+
+    def test_pack_columns(self):
+        if not is_cpython_3():
+            return
+
+        cf = bitstruct.c.compile('u3s5<u4')
+        columns = (array.array('Q', [1, 2, 7]),
+                   array.array('b', [-1, 2, 0]),
+                   array.array('H', [3, 4, 1]))
+        self.assertEqual(cf.pack_columns(*columns), b'\x3f\xc4\x22\xe0\x80')
+        self.assertEqual(cf.pack_columns(*columns, stride=3),
+                         b'\x3f\xc0\x00\x42\x20\x00\xe0\x80')
+        self.assertEqual(cf.pack_columns(*cf.unpack_columns(b'\x3f\xc4\x22\xe0\x80')),
+                         b'\x3f\xc4\x22\xe0\x80')
+        self.assertEqual(cf.pack_columns(b'', b'', b''), b'')
+
+        # Out of range.
+        with self.assertRaises(OverflowError):
+            cf.pack_columns(array.array('B', [1, 8, 1]), *columns[1:])
+
+        with self.assertRaises(OverflowError):
+            cf.pack_columns(array.array('q', [1, -1, 1]), *columns[1:])
+
+        with self.assertRaises(OverflowError):
+            cf.pack_columns(columns[0], array.array('Q', [0, 16, 0]), columns[2])
+
+        # Too few columns.
+        with self.assertRaises(ValueError):
+            cf.pack_columns(*columns[:2])
+
+        # Columns of different lengths.
+        with self.assertRaises(ValueError):
+            cf.pack_columns(columns[0][:1], *columns[1:])
+
+        # Floats into an integer field.
+        with self.assertRaises(TypeError):
+            cf.pack_columns(array.array('d', [1, 2, 7]), *columns[1:])
+
+        # Text and raw are not supported.
+        with self.assertRaises(NotImplementedError):
+            bitstruct.c.compile('u8r8').pack_columns(b'\x01', b'a')
+
+        # 64 bits limits.
+        cf = bitstruct.c.compile('u64s64')
+        self.assertEqual(cf.pack_columns(array.array('Q', [2 ** 64 - 1]),
+                                         array.array('q', [-2 ** 63])),
+                         b'\xff\xff\xff\xff\xff\xff\xff\xff'
+                         b'\x80\x00\x00\x00\x00\x00\x00\x00')
+
+        with self.assertRaises(OverflowError):
+            cf.pack_columns(array.array('Q', [0]), array.array('Q', [2 ** 63]))
+
+        # Dictionaries.
+        cf = bitstruct.c.compile('u3p5f16', ['a', 'b'])
+        packed = cf.pack_columns({'a': array.array('B', [1, 3]),
+                                  'b': array.array('f', [1.5, -2.0])})
+        self.assertEqual(packed, b'\x20\x3e\x00\x60\xc0\x00')
+
+        with self.assertRaises(KeyError):
+            cf.pack_columns({'a': array.array('B', [1])})
+
+    def test_format_cache(self):
+        if not is_cpython_3():
+            return
+
+        bitstruct.c.cache_clear()
+        self.assertEqual(bitstruct.c.cache_info(), (0, 0, 64, 0))
+
+        packed = bitstruct.c.pack('u1u3u4s16', 1, 2, 3, -4)
+        self.assertEqual(bitstruct.c.unpack('u1u3u4s16', packed), (1, 2, 3, -4))
+        self.assertEqual(bitstruct.c.calcsize(''.join(['u1u3', 'u4s16'])), 24)
+        self.assertEqual(bitstruct.c.cache_info(), (2, 1, 64, 1))
+
+        # Bad formats are not cached.
+        with self.assertRaises(ValueError):
+            bitstruct.c.pack('x1', 1)
+
+        self.assertEqual(bitstruct.c.cache_info(), (2, 2, 64, 1))
+
+        # The least recently used format is evicted when full.
+        for i in range(1, 65):
+            bitstruct.c.pack('s{}'.format(i), 0)
+
+        self.assertEqual(bitstruct.c.cache_info(), (2, 66, 64, 64))
+        self.assertEqual(bitstruct.c.pack('s1', -1), b'\x80')
+        self.assertEqual(bitstruct.c.unpack('u1u3u4s16', packed), (1, 2, 3, -4))
+        self.assertEqual(bitstruct.c.cache_info(), (3, 67, 64, 64))
+
+        bitstruct.c.cache_clear()
+        self.assertEqual(bitstruct.c.cache_info(), (0, 0, 64, 0))
+
+    def test_keyword_arguments(self):
+        if not is_cpython_3():
+            return
+
+        self.assertEqual(bitstruct.c.unpack(fmt='u4u4', data=b'\x12'), (1, 2))
+        self.assertEqual(bitstruct.c.unpack_from('u4', b'\x12', offset=4), (2, ))
+        self.assertEqual(
+            bitstruct.c.unpack_dict('u4u4', ['a', 'b'], data=b'\x12'),
+            {'a': 1, 'b': 2})
+        self.assertEqual(
+            bitstruct.c.pack_dict(fmt='u4u4', names=['a', 'b'], data={'a': 1, 'b': 2}),
+            b'\x12')
+
+        cf = bitstruct.c.compile('u4u4u4')
+        self.assertEqual(cf.unpack(data=b'\x12\x34'), (1, 2, 3))
+        self.assertEqual(cf.unpack_from(b'\x12\x34', 8, allow_truncated=True), (3, 4))
+
+        cf = bitstruct.c.compile('u4u4u4', ['a', 'b', 'c'])
+        self.assertEqual(cf.unpack_from(b'\x12\x34', offset=8, allow_truncated=True),
+                         {'a': 3, 'b': 4})
+        buf = bytearray(2)
+        cf.pack_into(buf, offset=4, data={'a': 1, 'b': 2, 'c': 3})
+        self.assertEqual(buf, bytearray(b'\x01\x23'))
+
+        with self.assertRaises(TypeError):
+            bitstruct.c.unpack('u8')
+
+        with self.assertRaises(TypeError):
+            bitstruct.c.unpack('u8', b'\x01', fmt='u8')
+
+        with self.assertRaises(TypeError):
+            bitstruct.c.unpack('u8', b'\x01', foo=True)
+
+        with self.assertRaises(TypeError):
+            cf.unpack(b'\x01', False, 0)
+
     def test_compile_pack_unpack_formats(self):
         if not is_cpython_3():
             return
@@ -557,6 +974,636 @@ class CTest(unittest.TestCase):
         with self.assertRaises(TypeError):
             bitstruct.c.compile()
 
+    def test_endianness(self):
+        """Test pack/unpack with endianness information in the format string.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        # Big endian.
+        ref = b'\x02\x46\x9a\xfe\x00\x00\x00'
+        packed = pack('>u19s3f32', 0x1234, -2, -1.0)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('>u19s3f32', packed)
+        self.assertEqual(unpacked, (0x1234, -2, -1.0))
+
+        # Little endian.
+        ref = b'\x2c\x48\x0c\x00\x00\x07\xf4'
+        packed = pack('<u19s3f32', 0x1234, -2, -1.0)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('<u19s3f32', packed)
+        self.assertEqual(unpacked, (0x1234, -2, -1.0))
+
+        # Mixed endianness.
+        ref = b'\x00\x00\x2f\x3f\xf0\x00\x00\x00\x00\x00\x00\x80\x00'
+        packed = pack('>u19<s5>f64r8p4', 1, -2, 1.0, b'\x80')
+        self.assertEqual(packed, ref)
+        unpacked = unpack('>u19<s5>f64r8p4', packed)
+        self.assertEqual(unpacked, (1, -2, 1.0, b'\x80'))
+
+        # Opposite endianness of the 'mixed endianness' test.
+        ref = b'\x80\x00\x1e\x00\x00\x00\x00\x00\x00\x0f\xfc\x01\x00'
+        packed = pack('<u19>s5<f64r8p4', 1, -2, 1.0, b'\x80')
+        self.assertEqual(packed, ref)
+        unpacked = unpack('<u19>s5<f64r8p4', packed)
+        self.assertEqual(unpacked, (1, -2, 1.0, b'\x80'))
+
+        # Pack as big endian, unpack as little endian.
+        ref = b'\x40'
+        packed = pack('u2', 1)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('<u2', packed)
+        self.assertEqual(unpacked, (2, ))
+
+        # Text, bool and 16 bits float.
+        ref = b'\x86\xc2\x80\x00\x3c'
+        packed = pack('<t16b1>b1p6f16<', 'Ca', True, False, 1.0)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('<t16b1>b1p6f16<', packed)
+        self.assertEqual(unpacked, ('Ca', True, False, 1.0))
+
+    def test_byte_aligned(self):
+        """Byte aligned fields at aligned and unaligned offsets.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        datas = [
+            ('u8u16u32s16', (1, 0x1234, 0x56789abc, -2)),
+            ('u8u16u32s16<', (1, 0x1234, 0x56789abc, -2)),
+            ('<u16>s64f32b8', (0x1234, -3, 1.5, True)),
+            ('u4u16f64u4<', (1, 0x1234, -2.5, 3))
+        ]
+
+        for fmt, values in datas:
+            packed = bitstruct.pack(fmt, *values)
+            self.assertEqual(pack(fmt, *values), packed)
+            self.assertEqual(unpack(fmt, packed), values)
+
+            for offset in [3, 8]:
+                buf = bytearray(20 * b'\xa5')
+                ref = bytearray(20 * b'\xa5')
+                pack_into(fmt, buf, offset, *values)
+                bitstruct.pack_into(fmt, ref, offset, *values)
+                self.assertEqual(buf, ref)
+                self.assertEqual(unpack_from(fmt, buf, offset), values)
+
+    def test_wide_fields(self):
+        """Wide fields at all bit offsets, both far from and close to the
+        end of the buffer.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        for width in [1, 7, 9, 31, 56, 57, 63, 64]:
+            value = (0x9abcdef012345678 >> (64 - width))
+
+            for offset in range(8):
+                for size in [(offset + width + 7) // 8, 20]:
+                    fmt = 'u{}'.format(width)
+                    buf = bytearray(size * b'\xa5')
+                    ref = bytearray(size * b'\xa5')
+                    pack_into(fmt, buf, offset, value)
+                    bitstruct.pack_into(fmt, ref, offset, value)
+                    self.assertEqual(buf, ref)
+                    self.assertEqual(unpack_from(fmt, buf, offset), (value, ))
+
+                fmt = 'u{}u{}u3'.format(offset + 1, width)
+                self.assertEqual(pack(fmt, 1, value, 5),
+                                 bitstruct.pack(fmt, 1, value, 5))
+
+    def test_large_offset(self):
+        """Unpack from offsets beyond 2 GiB into a memory mapping.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        size = (2 ** 31 + 4096)
+
+        try:
+            data = mmap.mmap(-1, size)
+        except (OSError, OverflowError, ValueError):
+            return
+
+        position = (2 ** 31 + 100)
+        data[position:position + 2] = b'\x12\x34'
+        offset = (8 * position + 4)
+
+        self.assertEqual(unpack_from('u8', data, offset), (0x23, ))
+        self.assertEqual(unpack_from_dict('u8', ['a'], data, offset),
+                         {'a': 0x23})
+        cf = bitstruct.c.compile('u4u8')
+        self.assertEqual(cf.unpack_many(data, count=1, offset=offset - 4),
+                         [(1, 0x23)])
+
+        with self.assertRaises(ValueError) as cm:
+            unpack_from('u8', data, 8 * size - 4)
+
+        self.assertEqual(str(cm.exception), 'Short data.')
+
+        with self.assertRaises(ValueError) as cm:
+            pack_into('u1', bytearray(1), 8 * position, 1)
+
+        self.assertEqual(str(cm.exception),
+                         'pack_into requires a buffer of at least 17179869985 '
+                         'bits')
+
+        data.close()
+
+    def test_unpack_array(self):
+        """Unpack arrays of integers of the same width.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        data = bytes(range(256))
+
+        for width in [1, 5, 12, 16, 17, 25, 26, 32, 33, 56, 57, 64]:
+            for signed in [False, True]:
+                kind = 's' if signed else 'u'
+
+                for count in [0, 1, 7, 8, 9, 31]:
+                    for offset in [0, 3, 8]:
+                        fmt = count * '{}{}'.format(kind, width)
+                        array = unpack_array(width, signed, data, count, offset)
+                        self.assertEqual(array.tolist(),
+                                         list(bitstruct.unpack_from(fmt,
+                                                                    data,
+                                                                    offset)))
+
+        # Array item sizes.
+        self.assertEqual(unpack_array(12, False, data, 1).typecode, 'H')
+        self.assertEqual(unpack_array(17, True, data, 1).typecode, 'i')
+        self.assertEqual(unpack_array(33, False, data, 1).typecode, 'Q')
+
+        # Keyword arguments.
+        array = unpack_array(width=4, signed=True, data=b'\x7f', count=2,
+                             offset=0)
+        self.assertEqual(array.tolist(), [7, -1])
+
+        with self.assertRaises(ValueError) as cm:
+            unpack_array(12, False, b'\x00\x00', 2)
+
+        self.assertEqual(str(cm.exception), 'Short data.')
+
+        with self.assertRaises(ValueError) as cm:
+            unpack_array(65, False, data, 1)
+
+        self.assertEqual(str(cm.exception), 'Width must be 1 to 64 bits.')
+
+        with self.assertRaises(ValueError) as cm:
+            unpack_array(8, False, data, -1)
+
+        self.assertEqual(str(cm.exception), 'Negative count.')
+
+    def test_pack_array(self):
+        """Pack arrays of integers of the same width.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        for width in [1, 5, 12, 16, 17, 32, 33, 63, 64]:
+            for type_code in 'bBhHiIqQ':
+                signed = type_code.islower()
+                kind = 's' if signed else 'u'
+                bits = min(width, 8 * array.array(type_code).itemsize)
+
+                if signed:
+                    values = [-(1 << (bits - 1)), -1, 0, (1 << (bits - 1)) - 1]
+                else:
+                    values = [0, 1, (1 << bits) - 1]
+
+                values = array.array(type_code, 3 * values)
+                fmt = len(values) * '{}{}'.format(kind, width)
+                packed = pack_array(width, signed, values)
+                self.assertEqual(packed, bitstruct.pack(fmt, *values))
+                unpacked = unpack_array(width, signed, packed, len(values))
+                self.assertEqual(unpacked.tolist(), values.tolist())
+
+        self.assertEqual(pack_array(12, False, array.array('H')), b'')
+        self.assertEqual(pack_array(4, False, b'\x01\x02\x03'), b'\x12\x30')
+        self.assertEqual(pack_array(width=2, signed=True, array=bytearray(1)),
+                         b'\x00')
+
+        # Out of range.
+        datas = [
+            (4, False, array.array('B', [1, 16, 2]),
+             'Unsigned integer value 16 out of range.'),
+            (4, False, array.array('b', [1, -1]),
+             'Unsigned integer value -1 out of range.'),
+            (4, True, array.array('h', [-9]),
+             'Signed integer value -9 out of range.'),
+            (16, True, array.array('H', [32768]),
+             'Signed integer value 32768 out of range.')
+        ]
+
+        for width, signed, values, message in datas:
+            with self.assertRaises(OverflowError) as cm:
+                pack_array(width, signed, values)
+
+            self.assertEqual(str(cm.exception), message)
+
+        with self.assertRaises(TypeError) as cm:
+            pack_array(32, False, array.array('f', [1.0]))
+
+        self.assertEqual(str(cm.exception), 'Integer column needed.')
+
+    def test_copy_bits(self):
+        """Copy bits between buffers at bit offsets.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        src = bytes(range(1, 201))
+        src_bits = ''.join('{:08b}'.format(byte) for byte in src)
+
+        for src_offset in [0, 3, 8]:
+            for dst_offset in [0, 5, 16]:
+                for number_of_bits in [0, 1, 7, 8, 9, 100, 1000]:
+                    dst = bytearray(b'\xff' * 200)
+                    copy_bits(dst, dst_offset, src, src_offset, number_of_bits)
+                    expected = (dst_offset * '1'
+                                + src_bits[src_offset:src_offset + number_of_bits])
+                    expected += (1600 - len(expected)) * '1'
+                    expected = int(expected, 2).to_bytes(200, 'big')
+                    self.assertEqual(dst, expected)
+
+        dst = bytearray(2)
+        copy_bits(dst=dst, dst_offset=4, src=b'\xab', src_offset=0,
+                  number_of_bits=8)
+        self.assertEqual(dst, b'\x0a\xb0')
+        copy_bits(memoryview(dst), 0, array.array('B', [0x5f]), 4, 4)
+        self.assertEqual(dst, b'\xfa\xb0')
+
+        # Errors.
+        datas = [
+            ((bytearray(1), 1, b'\x00', 0, 8),
+             'copy_bits requires a buffer of at least 9 bits'),
+            ((bytearray(2), 0, b'\x00', 1, 8), 'Short data.'),
+            ((bytearray(1), 0, b'\x00', 0, -1), 'Negative number of bits.'),
+            ((dst, 0, dst, 4, 8), 'Overlapping buffers.')
+        ]
+
+        for args, message in datas:
+            with self.assertRaises(ValueError) as cm:
+                copy_bits(*args)
+
+            self.assertEqual(str(cm.exception), message)
+
+        copy_bits(dst, 0, dst, 9, 7)
+        self.assertEqual(dst, b'\x60\xb0')
+
+        with self.assertRaises(BufferError):
+            copy_bits(b'\x00', 0, b'\x00', 0, 8)
+
+    def test_variable_length(self):
+        """Pack and unpack Exp-Golomb and LEB128 fields.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        # Known codes.
+        datas = [
+            ('e8', 0, b'\x80'),
+            ('e8', 3, b'\x20'),
+            ('E8', -2, b'\x28'),
+            ('E8', 2, b'\x20'),
+            ('v32', 624485, b'\xe5\x8e\x26'),
+            ('V32', -123456, b'\xc0\xbb\x78'),
+            ('v64', 2 ** 64 - 1, b'\xff' * 9 + b'\x01'),
+            ('V64', -2 ** 63, b'\x80' * 9 + b'\x7f')
+        ]
+
+        for fmt, value, packed in datas:
+            self.assertEqual(pack(fmt, value), packed)
+            self.assertEqual(unpack(fmt, packed), (value, ))
+
+        fmt = 'u3e16p2E16V32s5'
+        values = (5, 1000, -3, -300, -7)
+        packed = pack(fmt, *values)
+        self.assertEqual(packed, b'\xa0\x0f\xa4\x3e\xa3\xee\x40')
+        self.assertEqual(unpack(fmt, packed), values)
+        self.assertEqual(unpack_from('p4' + fmt, b'\x0a' + packed, 4), values)
+        self.assertEqual(unpack(fmt, packed[:4], allow_truncated=True),
+                         (5, 1000, -3))
+        self.assertEqual(compile(fmt).unpack(packed), values)
+
+        names = ['a', 'b', 'c']
+        data = {'a': 1, 'b': 300, 'c': 2}
+        packed = pack_dict('u4v16e4', names, data)
+        self.assertEqual(packed, b'\x1a\xc0\x26')
+        self.assertEqual(unpack_dict('u4v16e4', names, packed), data)
+        self.assertEqual(unpack_dict('u4v16e4',
+                                     names,
+                                     packed[:2],
+                                     allow_truncated=True),
+                         {'a': 1})
+
+        buf = bytearray(b'\xff\xff\xff\xff')
+        pack_into('v16', buf, 4, 200)
+        self.assertEqual(buf, b'\xfc\x80\x1f\xff')
+
+        with self.assertRaises(ValueError) as cm:
+            pack_into('v16', buf, 20, 200)
+
+        self.assertEqual(str(cm.exception),
+                         'pack_into requires a buffer of at least 36 bits')
+
+        # Out of range values.
+        for fmt, value in [('e3', 8), ('E2', 2), ('v7', 128), ('V8', -129)]:
+            with self.assertRaises(OverflowError):
+                pack(fmt, value)
+
+        with self.assertRaises(OverflowError):
+            unpack('e3', b'\x08\x80')
+
+        # The largest and smallest 64 bits values have no 64 bits
+        # Exp-Golomb code.
+        datas = [
+            ('e64', 2 ** 64 - 1, 'Exp-Golomb'),
+            ('E64', -2 ** 63, 'Exp-Golomb'),
+            ('v8', 256, 'LEB128')
+        ]
+
+        for fmt, value, name in datas:
+            with self.assertRaises(OverflowError) as cm:
+                pack(fmt, value)
+
+            self.assertEqual(str(cm.exception),
+                             f'{name} value {value} out of range.')
+
+        self.assertEqual(unpack('e64', pack('e64', 2 ** 64 - 2)),
+                         (2 ** 64 - 2, ))
+        self.assertEqual(unpack('E64', pack('E64', -2 ** 63 + 1)),
+                         (-2 ** 63 + 1, ))
+
+        # Bit and byte order are not part of the codes.
+        datas = [
+            ('<e8', 'Bit order does not apply to variable length fields.'),
+            ('<u3E8', 'Bit order does not apply to variable length fields.'),
+            ('u3v8<', 'Byte order does not apply to variable length fields.'),
+            ('V16<', 'Byte order does not apply to variable length fields.')
+        ]
+
+        for fmt, message in datas:
+            with self.assertRaises(ValueError) as cm:
+                compile(fmt)
+
+            self.assertEqual(str(cm.exception), message)
+
+        self.assertEqual(pack('<u3>e8', 1, 3), b'\x84')
+
+        # Bad and short data.
+        datas = [
+            ('e8', b'\x00', 'Short data.'),
+            ('v8', b'\x80', 'Short data.'),
+            ('e64', 9 * b'\x00', 'Bad Exp-Golomb code.'),
+            ('v64', b'\xff' * 9 + b'\x02', 'Bad LEB128 code.')
+        ]
+
+        for fmt, packed, message in datas:
+            with self.assertRaises(ValueError) as cm:
+                unpack(fmt, packed)
+
+            self.assertEqual(str(cm.exception), message)
+
+        # Not supported.
+        with self.assertRaises(ValueError) as cm:
+            calcsize('v8')
+
+        self.assertEqual(str(cm.exception), 'Variable length format.')
+
+        with self.assertRaises(ValueError) as cm:
+            compile('e8').unpack_many(b'\x80')
+
+        self.assertEqual(str(cm.exception), 'Variable length format.')
+
+        with self.assertRaises(ValueError) as cm:
+            compile('u3e8').unpack_columns(b'\x80')
+
+        self.assertEqual(str(cm.exception), 'Variable length format.')
+
+        with self.assertRaises(ValueError) as cm:
+            compile('u3V8').pack_columns(array.array('B', [1]),
+                                         array.array('b', [1]))
+
+        self.assertEqual(str(cm.exception), 'Variable length format.')
+
+        with self.assertRaises(ValueError) as cm:
+            compile('h8', ['a']).unpack_columns(b'\x80')
+
+        self.assertEqual(str(cm.exception), 'Variable length format.')
+
+        with self.assertRaises(NotImplementedError):
+            pack_into('v8p8', bytearray(2), 0, 1, fill_padding=False)
+
+    def test_prefix_code(self):
+        """Pack and unpack prefix coded symbols.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        codes = ['0', '10', '110', '1110', 14 * '1', 13 * '1' + '0']
+        cf = compile('u4h8u4')
+
+        with self.assertRaises(ValueError) as cm:
+            cf.unpack(b'\x00\x00')
+
+        self.assertEqual(str(cm.exception), 'No prefix code.')
+
+        cf.set_prefix_code(codes)
+        packed = cf.pack(5, 2, 9)
+        self.assertEqual(packed, b'\x5d\x20')
+        self.assertEqual(cf.unpack(packed), (5, 2, 9))
+        self.assertEqual(cf.unpack(cf.pack(1, 4, 2)), (1, 4, 2))
+        self.assertEqual(cf.unpack(b'\x5f', allow_truncated=True), (5, ))
+
+        for other in [copy.copy(cf), pickle.loads(pickle.dumps(cf))]:
+            self.assertEqual(other.unpack(packed), (5, 2, 9))
+
+        symbols = [0, 1, 2, 3, 4, 5, 0, 0, 1]
+        bits = ''.join(codes[symbol] for symbol in symbols)
+        data = int(bits + 6 * '0', 2).to_bytes(6, 'big')
+        self.assertEqual(cf.unpack_symbols(data, 9),
+                         array.array('H', symbols))
+        self.assertEqual(cf.unpack_symbols(b'\x00' + data, count=9, offset=8),
+                         array.array('H', symbols))
+        self.assertEqual(cf.unpack_symbols(data, 0), array.array('H'))
+
+        cfd = compile('h2u3', ['a', 'b'])
+        cfd.set_prefix_code(['1', '01', '001', '000'])
+        compile('h1').set_prefix_code(['0', '1'])
+        packed = cfd.pack({'a': 3, 'b': 5})
+        self.assertEqual(packed, b'\x14')
+        self.assertEqual(cfd.unpack(packed), {'a': 3, 'b': 5})
+        self.assertEqual(pickle.loads(pickle.dumps(cfd)).unpack(packed),
+                         {'a': 3, 'b': 5})
+        self.assertEqual(cfd.unpack_symbols(b'\x4f', 5),
+                         array.array('H', [1, 2, 0, 0, 0]))
+
+        # Errors.
+        datas = [
+            (lambda: cf.pack(0, 6, 0), 'No prefix code for symbol 6.'),
+            (lambda: cf.unpack_symbols(b'\xff', 1), 'Short data.'),
+            (lambda: cf.unpack_symbols(b'\x00', 1, 9), 'Short data.'),
+            (lambda: cf.unpack_symbols(b'\xf0\x00', 1), 'Bad prefix code.'),
+            (lambda: cf.set_prefix_code(['0', '01']), 'Bad prefix code table.'),
+            (lambda: cf.set_prefix_code([]), 'Bad prefix code table.'),
+            (lambda: cf.set_prefix_code(['2']), 'Bad prefix code table.'),
+            (lambda: cf.set_prefix_code([33 * '0']), 'Bad prefix code table.'),
+            (lambda: compile('h8').unpack_symbols(b'\x00', 1),
+             'No prefix code.'),
+            (lambda: cf.set_prefix_code(codes), 'Prefix code already set.'),
+            (lambda: compile('h1').set_prefix_code(['0', '10', '11']),
+             'Too many prefix code symbols.'),
+            (lambda: compile('h2h1').set_prefix_code(['0', '10', '11']),
+             'Too many prefix code symbols.')
+        ]
+
+        for function, message in datas:
+            with self.assertRaises(ValueError) as cm:
+                function()
+
+            self.assertEqual(str(cm.exception), message)
+
+        with self.assertRaises(OverflowError):
+            cfd.pack({'a': 4, 'b': 0})
+
+    def test_set_isa(self):
+        """Test that all supported instruction sets give the same result.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        best = bitstruct.c.get_isa()
+        data = bytes(range(256))
+        expected = [
+            unpack_array(12, True, data, 160, 3),
+            unpack('p3r1000', data),
+            pack('p3r1000', data[:125])
+        ]
+
+        try:
+            for isa in ['scalar', 'sse2', 'avx2', 'avx512']:
+                try:
+                    bitstruct.c.set_isa(isa)
+                except ValueError:
+                    break
+
+                self.assertEqual(bitstruct.c.get_isa(), isa)
+                self.assertEqual([
+                    unpack_array(12, True, data, 160, 3),
+                    unpack('p3r1000', data),
+                    pack('p3r1000', data[:125])
+                ], expected)
+        finally:
+            bitstruct.c.set_isa(best)
+
+        with self.assertRaises(ValueError) as cm:
+            bitstruct.c.set_isa('foo')
+
+        self.assertEqual(str(cm.exception), "ISA 'foo' not supported.")
+
+    def test_byte_order(self):
+        """Test pack/unpack with byte order information in the format string.
+
+        """
+
+        if not is_cpython_3():
+            return
+
+        # Most significant byte first (default).
+        ref = b'\x02\x46\x9a\xfe\x00\x00\x00'
+        packed = pack('u19s3f32>', 0x1234, -2, -1.0)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('u19s3f32>', packed)
+        self.assertEqual(unpacked, (0x1234, -2, -1.0))
+
+        # Least significant byte first.
+        ref = b'\x34\x12\x18\x00\x00\xe0\xbc'
+        packed = pack('u19s3f32<', 0x1234, -2, -1.0)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('u19s3f32<', packed)
+        self.assertEqual(unpacked, (0x1234, -2, -1.0))
+
+        # Least significant byte first.
+        ref = b'\x34\x12'
+        packed = pack('u8s8<', 0x34, 0x12)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('u8s8<', packed)
+        self.assertEqual(unpacked, (0x34, 0x12))
+
+        # Least significant byte first.
+        ref = b'\x34\x22'
+        packed = pack('u3u12<', 1, 0x234)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('u3s12<', packed)
+        self.assertEqual(unpacked, (1, 0x234))
+
+        # Least significant byte first.
+        ref = b'\x34\x11\x00'
+        packed = pack('u3u17<', 1, 0x234)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('u3s17<', packed)
+        self.assertEqual(unpacked, (1, 0x234))
+
+        # Least significant byte first.
+        ref = b'\x80'
+        packed = pack('u1<', 1)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('u1<', packed)
+        self.assertEqual(unpacked, (1, ))
+
+        # Least significant byte first.
+        ref = b'\x45\x23\x25\x82'
+        packed = pack('u19u5u1u7<', 0x12345, 5, 1, 2)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('u19u5u1u7<', packed)
+        self.assertEqual(unpacked, (0x12345, 5, 1, 2))
+
+        # Least significant byte first does not affect raw and text.
+        ref = b'123abc'
+        packed = pack('r24t24<', b'123', 'abc')
+        self.assertEqual(packed, ref)
+        unpacked = unpack('r24t24<', packed)
+        self.assertEqual(unpacked, (b'123', 'abc'))
+
+        # LSB first and least significant byte first.
+        ref = b'\x80\xc4\x20'
+        packed = pack('<u3u17<', 1, 0x234)
+        self.assertEqual(packed, ref)
+        unpacked = unpack('<u3u17<', packed)
+        self.assertEqual(unpacked, (1, 0x234))
+
+        # Pack into and unpack from at a bit offset.
+        data = bytearray(b'\xff\xff\xff\xff')
+        pack_into('u3u17<', data, 5, 1, 0x234)
+        self.assertEqual(data, bytearray(b'\xf9\x34\x02\x7f'))
+        self.assertEqual(unpack_from('u3u17<', data, 5), (1, 0x234))
+
+        self.assertEqual(unpack_from_dict('u3u17<', ['a', 'b'], data, 5),
+                         {'a': 1, 'b': 0x234})
+
     def test_pack_unpack_signed(self):
         if not is_cpython_3():
             return
@@ -680,27 +1727,27 @@ class CTest(unittest.TestCase):
         # Offset too big.
         with self.assertRaises(ValueError) as cm:
             packed = bytearray(1)
-            pack_into('u1', packed, 0x80000000, 1)
+            pack_into('u1', packed, 0x4000000000000000, 1)
 
         self.assertIn("Offset must be less or equal to ", str(cm.exception))
 
         # Offset too big.
         with self.assertRaises(ValueError) as cm:
             packed = bytearray(1)
-            pack_into_dict('u1', ['a'], packed, 0x80000000, {'a': 1})
+            pack_into_dict('u1', ['a'], packed, 0x4000000000000000, {'a': 1})
 
         self.assertIn("Offset must be less or equal to ", str(cm.exception))
 
         # Offset too big.
         with self.assertRaises(ValueError) as cm:
-            unpack_from('u1', b'\x00', 0x80000000)
+            unpack_from('u1', b'\x00', 0x4000000000000000)
 
         self.assertIn("Offset must be less or equal to ", str(cm.exception))
 
         # Offset too big.
         with self.assertRaises(ValueError) as cm:
             packed = bytearray(1)
-            unpack_from_dict('u1', ['a'], b'\x00', 0x80000000)
+            unpack_from_dict('u1', ['a'], b'\x00', 0x4000000000000000)
 
         self.assertIn("Offset must be less or equal to ", str(cm.exception))
 